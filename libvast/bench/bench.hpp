@@ -0,0 +1,109 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+#include "vast/detail/pp.hpp"
+
+namespace vast::bench {
+
+/// The state of a single benchmark.
+class state {
+public:
+  using clock = std::chrono::steady_clock;
+
+  explicit state(size_t iterations) : iterations_{iterations} {
+  }
+
+  /// Runs a function once to warm up and then repeatedly for the configured
+  /// number of iterations, accumulating the elapsed time.
+  /// @param f The function to measure.
+  template <class F>
+  void measure(F f) {
+    f();
+    auto start = clock::now();
+    for (auto i = size_t{0}; i < iterations_; ++i)
+      f();
+    elapsed_ += clock::now() - start;
+  }
+
+  /// Sets the number of items that a single iteration processes.
+  void items(size_t n) {
+    items_ = n;
+  }
+
+  /// Sets the number of bytes that a single iteration processes.
+  void bytes(size_t n) {
+    bytes_ = n;
+  }
+
+  /// Attaches a free-form note to the result, e.g., the size of a data
+  /// structure.
+  void label(std::string x) {
+    label_ = std::move(x);
+  }
+
+  size_t iterations() const {
+    return iterations_;
+  }
+
+  size_t items() const {
+    return items_;
+  }
+
+  size_t bytes() const {
+    return bytes_;
+  }
+
+  clock::duration elapsed() const {
+    return elapsed_;
+  }
+
+  const std::string& label() const {
+    return label_;
+  }
+
+private:
+  size_t iterations_;
+  size_t items_ = 0;
+  size_t bytes_ = 0;
+  clock::duration elapsed_ = clock::duration::zero();
+  std::string label_;
+};
+
+/// A benchmark function.
+using function = void (*)(state&);
+
+/// Registers a benchmark at static initialization time.
+struct registrar {
+  registrar(const char* suite, const char* name, function f);
+};
+
+} // namespace vast::bench
+
+#define VAST_BENCH_STR_IMPL(x) #x
+#define VAST_BENCH_STR(x) VAST_BENCH_STR_IMPL(x)
+
+#define VAST_BENCH_IMPL(name, id)                                              \
+  static void VAST_PP_CAT2(vast_bench_, id)(::vast::bench::state&);            \
+  static ::vast::bench::registrar VAST_PP_CAT2(vast_bench_registrar_, id){    \
+    VAST_BENCH_STR(SUITE), #name, VAST_PP_CAT2(vast_bench_, id)};                              \
+  static void VAST_PP_CAT2(vast_bench_, id)(::vast::bench::state& state)
+
+/// Defines a benchmark. The body has access to a ::vast::bench::state named
+/// `state`.
+#define BENCHMARK(name) VAST_BENCH_IMPL(name, __LINE__)
@@ -0,0 +1,460 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vast/bitmap_algorithms.hpp"
+#include "vast/ewah_bitmap.hpp"
+#include "vast/rank_select_directory.hpp"
+#include "vast/roaring_bitmap.hpp"
+#include "vast/wah_bitmap.hpp"
+
+#define SUITE bitmap
+#include "bench.hpp"
+
+using namespace vast;
+
+namespace {
+
+constexpr size_t num_bits = 1'000'000;
+
+constexpr size_t num_bitmaps = 16;
+
+// Generates a bitmap that alternates between clean runs and runs of random
+// dirty blocks, with *density* controlling the fraction of dirty blocks.
+ewah_bitmap make_bitmap(uint64_t seed, double density) {
+  std::mt19937_64 gen{seed};
+  std::bernoulli_distribution dirty{density};
+  std::geometric_distribution<size_t> run{0.1};
+  ewah_bitmap result;
+  while (result.size() < num_bits) {
+    auto n = 1 + run(gen);
+    if (dirty(gen))
+      for (auto i = 0u; i < n; ++i)
+        result.append_block(gen());
+    else
+      result.append_bits(gen() % 2 == 0, n * ewah_bitmap::word_type::width);
+  }
+  return result;
+}
+
+std::vector<ewah_bitmap> make_bitmaps(double density) {
+  std::vector<ewah_bitmap> result;
+  for (auto i = 0u; i < num_bitmaps; ++i)
+    result.push_back(make_bitmap(i, density));
+  return result;
+}
+
+template <class Operation>
+void binary(bench::state& state, double density, Operation op) {
+  auto x = make_bitmap(1, density);
+  auto y = make_bitmap(2, density);
+  state.items(std::max(x.size(), y.size()));
+  state.measure([&] {
+    auto result = op(x, y);
+    (void)result;
+  });
+}
+
+template <class Operation>
+void ternary(bench::state& state, double density, Operation op) {
+  auto x = make_bitmap(1, density);
+  auto y = make_bitmap(2, density);
+  auto z = make_bitmap(3, density);
+  state.items(std::max(x.size(), z.size()));
+  state.measure([&] {
+    auto result = op(x, y, z);
+    (void)result;
+  });
+}
+
+template <class Operation>
+void nary(bench::state& state, double density, Operation op) {
+  auto xs = make_bitmaps(density);
+  state.items(num_bits * xs.size());
+  state.measure([&] {
+    auto result = op(xs.begin(), xs.end());
+    (void)result;
+  });
+}
+
+auto generic_and = [](auto& x, auto& y) {
+  return binary_and<ewah_bitmap, ewah_bitmap>(x, y);
+};
+
+auto generic_or = [](auto& x, auto& y) {
+  return binary_or<ewah_bitmap, ewah_bitmap>(x, y);
+};
+
+auto generic_nary_and = [](auto begin, auto end) {
+  return nary_eval(begin, end, generic_and);
+};
+
+auto generic_nary_or = [](auto begin, auto end) {
+  return nary_eval(begin, end, generic_or);
+};
+
+auto runs_nary_and = [](auto begin, auto end) {
+  return nary_and(begin, end);
+};
+
+auto runs_nary_or = [](auto begin, auto end) {
+  return nary_or(begin, end);
+};
+
+// -- bitmap types -------------------------------------------------------------
+
+// Sparse hits spread uniformly over the ID space.
+std::vector<uint64_t> sparse_workload() {
+  std::vector<uint64_t> result(num_bits / 64);
+  std::mt19937_64 gen{42};
+  std::uniform_int_distribution<size_t> pos{0, num_bits - 1};
+  for (auto i = 0u; i < num_bits / 1000; ++i) {
+    auto x = pos(gen);
+    result[x / 64] |= uint64_t{1} << (x % 64);
+  }
+  return result;
+}
+
+// Clusters of hits separated by long gaps, as for hits within a partition.
+std::vector<uint64_t> clustered_workload() {
+  auto bm = make_bitmap(42, 0.1);
+  std::vector<uint64_t> result;
+  for (auto& bits : bit_range(bm))
+    if (bits.size() > ewah_bitmap::word_type::width)
+      result.insert(result.end(), bits.size() / 64, bits.data());
+    else
+      result.push_back(bits.data());
+  return result;
+}
+
+// Replays a sequence of blocks, appending homogeneous blocks as runs.
+template <class Bitmap>
+Bitmap replay(const std::vector<uint64_t>& blocks) {
+  using word_type = typename Bitmap::word_type;
+  Bitmap result;
+  for (auto i = 0u; i < blocks.size();) {
+    auto x = blocks[i];
+    auto j = i + 1;
+    if (word_type::all_or_none(x)) {
+      while (j < blocks.size() && blocks[j] == x)
+        ++j;
+      result.append_bits(x != 0, (j - i) * word_type::width);
+    } else {
+      result.append_block(x);
+    }
+    i = j;
+  }
+  return result;
+}
+
+size_t memusage(const ewah_bitmap& bm) {
+  return bm.blocks().size() * sizeof(ewah_bitmap::block_type);
+}
+
+size_t memusage(const wah_bitmap& bm) {
+  return bm.blocks().size() * sizeof(wah_bitmap::block_type);
+}
+
+size_t memusage(const roaring_bitmap& bm) {
+  return bm.memusage();
+}
+
+template <class Bitmap>
+void append(bench::state& state, const std::vector<uint64_t>& workload) {
+  state.items(workload.size() * 64);
+  state.label(std::to_string(memusage(replay<Bitmap>(workload))) + " bytes");
+  state.measure([&] {
+    auto bm = replay<Bitmap>(workload);
+    (void)bm;
+  });
+}
+
+template <class Bitmap, class Operation>
+void combine(bench::state& state, const std::vector<uint64_t>& workload,
+             Operation op) {
+  // Shift the workload against itself to obtain a second operand.
+  auto shifted = workload;
+  std::rotate(shifted.begin(), shifted.begin() + shifted.size() / 3,
+              shifted.end());
+  auto x = replay<Bitmap>(workload);
+  auto y = replay<Bitmap>(shifted);
+  state.items(x.size());
+  state.measure([&] {
+    auto result = op(x, y);
+    (void)result;
+  });
+}
+
+template <class Bitmap>
+void count_ones(bench::state& state, const std::vector<uint64_t>& workload) {
+  auto x = replay<Bitmap>(workload);
+  state.items(x.size());
+  state.measure([&] {
+    auto result = rank<1>(x);
+    (void)result;
+  });
+}
+
+template <class Bitmap>
+void select_middle(bench::state& state, const std::vector<uint64_t>& workload) {
+  auto x = replay<Bitmap>(workload);
+  auto n = rank<1>(x);
+  state.items(x.size());
+  state.measure([&] {
+    auto result = select<1>(x, n / 2);
+    (void)result;
+  });
+}
+
+// Issues a series of rank and select queries, as a pass over the segments of
+// an ID space would.
+template <class Bitmap>
+void probe(bench::state& state, const std::vector<uint64_t>& workload) {
+  auto x = replay<Bitmap>(workload);
+  constexpr size_t num_probes = 100;
+  state.items(num_probes);
+  state.measure([&] {
+    auto result = size_t{0};
+    for (auto i = 0u; i < num_probes; ++i)
+      result += rank<1>(x, x.size() / num_probes * i + 1);
+    (void)result;
+  });
+}
+
+template <class Bitmap>
+void probe_directory(bench::state& state,
+                     const std::vector<uint64_t>& workload) {
+  auto x = replay<Bitmap>(workload);
+  constexpr size_t num_probes = 100;
+  state.items(num_probes);
+  state.measure([&] {
+    // Includes the construction of the directory.
+    rank_select_directory<Bitmap> dir{x};
+    auto result = size_t{0};
+    for (auto i = 0u; i < num_probes; ++i)
+      result += rank(dir, x.size() / num_probes * i + 1);
+    (void)result;
+  });
+}
+
+auto bitwise_and = [](auto& x, auto& y) { return x & y; };
+
+auto bitwise_or = [](auto& x, auto& y) { return x | y; };
+
+} // namespace <anonymous>
+
+BENCHMARK(ewah and generic sparse) {
+  binary(state, 0.1, generic_and);
+}
+
+BENCHMARK(ewah and sparse) {
+  binary(state, 0.1, [](auto& x, auto& y) { return x & y; });
+}
+
+BENCHMARK(ewah and generic dense) {
+  binary(state, 0.9, generic_and);
+}
+
+BENCHMARK(ewah and dense) {
+  binary(state, 0.9, [](auto& x, auto& y) { return x & y; });
+}
+
+BENCHMARK(ewah or generic dense) {
+  binary(state, 0.9, generic_or);
+}
+
+BENCHMARK(ewah or dense) {
+  binary(state, 0.9, [](auto& x, auto& y) { return x | y; });
+}
+
+BENCHMARK(ewah xor dense) {
+  binary(state, 0.9, [](auto& x, auto& y) { return x ^ y; });
+}
+
+BENCHMARK(ewah nand dense) {
+  binary(state, 0.9, [](auto& x, auto& y) { return x - y; });
+}
+
+BENCHMARK(ewah and_not_and composed) {
+  ternary(state, 0.5, [](auto& x, auto& y, auto& z) { return (x - y) & z; });
+}
+
+BENCHMARK(ewah and_not_and generic) {
+  ternary(state, 0.5, [](auto& x, auto& y, auto& z) {
+    auto op = [](auto a, auto b, auto c) { return a & ~b & c; };
+    return fused_eval<ewah_bitmap>(x.size(), op, bit_cursor<ewah_bitmap>{x},
+                                   bit_cursor<ewah_bitmap>{y},
+                                   bit_cursor<ewah_bitmap>{z});
+  });
+}
+
+BENCHMARK(ewah and_not_and) {
+  ternary(state, 0.5, [](auto& x, auto& y, auto& z) {
+    return and_not_and(x, y, z);
+  });
+}
+
+BENCHMARK(ewah nary and pairwise) {
+  nary(state, 0.5, generic_nary_and);
+}
+
+BENCHMARK(ewah nary and) {
+  nary(state, 0.5, runs_nary_and);
+}
+
+BENCHMARK(ewah nary or pairwise) {
+  nary(state, 0.5, generic_nary_or);
+}
+
+BENCHMARK(ewah nary or) {
+  nary(state, 0.5, runs_nary_or);
+}
+
+BENCHMARK(ewah sparse append) {
+  append<ewah_bitmap>(state, sparse_workload());
+}
+
+BENCHMARK(ewah sparse and) {
+  combine<ewah_bitmap>(state, sparse_workload(), bitwise_and);
+}
+
+BENCHMARK(ewah sparse or) {
+  combine<ewah_bitmap>(state, sparse_workload(), bitwise_or);
+}
+
+BENCHMARK(ewah sparse rank) {
+  count_ones<ewah_bitmap>(state, sparse_workload());
+}
+
+BENCHMARK(ewah sparse select) {
+  select_middle<ewah_bitmap>(state, sparse_workload());
+}
+
+BENCHMARK(wah sparse append) {
+  append<wah_bitmap>(state, sparse_workload());
+}
+
+BENCHMARK(wah sparse and) {
+  combine<wah_bitmap>(state, sparse_workload(), bitwise_and);
+}
+
+BENCHMARK(wah sparse or) {
+  combine<wah_bitmap>(state, sparse_workload(), bitwise_or);
+}
+
+BENCHMARK(wah sparse rank) {
+  count_ones<wah_bitmap>(state, sparse_workload());
+}
+
+BENCHMARK(wah sparse select) {
+  select_middle<wah_bitmap>(state, sparse_workload());
+}
+
+BENCHMARK(roaring sparse append) {
+  append<roaring_bitmap>(state, sparse_workload());
+}
+
+BENCHMARK(roaring sparse and) {
+  combine<roaring_bitmap>(state, sparse_workload(), bitwise_and);
+}
+
+BENCHMARK(roaring sparse or) {
+  combine<roaring_bitmap>(state, sparse_workload(), bitwise_or);
+}
+
+BENCHMARK(roaring sparse rank) {
+  count_ones<roaring_bitmap>(state, sparse_workload());
+}
+
+BENCHMARK(roaring sparse select) {
+  select_middle<roaring_bitmap>(state, sparse_workload());
+}
+
+BENCHMARK(ewah clustered append) {
+  append<ewah_bitmap>(state, clustered_workload());
+}
+
+BENCHMARK(ewah clustered and) {
+  combine<ewah_bitmap>(state, clustered_workload(), bitwise_and);
+}
+
+BENCHMARK(ewah clustered or) {
+  combine<ewah_bitmap>(state, clustered_workload(), bitwise_or);
+}
+
+BENCHMARK(ewah clustered rank) {
+  count_ones<ewah_bitmap>(state, clustered_workload());
+}
+
+BENCHMARK(ewah clustered select) {
+  select_middle<ewah_bitmap>(state, clustered_workload());
+}
+
+BENCHMARK(wah clustered append) {
+  append<wah_bitmap>(state, clustered_workload());
+}
+
+BENCHMARK(wah clustered and) {
+  combine<wah_bitmap>(state, clustered_workload(), bitwise_and);
+}
+
+BENCHMARK(wah clustered or) {
+  combine<wah_bitmap>(state, clustered_workload(), bitwise_or);
+}
+
+BENCHMARK(wah clustered rank) {
+  count_ones<wah_bitmap>(state, clustered_workload());
+}
+
+BENCHMARK(wah clustered select) {
+  select_middle<wah_bitmap>(state, clustered_workload());
+}
+
+BENCHMARK(roaring clustered append) {
+  append<roaring_bitmap>(state, clustered_workload());
+}
+
+BENCHMARK(roaring clustered and) {
+  combine<roaring_bitmap>(state, clustered_workload(), bitwise_and);
+}
+
+BENCHMARK(roaring clustered or) {
+  combine<roaring_bitmap>(state, clustered_workload(), bitwise_or);
+}
+
+BENCHMARK(roaring clustered rank) {
+  count_ones<roaring_bitmap>(state, clustered_workload());
+}
+
+BENCHMARK(roaring clustered select) {
+  select_middle<roaring_bitmap>(state, clustered_workload());
+}
+
+BENCHMARK(ewah clustered probe) {
+  probe<ewah_bitmap>(state, clustered_workload());
+}
+
+BENCHMARK(ewah clustered probe directory) {
+  probe_directory<ewah_bitmap>(state, clustered_workload());
+}
+
+BENCHMARK(roaring clustered probe) {
+  probe<roaring_bitmap>(state, clustered_workload());
+}
+
+BENCHMARK(roaring clustered probe directory) {
+  probe_directory<roaring_bitmap>(state, clustered_workload());
+}
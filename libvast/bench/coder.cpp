@@ -0,0 +1,237 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <random>
+#include <vector>
+
+#include "vast/base.hpp"
+#include "vast/coder.hpp"
+#include "vast/ewah_bitmap.hpp"
+#include "vast/wah_bitmap.hpp"
+
+#define SUITE coder
+#include "bench.hpp"
+
+using namespace vast;
+
+namespace {
+
+constexpr size_t num_values = 100'000;
+
+constexpr size_t cardinality = 100;
+
+std::vector<size_t> make_values(size_t max) {
+  std::vector<size_t> result(num_values);
+  std::mt19937_64 gen{42};
+  std::uniform_int_distribution<size_t> dist{0, max - 1};
+  for (auto& x : result)
+    x = dist(gen);
+  return result;
+}
+
+// Timestamps with nanosecond resolution, roughly in order of arrival.
+std::vector<uint64_t> make_timestamps() {
+  std::vector<uint64_t> result(num_values);
+  std::mt19937_64 gen{42};
+  std::uniform_int_distribution<uint64_t> jitter{0, 1'000'000};
+  auto now = uint64_t{1'500'000'000'000'000'000};
+  for (auto& x : result) {
+    now += jitter(gen);
+    x = now;
+  }
+  return result;
+}
+
+template <class Coder>
+void encode(bench::state& state, size_t n, size_t max) {
+  auto xs = make_values(max);
+  state.items(xs.size());
+  state.measure([&] {
+    Coder c{n};
+    for (auto x : xs)
+      c.encode(x);
+  });
+}
+
+template <class Coder>
+void encode_batch(bench::state& state, size_t n, size_t max) {
+  auto xs = make_values(max);
+  state.items(xs.size());
+  state.measure([&] {
+    Coder c{n};
+    c.encode(xs);
+  });
+}
+
+template <class Coder>
+void decode(bench::state& state, size_t n, size_t max,
+            std::initializer_list<relational_operator> ops) {
+  auto xs = make_values(max);
+  Coder c{n};
+  for (auto x : xs)
+    c.encode(x);
+  state.items(xs.size());
+  state.measure([&] {
+    for (auto op : ops)
+      c.decode(op, max / 2);
+  });
+}
+
+template <class Bitmap>
+void encode_timestamps(bench::state& state) {
+  using coder_type = multi_level_coder<range_coder<Bitmap>>;
+  auto xs = make_timestamps();
+  state.items(xs.size());
+  state.measure([&] {
+    coder_type c{base::uniform<64>(10)};
+    for (auto x : xs)
+      c.encode(x);
+  });
+}
+
+template <class Bitmap>
+void encode_timestamps_batch(bench::state& state) {
+  using coder_type = multi_level_coder<range_coder<Bitmap>>;
+  auto xs = make_timestamps();
+  std::vector<typename coder_type::value_type> ys(xs.begin(), xs.end());
+  state.items(ys.size());
+  state.measure([&] {
+    coder_type c{base::uniform<64>(10)};
+    c.encode(ys);
+  });
+}
+
+template <class Bitmap>
+void encode_timestamps_parallel(bench::state& state, size_t threads) {
+  using coder_type = multi_level_coder<range_coder<Bitmap>>;
+  auto xs = make_timestamps();
+  std::vector<typename coder_type::value_type> ys(xs.begin(), xs.end());
+  state.items(ys.size());
+  state.measure([&] {
+    coder_type c{base::uniform<64>(10)};
+    c.encode(ys, 0, threads);
+  });
+}
+
+template <class Bitmap>
+void decode_timestamps(bench::state& state) {
+  using coder_type = multi_level_coder<range_coder<Bitmap>>;
+  auto xs = make_timestamps();
+  coder_type c{base::uniform<64>(10)};
+  for (auto x : xs)
+    c.encode(x);
+  auto pivot = xs[xs.size() / 2];
+  state.items(xs.size());
+  state.measure([&] {
+    for (auto op : {less, equal, greater_equal})
+      c.decode(op, pivot);
+  });
+}
+
+} // namespace <anonymous>
+
+// -- encoding ----------------------------------------------------------------
+
+BENCHMARK(equality encode ewah) {
+  encode<equality_coder<ewah_bitmap>>(state, cardinality, cardinality);
+}
+
+BENCHMARK(equality encode wah) {
+  encode<equality_coder<wah_bitmap>>(state, cardinality, cardinality);
+}
+
+BENCHMARK(range encode ewah) {
+  encode<range_coder<ewah_bitmap>>(state, cardinality - 1, cardinality);
+}
+
+BENCHMARK(range encode wah) {
+  encode<range_coder<wah_bitmap>>(state, cardinality - 1, cardinality);
+}
+
+BENCHMARK(bitslice encode ewah) {
+  encode<bitslice_coder<ewah_bitmap>>(state, 64, cardinality);
+}
+
+BENCHMARK(bitslice encode wah) {
+  encode<bitslice_coder<wah_bitmap>>(state, 64, cardinality);
+}
+
+BENCHMARK(multi-level range encode timestamps ewah) {
+  encode_timestamps<ewah_bitmap>(state);
+}
+
+BENCHMARK(multi-level range encode timestamps wah) {
+  encode_timestamps<wah_bitmap>(state);
+}
+
+// -- batch encoding ----------------------------------------------------------
+
+BENCHMARK(equality batch encode ewah) {
+  encode_batch<equality_coder<ewah_bitmap>>(state, cardinality, cardinality);
+}
+
+BENCHMARK(range batch encode ewah) {
+  encode_batch<range_coder<ewah_bitmap>>(state, cardinality - 1, cardinality);
+}
+
+BENCHMARK(bitslice batch encode ewah) {
+  encode_batch<bitslice_coder<ewah_bitmap>>(state, 64, cardinality);
+}
+
+BENCHMARK(multi-level range batch encode timestamps ewah) {
+  encode_timestamps_batch<ewah_bitmap>(state);
+}
+
+BENCHMARK(multi-level range parallel encode timestamps ewah 4 threads) {
+  encode_timestamps_parallel<ewah_bitmap>(state, 4);
+}
+
+// -- decoding ----------------------------------------------------------------
+
+BENCHMARK(equality decode ewah) {
+  decode<equality_coder<ewah_bitmap>>(state, cardinality, cardinality,
+                                      {equal, less});
+}
+
+BENCHMARK(equality decode wah) {
+  decode<equality_coder<wah_bitmap>>(state, cardinality, cardinality,
+                                     {equal, less});
+}
+
+BENCHMARK(range decode ewah) {
+  decode<range_coder<ewah_bitmap>>(state, cardinality - 1, cardinality,
+                                   {equal, less, greater_equal});
+}
+
+BENCHMARK(range decode wah) {
+  decode<range_coder<wah_bitmap>>(state, cardinality - 1, cardinality,
+                                  {equal, less, greater_equal});
+}
+
+BENCHMARK(bitslice decode ewah) {
+  decode<bitslice_coder<ewah_bitmap>>(state, 64, cardinality,
+                                      {equal, less, greater_equal});
+}
+
+BENCHMARK(bitslice decode wah) {
+  decode<bitslice_coder<wah_bitmap>>(state, 64, cardinality,
+                                     {equal, less, greater_equal});
+}
+
+BENCHMARK(multi-level range decode timestamps ewah) {
+  decode_timestamps<ewah_bitmap>(state);
+}
+
+BENCHMARK(multi-level range decode timestamps wah) {
+  decode_timestamps<wah_bitmap>(state);
+}
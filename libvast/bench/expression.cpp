@@ -0,0 +1,101 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/expression.hpp"
+#include "vast/event.hpp"
+#include "vast/expression.hpp"
+#include "vast/expression_visitors.hpp"
+
+#define SUITE expression
+#include "bench.hpp"
+
+using namespace vast;
+
+namespace {
+
+constexpr size_t num_events = 100'000;
+
+// A filter in the style of a typical candidate check.
+constexpr auto filter
+  = ":addr == 10.0.0.1 && bytes > 1000 || proto == \"udp\"";
+
+type make_type() {
+  type result = record_type{
+    {"ts", timestamp_type{}},
+    {"orig_h", address_type{}},
+    {"orig_p", port_type{}},
+    {"proto", string_type{}},
+    {"bytes", count_type{}}
+  };
+  result.name("conn");
+  return result;
+}
+
+std::vector<event> make_events(const type& t) {
+  std::vector<event> result;
+  result.reserve(num_events);
+  auto now = timestamp{std::chrono::seconds(1'500'000'000)};
+  for (auto i = size_t{0}; i < num_events; ++i) {
+    auto addr = uint32_t{0x0a000000 + static_cast<uint32_t>(i % 256)};
+    auto x = vector{now + std::chrono::milliseconds(i),
+                    address::v4(&addr),
+                    port{static_cast<uint16_t>(i % 65536), port::tcp},
+                    std::string{i % 10 == 0 ? "udp" : "tcp"},
+                    count{i % 2000}};
+    result.push_back(event::make(std::move(x), t));
+  }
+  return result;
+}
+
+expression make_checker(const type& t) {
+  auto expr = to<expression>(filter);
+  return *tailor(*expr, t);
+}
+
+} // namespace <anonymous>
+
+BENCHMARK(event evaluator) {
+  auto t = make_type();
+  auto xs = make_events(t);
+  auto checker = make_checker(t);
+  size_t hits = 0;
+  state.items(xs.size());
+  state.measure([&] {
+    hits = 0;
+    for (auto& x : xs)
+      if (caf::visit(event_evaluator{x}, checker))
+        ++hits;
+  });
+  state.label(std::to_string(hits) + " hits");
+}
+
+BENCHMARK(compiled expression) {
+  auto t = make_type();
+  auto xs = make_events(t);
+  auto f = caf::visit(expression_compiler{t}, make_checker(t));
+  size_t hits = 0;
+  state.items(xs.size());
+  state.measure([&] {
+    hits = 0;
+    for (auto& x : xs)
+      if (f(x))
+        ++hits;
+  });
+  state.label(std::to_string(hits) + " hits");
+}
@@ -0,0 +1,49 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <sstream>
+#include <string>
+
+#include "vast/detail/line_range.hpp"
+
+#define SUITE line_range
+#include "bench.hpp"
+
+using namespace vast;
+
+namespace {
+
+// A line of a Bro conn.log.
+constexpr auto conn_line =
+  "1258531221.486539\tPii6cUUq1v4\t192.168.1.102\t68\t192.168.1.1\t67\tudp\t-"
+  "\t0.163820\t192\t0\tS0\t-\t0\tD\t1\t220\t0\t0\t(empty)\n";
+
+std::string make_log() {
+  std::string result;
+  for (auto i = 0; i < 100'000; ++i)
+    result += conn_line;
+  return result;
+}
+
+} // namespace <anonymous>
+
+BENCHMARK(scan bro log) {
+  auto log = make_log();
+  state.bytes(log.size());
+  state.measure([&] {
+    std::istringstream in{log};
+    detail::line_range lines{in};
+    while (!lines.done())
+      lines.next();
+  });
+}
@@ -0,0 +1,90 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+
+namespace vast::bench {
+namespace {
+
+struct benchmark {
+  std::string suite;
+  std::string name;
+  function run;
+};
+
+std::vector<benchmark>& registry() {
+  static std::vector<benchmark> instance;
+  return instance;
+}
+
+} // namespace <anonymous>
+
+registrar::registrar(const char* suite, const char* name, function f) {
+  registry().push_back({suite, name, f});
+}
+
+} // namespace vast::bench
+
+int main(int argc, char** argv) {
+  using namespace vast::bench;
+  auto usage = [&] {
+    std::cerr << "usage: " << argv[0] << " [-n iterations] [-s suite-regex]"
+              << " [-b benchmark-regex]" << std::endl;
+    return 1;
+  };
+  auto iterations = size_t{10};
+  auto suites = std::regex{".*"};
+  auto names = std::regex{".*"};
+  for (auto i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 == argc)
+      return usage();
+    if (arg == "-n")
+      iterations = std::stoul(argv[++i]);
+    else if (arg == "-s")
+      suites = std::regex{argv[++i]};
+    else if (arg == "-b")
+      names = std::regex{argv[++i]};
+    else
+      return usage();
+  }
+  std::cout << std::left << std::setw(56) << "benchmark"
+            << std::right << std::setw(14) << "ns/iteration"
+            << std::setw(14) << "Mitems/s"
+            << std::setw(12) << "MB/s" << std::endl;
+  for (auto& b : registry()) {
+    if (!std::regex_match(b.suite, suites) || !std::regex_match(b.name, names))
+      continue;
+    state st{iterations};
+    b.run(st);
+    auto ns = std::chrono::duration<double, std::nano>{st.elapsed()}.count();
+    auto per_iteration = ns / st.iterations();
+    auto rate = [&](size_t n) {
+      return n == 0 ? 0.0 : n / per_iteration * 1e3;
+    };
+    std::cout << std::left << std::setw(56) << (b.suite + '/' + b.name)
+              << std::right << std::fixed << std::setprecision(0)
+              << std::setw(14) << per_iteration << std::setprecision(2)
+              << std::setw(14) << rate(st.items())
+              << std::setw(12) << rate(st.bytes());
+    if (!st.label().empty())
+      std::cout << "  " << st.label();
+    std::cout << std::endl;
+  }
+}
@@ -0,0 +1,129 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vast/event.hpp"
+#include "vast/value_index.hpp"
+
+#define SUITE value_index
+#include "bench.hpp"
+
+using namespace vast;
+
+namespace {
+
+constexpr size_t num_events = 100'000;
+
+type make_type() {
+  type result = record_type{
+    {"orig_h", address_type{}},
+    {"orig_p", port_type{}},
+    {"proto", string_type{}},
+    {"bytes", count_type{}}
+  };
+  result.name("conn");
+  return result;
+}
+
+std::vector<event> make_events(const type& t) {
+  std::vector<event> result;
+  result.reserve(num_events);
+  auto now = timestamp{std::chrono::seconds(1'500'000'000)};
+  for (auto i = size_t{0}; i < num_events; ++i) {
+    auto addr = uint32_t{0x0a000000 + static_cast<uint32_t>(i % 256)};
+    auto x = vector{address::v4(&addr),
+                    port{static_cast<uint16_t>(i % 65536), port::tcp},
+                    std::string{i % 10 == 0 ? "udp" : "tcp"},
+                    count{i % 2000}};
+    auto e = event::make(std::move(x), t);
+    e.id(i);
+    e.timestamp(now + std::chrono::milliseconds(i));
+    result.push_back(std::move(e));
+  }
+  return result;
+}
+
+// Performs the work of an event indexer for a batch of events: extracting the
+// indexed aspect of each event and appending it to the time index and to one
+// index per field. With *type_index*, it also maintains the former meta/type
+// index, which holds the type name of every event.
+void ingest(const std::vector<event>& xs, bool type_index) {
+  auto& rec = get<record_type>(xs.front().type());
+  std::vector<std::unique_ptr<value_index>> indexes;
+  std::vector<type> types;
+  types.push_back(timestamp_type{}.attributes({{"sorted"}}));
+  if (type_index)
+    types.push_back(string_type{});
+  auto fields = flatten(rec).fields;
+  for (auto& field : fields)
+    types.push_back(field.type);
+  std::vector<data> batch;
+  batch.reserve(xs.size());
+  auto column = 0u;
+  auto append = [&](auto extract) {
+    auto idx = value_index::make(types[column++]);
+    batch.clear();
+    for (auto& x : xs)
+      batch.push_back(extract(x));
+    idx->append(batch, xs.front().id());
+    indexes.push_back(std::move(idx));
+  };
+  append([](const event& x) -> data { return x.timestamp(); });
+  if (type_index)
+    append([](const event& x) -> data { return x.type().name(); });
+  for (auto i = 0u; i < fields.size(); ++i)
+    append([&](const event& x) -> data {
+      return get<vector>(x.data())[i];
+    });
+}
+
+std::vector<data> make_timestamps() {
+  std::vector<data> result;
+  result.reserve(num_events);
+  auto now = timestamp{std::chrono::seconds(1'500'000'000)};
+  for (auto i = size_t{0}; i < num_events; ++i)
+    result.emplace_back(now + std::chrono::milliseconds(i));
+  return result;
+}
+
+} // namespace <anonymous>
+
+// Indexing without the meta/type index, as event indexers do now.
+BENCHMARK(event ingest) {
+  auto xs = make_events(make_type());
+  state.items(xs.size());
+  state.measure([&] { ingest(xs, false); });
+}
+
+// Indexing with the meta/type index, as event indexers used to.
+BENCHMARK(event ingest with type index) {
+  auto xs = make_events(make_type());
+  state.items(xs.size());
+  state.measure([&] { ingest(xs, true); });
+}
+
+// The synthetic answer to a type predicate that replaces the type index: all
+// IDs with a timestamp.
+BENCHMARK(time index all ids) {
+  auto idx = value_index::make(timestamp_type{}.attributes({{"sorted"}}));
+  idx->append(make_timestamps(), 0);
+  state.items(num_events);
+  state.measure([&] {
+    idx->lookup(not_equal, nil);
+  });
+}
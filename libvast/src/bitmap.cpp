@@ -84,4 +84,58 @@ bitmap_bit_range bit_range(const bitmap& bm) {
   return bitmap_bit_range{bm};
 }
 
+namespace {
+
+// Applies a specialized algorithm if both bitmaps are of a concrete type that
+// provides one, and the generic algorithm otherwise.
+template <class Specialized, class Generic>
+bitmap dispatch(const bitmap& lhs, const bitmap& rhs, Specialized specialized,
+                Generic generic) {
+  if (auto x = detail::ewah_cast(lhs))
+    if (auto y = detail::ewah_cast(rhs))
+      return specialized(*x, *y);
+  if (auto x = caf::get_if<roaring_bitmap>(&lhs.get_data()))
+    if (auto y = caf::get_if<roaring_bitmap>(&rhs.get_data()))
+      return specialized(*x, *y);
+  return generic(lhs, rhs);
+}
+
+} // namespace <anonymous>
+
+bitmap binary_and(const bitmap& lhs, const bitmap& rhs) {
+  return dispatch(
+    lhs, rhs,
+    [](auto& x, auto& y) { return bitmap{binary_and(x, y)}; },
+    [](auto& x, auto& y) { return binary_and<bitmap, bitmap>(x, y); });
+}
+
+bitmap binary_or(const bitmap& lhs, const bitmap& rhs) {
+  return dispatch(
+    lhs, rhs,
+    [](auto& x, auto& y) { return bitmap{binary_or(x, y)}; },
+    [](auto& x, auto& y) { return binary_or<bitmap, bitmap>(x, y); });
+}
+
+bitmap binary_xor(const bitmap& lhs, const bitmap& rhs) {
+  return dispatch(
+    lhs, rhs,
+    [](auto& x, auto& y) { return bitmap{binary_xor(x, y)}; },
+    [](auto& x, auto& y) { return binary_xor<bitmap, bitmap>(x, y); });
+}
+
+bitmap binary_nand(const bitmap& lhs, const bitmap& rhs) {
+  return dispatch(
+    lhs, rhs,
+    [](auto& x, auto& y) { return bitmap{binary_nand(x, y)}; },
+    [](auto& x, auto& y) { return binary_nand<bitmap, bitmap>(x, y); });
+}
+
+namespace detail {
+
+const ewah_bitmap* ewah_cast(const bitmap& bm) {
+  return caf::get_if<ewah_bitmap>(&bm.get_data());
+}
+
+} // namespace detail
+
 } // namespace vast
@@ -0,0 +1,218 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <limits>
+
+#include "vast/bitmap_evaluator.hpp"
+#include "vast/detail/assert.hpp"
+#include "vast/detail/simd.hpp"
+
+namespace vast {
+
+bitmap_evaluator::node_id bitmap_evaluator::add_leaf(const ewah_bitmap& bm) {
+  auto i = leaves_.find(&bm);
+  if (i != leaves_.end())
+    return i->second;
+  auto id = add({kind::leaf, bm.size(), {}, &bm});
+  leaves_.emplace(&bm, id);
+  return id;
+}
+
+bitmap_evaluator::node_id bitmap_evaluator::add_leaf(const bitmap& bm) {
+  if (auto x = detail::ewah_cast(bm))
+    return add_leaf(*x);
+  copies_.emplace_back();
+  copies_.back().append(bm);
+  return add_leaf(copies_.back());
+}
+
+bitmap_evaluator::node_id bitmap_evaluator::add_negation(node_id x) {
+  VAST_ASSERT(x < nodes_.size());
+  return add({kind::negation, nodes_[x].size, {x}, nullptr});
+}
+
+bitmap_evaluator::node_id
+bitmap_evaluator::add_conjunction(std::vector<node_id> xs) {
+  VAST_ASSERT(!xs.empty());
+  size_type size = 0;
+  for (auto x : xs)
+    size = std::max(size, this->size(x));
+  return add({kind::conjunction, size, std::move(xs), nullptr});
+}
+
+bitmap_evaluator::node_id
+bitmap_evaluator::add_disjunction(std::vector<node_id> xs) {
+  VAST_ASSERT(!xs.empty());
+  size_type size = 0;
+  for (auto x : xs)
+    size = std::max(size, this->size(x));
+  return add({kind::disjunction, size, std::move(xs), nullptr});
+}
+
+bitmap_evaluator::size_type bitmap_evaluator::size(node_id x) const {
+  VAST_ASSERT(x < nodes_.size());
+  return nodes_[x].size;
+}
+
+ewah_bitmap bitmap_evaluator::evaluate(node_id root) const {
+  VAST_ASSERT(root < nodes_.size());
+  ewah_bitmap result;
+  auto n = nodes_[root].size;
+  if (n == 0)
+    return result;
+  // Operands always precede their operators, so ascending IDs form a
+  // topological order. We only consider the nodes reachable from the root.
+  std::vector<bool> reachable(root + 1, false);
+  reachable[root] = true;
+  for (auto i = root + 1; i-- > 0; )
+    if (reachable[i])
+      for (auto x : nodes_[i].operands)
+        reachable[x] = true;
+  std::vector<node_id> order;
+  for (node_id i = 0; i <= root; ++i)
+    if (reachable[i])
+      order.push_back(i);
+  // The evaluation state per node for the current chunk of words, which is
+  // either a clean word or a pointer to dirty words.
+  struct value {
+    const block_type* data;
+    block_type fill;
+  };
+  std::vector<value> values(root + 1);
+  std::vector<std::vector<block_type>> buffers(root + 1);
+  std::vector<bit_cursor<ewah_bitmap>> cursors;
+  std::vector<size_t> cursor_index(root + 1);
+  // A chunk never spans a word where a negation or the result ends, such that
+  // those words with partial contents form a chunk on their own.
+  std::vector<size_type> breaks;
+  auto add_break = [&](size_type bits) {
+    breaks.push_back(bits / word_type::width);
+    if (bits % word_type::width != 0)
+      breaks.push_back(bits / word_type::width + 1);
+  };
+  add_break(n);
+  for (auto i : order) {
+    auto& x = nodes_[i];
+    if (x.type == kind::leaf) {
+      cursor_index[i] = cursors.size();
+      cursors.emplace_back(*x.leaf);
+    } else if (x.type == kind::negation) {
+      add_break(x.size);
+    }
+  }
+  std::sort(breaks.begin(), breaks.end());
+  auto next_break = breaks.begin();
+  auto words = (n + word_type::width - 1) / word_type::width;
+  size_type w = 0;
+  while (w < words) {
+    while (*next_break <= w)
+      ++next_break;
+    VAST_ASSERT(next_break != breaks.end());
+    auto k = std::min(chunk_words, *next_break - w);
+    for (auto& c : cursors)
+      k = std::min(k, c.words());
+    for (auto i : order) {
+      auto& x = nodes_[i];
+      auto& v = values[i];
+      auto& buffer = buffers[i];
+      switch (x.type) {
+        case kind::leaf: {
+          auto& c = cursors[cursor_index[i]];
+          v = c.clean() ? value{nullptr, c.block()} : value{c.dirty(), 0};
+          break;
+        }
+        case kind::negation: {
+          auto first = w * word_type::width;
+          auto& y = values[x.operands[0]];
+          if (first >= x.size) {
+            v = {nullptr, word_type::none};
+          } else if (first + word_type::width > x.size) {
+            VAST_ASSERT(k == 1);
+            auto block = y.data ? *y.data : y.fill;
+            buffer.resize(1);
+            buffer[0] = ~block & word_type::lsb_fill(x.size - first);
+            v = {buffer.data(), 0};
+          } else if (!y.data) {
+            v = {nullptr, ~y.fill};
+          } else {
+            buffer.resize(k);
+            std::transform(y.data, y.data + k, buffer.begin(),
+                           [](auto b) { return ~b; });
+            v = {buffer.data(), 0};
+          }
+          break;
+        }
+        case kind::conjunction: {
+          // Clean runs of 1s are neutral and clean runs of 0s absorbing.
+          v = {nullptr, word_type::all};
+          for (auto op : x.operands) {
+            auto& y = values[op];
+            if (!y.data) {
+              if (y.fill == word_type::none) {
+                v = {nullptr, word_type::none};
+                break;
+              }
+            } else if (!v.data) {
+              v = y;
+            } else {
+              buffer.resize(k);
+              detail::block_and(v.data, y.data, buffer.data(), k);
+              v = {buffer.data(), 0};
+            }
+          }
+          break;
+        }
+        case kind::disjunction: {
+          // Clean runs of 0s are neutral and clean runs of 1s absorbing.
+          v = {nullptr, word_type::none};
+          for (auto op : x.operands) {
+            auto& y = values[op];
+            if (!y.data) {
+              if (y.fill == word_type::all) {
+                v = {nullptr, word_type::all};
+                break;
+              }
+            } else if (!v.data) {
+              v = y;
+            } else {
+              buffer.resize(k);
+              detail::block_or(v.data, y.data, buffer.data(), k);
+              v = {buffer.data(), 0};
+            }
+          }
+          break;
+        }
+      }
+    }
+    auto& r = values[root];
+    if ((w + k) * word_type::width > n)
+      result.append_block(r.data ? *r.data : r.fill, n - result.size());
+    else if (r.data)
+      result.append_blocks(r.data, r.data + k);
+    else
+      result.append_bits(r.fill != word_type::none, k * word_type::width);
+    for (auto& c : cursors)
+      c.skip(k);
+    w += k;
+  }
+  return result;
+}
+
+bitmap_evaluator::node_id bitmap_evaluator::add(node x) {
+  VAST_ASSERT(nodes_.size() < std::numeric_limits<node_id>::max());
+  nodes_.push_back(std::move(x));
+  return static_cast<node_id>(nodes_.size() - 1);
+}
+
+} // namespace vast
@@ -11,42 +11,84 @@
  * contained in the LICENSE file.                                             *
  ******************************************************************************/
 
+#include <algorithm>
+#include <cstring>
+
 #include "vast/detail/assert.hpp"
 #include "vast/detail/line_range.hpp"
 
 namespace vast {
 namespace detail {
 
-line_range::line_range(std::istream& input) : input_{input} {
+line_range::line_range(std::istream& input, size_t block_size)
+  : input_{input},
+    buffer_(block_size) {
+  VAST_ASSERT(block_size > 0);
   next(); // prime the pump
 }
 
-const std::string& line_range::get() const {
+std::string_view line_range::get() const {
   return line_;
 }
 
 void line_range::next() {
   VAST_ASSERT(!done());
-  line_.clear();
-  // Get the next non-empty line.
-  while (line_.empty())
-    if (std::getline(input_, line_))
+  line_ = {};
+  // Get the next non-empty line. The newline search uses memchr, which the C
+  // library implements with vector instructions.
+  while (line_.empty()) {
+    auto first = buffer_.data() + pos_;
+    auto size = end_ - pos_;
+    if (auto nl = static_cast<char*>(std::memchr(first, '\n', size))) {
+      auto n = static_cast<size_t>(nl - first);
+      line_ = {first, n};
+      pos_ += n + 1;
       ++line_number_;
-    else
+    } else if (eof_ || !fill()) {
+      eof_ = true;
+      // Yield the last line even without a trailing newline.
+      if (size > 0) {
+        line_ = {buffer_.data() + pos_, end_ - pos_};
+        pos_ = end_;
+        ++line_number_;
+      }
       break;
+    }
+  }
 }
 
 bool line_range::done() const {
-  return line_.empty() && !input_;
-}
-
-std::string& line_range::line() {
-  return line_;
+  return line_.empty() && eof_;
 }
 
 size_t line_range::line_number() const {
   return line_number_;
 }
 
+bool line_range::fill() {
+  std::memmove(buffer_.data(), buffer_.data() + pos_, end_ - pos_);
+  end_ -= pos_;
+  pos_ = 0;
+  if (end_ == buffer_.size())
+    buffer_.resize(2 * buffer_.size());
+  // Take as much as the stream buffer has available without blocking, which is
+  // the rest of the file for file buffers. Otherwise, block for a single
+  // character, after which the stream buffer holds all that it could read.
+  using traits = std::istream::traits_type;
+  auto sb = input_.rdbuf();
+  auto available = sb->in_avail();
+  if (available == 0) {
+    if (traits::eq_int_type(sb->sgetc(), traits::eof()))
+      return false;
+    available = sb->in_avail();
+  }
+  if (available <= 0)
+    return false;
+  auto space = static_cast<std::streamsize>(buffer_.size() - end_);
+  auto n = sb->sgetn(buffer_.data() + end_, std::min(available, space));
+  end_ += n;
+  return n > 0;
+}
+
 } // namespace detail
 } // namespace vast
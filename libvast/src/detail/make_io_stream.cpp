@@ -23,6 +23,14 @@
 namespace vast {
 namespace detail {
 
+namespace {
+
+// Readers consume input in large blocks, so we read as much from a pipe or
+// socket as it has available.
+constexpr size_t input_buffer_size = 1 << 16;
+
+} // namespace <anonymous>
+
 expected<std::unique_ptr<std::istream>>
 make_input_stream(const std::string& input, bool is_uds) {
   if (is_uds) {
@@ -34,11 +42,11 @@ make_input_stream(const std::string& input, bool is_uds) {
       return make_error(ec::filesystem_error,
                         "failed to connect to UNIX domain socket at", input);
     auto remote_fd = uds.recv_fd(); // Blocks!
-    auto sb = std::make_unique<fdinbuf>(remote_fd);
+    auto sb = std::make_unique<fdinbuf>(remote_fd, input_buffer_size);
     return std::make_unique<std::istream>(sb.release());
   }
   if (input == "-") {
-    auto sb = std::make_unique<fdinbuf>(0); // stdin
+    auto sb = std::make_unique<fdinbuf>(0, input_buffer_size); // stdin
     return std::make_unique<std::istream>(sb.release());
   }
   auto fb = std::make_unique<std::filebuf>();
@@ -0,0 +1,149 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/detail/simd.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#  define VAST_SIMD_X86
+#  include <immintrin.h>
+#endif
+
+namespace vast::detail {
+namespace {
+
+using kernel = void (*)(const uint64_t*, const uint64_t*, uint64_t*, size_t);
+
+struct kernel_table {
+  simd_level level;
+  kernel and_;
+  kernel or_;
+  kernel xor_;
+  kernel and_not;
+};
+
+// -- portable fallback -------------------------------------------------------
+
+#define VAST_SCALAR_KERNEL(name, expr)                                         \
+  void name##_scalar(const uint64_t* x, const uint64_t* y, uint64_t* out,      \
+                     size_t n) {                                               \
+    for (size_t i = 0; i < n; ++i) {                                           \
+      auto a = x[i];                                                           \
+      auto b = y[i];                                                           \
+      out[i] = expr;                                                           \
+    }                                                                          \
+  }
+
+VAST_SCALAR_KERNEL(and, a & b)
+VAST_SCALAR_KERNEL(or, a | b)
+VAST_SCALAR_KERNEL(xor, a ^ b)
+VAST_SCALAR_KERNEL(and_not, a & ~b)
+
+#undef VAST_SCALAR_KERNEL
+
+#ifdef VAST_SIMD_X86
+
+// -- SSE2 --------------------------------------------------------------------
+
+#define VAST_SSE2_KERNEL(name, expr, scalar_expr)                              \
+  __attribute__((target("sse2")))                                              \
+  void name##_sse2(const uint64_t* x, const uint64_t* y, uint64_t* out,        \
+                   size_t n) {                                                 \
+    size_t i = 0;                                                              \
+    for (; i + 2 <= n; i += 2) {                                               \
+      auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));       \
+      auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));       \
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), expr);             \
+    }                                                                          \
+    for (; i < n; ++i) {                                                       \
+      auto a = x[i];                                                           \
+      auto b = y[i];                                                           \
+      out[i] = scalar_expr;                                                    \
+    }                                                                          \
+  }
+
+VAST_SSE2_KERNEL(and, _mm_and_si128(a, b), a & b)
+VAST_SSE2_KERNEL(or, _mm_or_si128(a, b), a | b)
+VAST_SSE2_KERNEL(xor, _mm_xor_si128(a, b), a ^ b)
+VAST_SSE2_KERNEL(and_not, _mm_andnot_si128(b, a), a & ~b)
+
+#undef VAST_SSE2_KERNEL
+
+// -- AVX2 --------------------------------------------------------------------
+
+#define VAST_AVX2_KERNEL(name, expr, scalar_expr)                              \
+  __attribute__((target("avx2")))                                              \
+  void name##_avx2(const uint64_t* x, const uint64_t* y, uint64_t* out,        \
+                   size_t n) {                                                 \
+    size_t i = 0;                                                              \
+    for (; i + 4 <= n; i += 4) {                                               \
+      auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));    \
+      auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));    \
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), expr);          \
+    }                                                                          \
+    for (; i < n; ++i) {                                                       \
+      auto a = x[i];                                                           \
+      auto b = y[i];                                                           \
+      out[i] = scalar_expr;                                                    \
+    }                                                                          \
+  }
+
+VAST_AVX2_KERNEL(and, _mm256_and_si256(a, b), a & b)
+VAST_AVX2_KERNEL(or, _mm256_or_si256(a, b), a | b)
+VAST_AVX2_KERNEL(xor, _mm256_xor_si256(a, b), a ^ b)
+VAST_AVX2_KERNEL(and_not, _mm256_andnot_si256(b, a), a & ~b)
+
+#undef VAST_AVX2_KERNEL
+
+#endif // VAST_SIMD_X86
+
+kernel_table select_kernels() {
+#ifdef VAST_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return {simd_level::avx2, and_avx2, or_avx2, xor_avx2, and_not_avx2};
+  if (__builtin_cpu_supports("sse2"))
+    return {simd_level::sse2, and_sse2, or_sse2, xor_sse2, and_not_sse2};
+#endif
+  return {simd_level::none, and_scalar, or_scalar, xor_scalar,
+          and_not_scalar};
+}
+
+const kernel_table& kernels() {
+  static const kernel_table table = select_kernels();
+  return table;
+}
+
+} // namespace <anonymous>
+
+simd_level active_simd_level() {
+  return kernels().level;
+}
+
+void block_and(const uint64_t* x, const uint64_t* y, uint64_t* out, size_t n) {
+  kernels().and_(x, y, out, n);
+}
+
+void block_or(const uint64_t* x, const uint64_t* y, uint64_t* out, size_t n) {
+  kernels().or_(x, y, out, n);
+}
+
+void block_xor(const uint64_t* x, const uint64_t* y, uint64_t* out, size_t n) {
+  kernels().xor_(x, y, out, n);
+}
+
+void block_and_not(const uint64_t* x, const uint64_t* y, uint64_t* out,
+                   size_t n) {
+  kernels().and_not(x, y, out, n);
+}
+
+} // namespace vast::detail
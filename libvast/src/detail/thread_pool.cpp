@@ -0,0 +1,57 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/detail/assert.hpp"
+#include "vast/detail/thread_pool.hpp"
+
+namespace vast::detail {
+
+thread_pool::thread_pool(size_t threads) {
+  VAST_ASSERT(threads > 0);
+  threads_.reserve(threads);
+  for (auto i = size_t{0}; i < threads; ++i)
+    threads_.emplace_back([this] { run(); });
+}
+
+thread_pool::~thread_pool() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    done_ = true;
+  }
+  cond_.notify_all();
+  for (auto& t : threads_)
+    t.join();
+}
+
+size_t thread_pool::size() const {
+  return threads_.size();
+}
+
+void thread_pool::run() {
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      cond_.wait(lock, [&] { return done_ || !jobs_.empty(); });
+      // Drain the queue before exiting, since callers may wait on the
+      // futures of pending jobs.
+      if (jobs_.empty())
+        return;
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    job();
+  }
+}
+
+} // namespace vast::detail
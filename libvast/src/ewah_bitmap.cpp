@@ -11,8 +11,14 @@
  * contained in the LICENSE file.                                             *
  ******************************************************************************/
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include "vast/ewah_bitmap.hpp"
 
+#include "vast/detail/simd.hpp"
+
 namespace vast {
 
 ewah_bitmap::ewah_bitmap(size_type n, bool bit) {
@@ -148,6 +154,23 @@ void ewah_bitmap::append_block(block_type value, size_type bits) {
   }
 }
 
+void ewah_bitmap::append_blocks(const block_type* first,
+                                const block_type* last) {
+  if (num_bits_ % word_type::width != 0) {
+    for (; first != last; ++first)
+      append_block(*first);
+    return;
+  }
+  for (; first != last; ++first) {
+    if (blocks_.empty())
+      blocks_.push_back(0); // Always begin with an empty marker.
+    else
+      integrate_last_block();
+    blocks_.push_back(*first);
+    num_bits_ += word_type::width;
+  }
+}
+
 void ewah_bitmap::flip() {
   if (blocks_.empty())
     return;
@@ -165,7 +188,7 @@ void ewah_bitmap::flip() {
   }
   // Only flip the active bits in the last block.
   auto partial = num_bits_ % word_type::width;
-  blocks_.back() ^= word_type::lsb_mask(partial);
+  blocks_.back() ^= partial == 0 ? word_type::all : word_type::lsb_mask(partial);
 }
 
 void ewah_bitmap::integrate_last_block() {
@@ -233,6 +256,265 @@ bool operator==(const ewah_bitmap& x, const ewah_bitmap& y) {
   return x.blocks_ == y.blocks_ && x.num_bits_ == y.num_bits_;
 }
 
+namespace {
+
+using block_type = ewah_bitmap::block_type;
+using size_type = ewah_bitmap::size_type;
+using word_type = ewah_bitmap::word_type;
+
+// Walks over runs of clean and dirty words, padding the bitmap with 0s.
+using word_cursor = bit_cursor<ewah_bitmap>;
+
+// Applies a bitwise operation to two bitmaps, where *op* operates on single
+// blocks and *kernel* on runs of dirty blocks. The result has the size of the
+// longer bitmap, with the shorter one padded with 0s.
+template <class Operation, class Kernel>
+ewah_bitmap binary_eval_runs(const ewah_bitmap& lhs, const ewah_bitmap& rhs,
+                             Operation op, Kernel kernel) {
+  ewah_bitmap result;
+  auto size = std::max(lhs.size(), rhs.size());
+  if (size == 0)
+    return result;
+  std::vector<block_type> buffer;
+  // Applies the operation to dirty words on one side and a clean word on the
+  // other side. The result depends on what the operation yields for a dirty
+  // word of all 0s (lo) and all 1s (hi).
+  auto mixed = [&](block_type lo, block_type hi, const block_type* xs,
+                   size_type n) {
+    if (lo == hi) {
+      result.append_bits(lo != 0, n * word_type::width);
+    } else if (lo == word_type::none) {
+      result.append_blocks(xs, xs + n);
+    } else {
+      buffer.resize(n);
+      std::transform(xs, xs + n, buffer.begin(), [](auto x) { return ~x; });
+      result.append_blocks(buffer.data(), buffer.data() + n);
+    }
+  };
+  word_cursor l{lhs};
+  word_cursor r{rhs};
+  // We process all but the last word in runs, as the last word may be
+  // partial.
+  auto words = (size - 1) / word_type::width;
+  while (words > 0) {
+    auto n = std::min({l.words(), r.words(), words});
+    if (l.clean() && r.clean()) {
+      result.append_bits(op(l.block(), r.block()) != 0, n * word_type::width);
+    } else if (l.clean()) {
+      mixed(op(l.block(), word_type::none), op(l.block(), word_type::all),
+            r.dirty(), n);
+    } else if (r.clean()) {
+      mixed(op(word_type::none, r.block()), op(word_type::all, r.block()),
+            l.dirty(), n);
+    } else {
+      buffer.resize(n);
+      kernel(l.dirty(), r.dirty(), buffer.data(), n);
+      result.append_blocks(buffer.data(), buffer.data() + n);
+    }
+    l.skip(n);
+    r.skip(n);
+    words -= n;
+  }
+  result.append_block(op(l.block(), r.block()), size - result.size());
+  return result;
+}
+
+// Applies an associative bitwise operation to multiple bitmaps in a single
+// pass. An *absorbing* word determines the result of the operation regardless
+// of the other operand, e.g., all 0s for AND.
+template <class Operation, class Kernel>
+ewah_bitmap nary_eval_runs(const std::vector<const ewah_bitmap*>& xs,
+                           block_type absorbing, Operation op,
+                           Kernel kernel) {
+  if (xs.size() == 1)
+    return *xs[0];
+  ewah_bitmap result;
+  size_type size = 0;
+  for (auto x : xs)
+    size = std::max(size, x->size());
+  if (size == 0)
+    return result;
+  std::vector<word_cursor> cursors;
+  cursors.reserve(xs.size());
+  for (auto x : xs)
+    cursors.emplace_back(*x);
+  std::vector<const block_type*> dirty;
+  std::vector<block_type> buffer;
+  auto words = (size - 1) / word_type::width;
+  while (words > 0) {
+    // A single absorbing run suffices to skip over all other bitmaps.
+    size_type n = 0;
+    for (auto& c : cursors)
+      if (c.clean() && c.block() == absorbing)
+        n = std::max(n, c.words());
+    if (n > 0) {
+      n = std::min(n, words);
+      result.append_bits(absorbing != 0, n * word_type::width);
+    } else {
+      // Otherwise, clean runs are neutral and we combine the dirty runs.
+      n = words;
+      dirty.clear();
+      for (auto& c : cursors) {
+        n = std::min(n, c.words());
+        if (!c.clean())
+          dirty.push_back(c.dirty());
+      }
+      if (dirty.empty()) {
+        result.append_bits(absorbing == 0, n * word_type::width);
+      } else if (dirty.size() == 1) {
+        result.append_blocks(dirty[0], dirty[0] + n);
+      } else {
+        buffer.resize(n);
+        kernel(dirty[0], dirty[1], buffer.data(), n);
+        for (auto i = 2u; i < dirty.size(); ++i)
+          kernel(buffer.data(), dirty[i], buffer.data(), n);
+        result.append_blocks(buffer.data(), buffer.data() + n);
+      }
+    }
+    for (auto& c : cursors)
+      c.skip(n);
+    words -= n;
+  }
+  auto last = cursors[0].block();
+  for (auto i = 1u; i < cursors.size(); ++i)
+    last = op(last, cursors[i].block());
+  result.append_block(last, size - result.size());
+  return result;
+}
+
+} // namespace <anonymous>
+
+ewah_bitmap binary_and(const ewah_bitmap& lhs, const ewah_bitmap& rhs) {
+  auto op = [](auto x, auto y) { return x & y; };
+  return binary_eval_runs(lhs, rhs, op, detail::block_and);
+}
+
+ewah_bitmap binary_or(const ewah_bitmap& lhs, const ewah_bitmap& rhs) {
+  auto op = [](auto x, auto y) { return x | y; };
+  return binary_eval_runs(lhs, rhs, op, detail::block_or);
+}
+
+ewah_bitmap binary_xor(const ewah_bitmap& lhs, const ewah_bitmap& rhs) {
+  auto op = [](auto x, auto y) { return x ^ y; };
+  return binary_eval_runs(lhs, rhs, op, detail::block_xor);
+}
+
+ewah_bitmap binary_nand(const ewah_bitmap& lhs, const ewah_bitmap& rhs) {
+  // Padding a shorter LHS with 0s would yield a longer result than the
+  // generic algorithm, which stops at the end of the LHS.
+  if (lhs.size() < rhs.size())
+    return binary_nand<ewah_bitmap, ewah_bitmap>(lhs, rhs);
+  auto op = [](auto x, auto y) { return x & ~y; };
+  return binary_eval_runs(lhs, rhs, op, detail::block_and_not);
+}
+
+namespace detail {
+
+ewah_bitmap ewah_nary_and(const std::vector<const ewah_bitmap*>& xs) {
+  auto op = [](auto x, auto y) { return x & y; };
+  return nary_eval_runs(xs, word_type::none, op, block_and);
+}
+
+ewah_bitmap ewah_nary_or(const std::vector<const ewah_bitmap*>& xs) {
+  auto op = [](auto x, auto y) { return x | y; };
+  return nary_eval_runs(xs, word_type::all, op, block_or);
+}
+
+ewah_bitmap ewah_and_not_and(const ewah_bitmap& x, const ewah_bitmap& y,
+                             const ewah_bitmap& z) {
+  ewah_bitmap result;
+  auto size = std::max(x.size(), z.size());
+  if (size == 0)
+    return result;
+  word_cursor a{x};
+  word_cursor b{y};
+  word_cursor c{z};
+  // A clean run of 0s in x or z, or of 1s in y, zeroes the result.
+  auto absorbing = [](const word_cursor& w, block_type fill) {
+    return w.clean() && w.block() == fill ? w.words() : 0;
+  };
+  std::vector<block_type> buffer;
+  auto words = (size - 1) / word_type::width;
+  while (words > 0) {
+    auto n = std::max({absorbing(a, word_type::none),
+                       absorbing(b, word_type::all),
+                       absorbing(c, word_type::none)});
+    if (n > 0) {
+      n = std::min(n, words);
+      result.append_bits(false, n * word_type::width);
+    } else {
+      // All clean runs are neutral at this point.
+      n = std::min({a.words(), b.words(), c.words(), words});
+      if (a.clean() && b.clean() && c.clean()) {
+        result.append_bits(true, n * word_type::width);
+      } else {
+        if (a.clean())
+          buffer.assign(n, word_type::all);
+        else
+          buffer.assign(a.dirty(), a.dirty() + n);
+        if (!b.clean())
+          block_and_not(buffer.data(), b.dirty(), buffer.data(), n);
+        if (!c.clean())
+          block_and(buffer.data(), c.dirty(), buffer.data(), n);
+        result.append_blocks(buffer.data(), buffer.data() + n);
+      }
+    }
+    a.skip(n);
+    b.skip(n);
+    c.skip(n);
+    words -= n;
+  }
+  result.append_block(a.block() & ~b.block() & c.block(), size - result.size());
+  return result;
+}
+
+} // namespace detail
+
+bit_cursor<ewah_bitmap>::bit_cursor(const ewah_bitmap& bm, bool pad)
+  : blocks_{&bm.blocks()},
+    pad_{pad ? word_type::all : word_type::none},
+    last_{word_type::none} {
+  if (!blocks_->empty()) {
+    last_ = blocks_->back();
+    auto partial = bm.size() % word_type::width;
+    if (partial > 0)
+      last_ |= pad_ & ~word_type::lsb_fill(partial);
+  }
+  load();
+}
+
+void bit_cursor<ewah_bitmap>::skip(size_type n) {
+  VAST_ASSERT(offset_ == 0);
+  while (n > 0) {
+    auto k = std::min(n, words());
+    if (clean_ > 0) {
+      clean_ -= k;
+    } else {
+      next_ += k;
+      dirty_ -= k;
+    }
+    n -= k;
+    load();
+  }
+}
+
+void bit_cursor<ewah_bitmap>::load() {
+  while (clean_ == 0 && dirty_ == 0) {
+    if (next_ + 1 < blocks_->size()) {
+      auto marker = (*blocks_)[next_++];
+      clean_ = word_type::marker_num_clean(marker);
+      fill_ = word_type::marker_type(marker) ? word_type::all
+                                             : word_type::none;
+      dirty_ = word_type::marker_num_dirty(marker);
+    } else if (next_ + 1 == blocks_->size()) {
+      dirty_ = 1; // The last block, which is not tracked by any marker.
+    } else {
+      clean_ = std::numeric_limits<size_type>::max();
+      fill_ = pad_;
+    }
+  }
+}
+
 ewah_bitmap_range::ewah_bitmap_range(const ewah_bitmap& bm)
   : bm_{&bm} {
   if (!bm_->empty())
@@ -23,6 +23,7 @@
 #include "vast/concept/printable/vast/type.hpp"
 #include "vast/data.hpp"
 #include "vast/detail/assert.hpp"
+#include "vast/detail/type_traits.hpp"
 #include "vast/die.hpp"
 #include "vast/event.hpp"
 #include "vast/expression_visitors.hpp"
@@ -576,6 +577,163 @@ bool event_evaluator::operator()(const data_extractor& e, const data& d) {
   return false;
 }
 
+namespace {
+
+// Retrieves the value of a record event at a fixed offset.
+struct offset_accessor {
+  const data* operator()(const event& x) const {
+    if (auto r = get_if<vector>(x.data()))
+      return get(*r, off);
+    return nullptr;
+  }
+
+  offset off;
+};
+
+// Retrieves the entire value of an event.
+struct value_accessor {
+  const data* operator()(const event& x) const {
+    return &x.data();
+  }
+};
+
+// The types that a compiled predicate compares without going through data.
+template <class T>
+constexpr bool is_comparable_v
+  = detail::is_any_v<T, boolean, integer, count, real, timespan, timestamp,
+                     std::string, address, subnet, port>;
+
+// Compares a value against a constant of type T. Values of a different type
+// keep the semantics of ::evaluate.
+template <class Accessor, class T, class Compare>
+event_predicate compare(Accessor f, relational_operator op, const data& d,
+                        const T& y, Compare cmp) {
+  return [=](const event& x) {
+    auto lhs = f(x);
+    if (!lhs)
+      return false;
+    if (auto z = get_if<T>(*lhs))
+      return cmp(*z, y);
+    return evaluate(*lhs, op, d);
+  };
+}
+
+template <class Accessor>
+event_predicate make_predicate(Accessor f, relational_operator op,
+                               const data& d) {
+  auto specialize = [&](const auto& y) -> event_predicate {
+    using T = std::decay_t<decltype(y)>;
+    if constexpr (is_comparable_v<T>) {
+      switch (op) {
+        default:
+          break;
+        case equal:
+          return compare(f, op, d, y, std::equal_to<>{});
+        case not_equal:
+          return compare(f, op, d, y, std::not_equal_to<>{});
+        case less:
+          return compare(f, op, d, y, std::less<>{});
+        case less_equal:
+          return compare(f, op, d, y, std::less_equal<>{});
+        case greater:
+          return compare(f, op, d, y, std::greater<>{});
+        case greater_equal:
+          return compare(f, op, d, y, std::greater_equal<>{});
+      }
+    }
+    return [=](const event& x) {
+      auto lhs = f(x);
+      return lhs && evaluate(*lhs, op, d);
+    };
+  };
+  return visit(specialize, d);
+}
+
+} // namespace <anonymous>
+
+expression_compiler::expression_compiler(const type& t) : type_{t} {
+  // nop
+}
+
+event_predicate expression_compiler::operator()(none) {
+  return [](const event&) { return false; };
+}
+
+event_predicate expression_compiler::operator()(const conjunction& c) {
+  if (c.size() == 1)
+    return caf::visit(*this, c[0]);
+  std::vector<event_predicate> fs;
+  fs.reserve(c.size());
+  for (auto& op : c)
+    fs.push_back(caf::visit(*this, op));
+  return [fs = std::move(fs)](const event& x) {
+    for (auto& f : fs)
+      if (!f(x))
+        return false;
+    return true;
+  };
+}
+
+event_predicate expression_compiler::operator()(const disjunction& d) {
+  if (d.size() == 1)
+    return caf::visit(*this, d[0]);
+  std::vector<event_predicate> fs;
+  fs.reserve(d.size());
+  for (auto& op : d)
+    fs.push_back(caf::visit(*this, op));
+  return [fs = std::move(fs)](const event& x) {
+    for (auto& f : fs)
+      if (f(x))
+        return true;
+    return false;
+  };
+}
+
+event_predicate expression_compiler::operator()(const negation& n) {
+  return [f = caf::visit(*this, n.expr())](const event& x) {
+    return !f(x);
+  };
+}
+
+event_predicate expression_compiler::operator()(const predicate& p) {
+  op_ = p.op;
+  return caf::visit(*this, p.lhs, p.rhs);
+}
+
+event_predicate
+expression_compiler::operator()(const attribute_extractor& e, const data& d) {
+  // All events share the type, so the type predicate is a constant.
+  if (e.attr == "type") {
+    auto result = evaluate(type_.name(), op_, d);
+    return [=](const event&) { return result; };
+  }
+  if (e.attr == "time")
+    return [op = op_, d](const event& x) {
+      return evaluate(x.timestamp(), op, d);
+    };
+  return (*this)(nil);
+}
+
+event_predicate expression_compiler::operator()(const type_extractor&,
+                                                const data&) {
+  die("type extractor should have been resolved at this point");
+}
+
+event_predicate expression_compiler::operator()(const key_extractor&,
+                                                const data&) {
+  die("key extractor should have been resolved at this point");
+}
+
+event_predicate expression_compiler::operator()(const data_extractor& e,
+                                                const data& d) {
+  if (e.type != type_)
+    return (*this)(nil);
+  if (e.offset.empty())
+    return make_predicate(value_accessor{}, op_, d);
+  VAST_ASSERT(is<record_type>(type_)); // offset wouldn't be empty
+  return make_predicate(offset_accessor{e.offset}, op_, d);
+}
+
 
 matcher::matcher(const type& t) : type_{t} {
   // nop
@@ -611,7 +769,7 @@ bool matcher::operator()(const predicate& p) {
 bool matcher::operator()(const attribute_extractor& e, const data& d) {
   if (e.attr == "type") {
     VAST_ASSERT(is<std::string>(d));
-    return evaluate(d, op_, type_.name());
+    return evaluate(type_.name(), op_, d);
   } else if (e.attr == "time") {
     return true; // Every event has a timestamp.
   }
@@ -469,4 +469,30 @@ expected<std::string> load_contents(const path& p) {
   return std::move(contents);
 }
 
+expected<void> write_contents(const path& p, std::string_view contents) {
+#ifdef VAST_POSIX
+  auto tmp = p.str() + ".tmp";
+  errno = 0;
+  auto fd = ::open(tmp.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+  if (fd == -1)
+    return make_error(ec::filesystem_error, "failed to open", tmp,
+                      std::strerror(errno));
+  auto written = detail::write(fd, contents.data(), contents.size())
+                 && ::fsync(fd) == 0;
+  auto err = errno;
+  ::close(fd);
+  if (!written) {
+    VAST_DELETE_FILE(tmp.c_str());
+    return make_error(ec::filesystem_error, "failed to write", tmp,
+                      std::strerror(err));
+  }
+  if (!VAST_MOVE_FILE(tmp.c_str(), p.str().c_str()))
+    return make_error(ec::filesystem_error, "failed to rename", tmp,
+                      std::strerror(errno));
+  return {};
+#else
+  return make_error(ec::filesystem_error, "not yet implemented");
+#endif // VAST_POSIX
+}
+
 } // namespace vast
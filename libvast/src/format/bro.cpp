@@ -11,8 +11,11 @@
  * contained in the LICENSE file.                                             *
  ******************************************************************************/
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
+#include <iterator>
 
 #include "vast/concept/printable/numeric.hpp"
 #include "vast/concept/printable/to_string.hpp"
@@ -258,14 +261,208 @@ struct streamer {
   std::ostream& out_;
 };
 
+// Decoders for the fast path of field_parser. A decoder succeeds only if it
+// consumes the entire field, and then yields the same value as the
+// corresponding combinator parser. Digit limits rule out overflow.
+
+bool decode_digits(const char*& f, const char* l, int max_digits, uint64_t& x) {
+  auto first = f;
+  x = 0;
+  for (; f != l && *f >= '0' && *f <= '9'; ++f) {
+    if (f - first == max_digits)
+      return false;
+    x = x * 10 + static_cast<uint64_t>(*f - '0');
+  }
+  return f != first;
+}
+
+bool decode_boolean(std::string_view s, data& x) {
+  if (s == "T")
+    x = true;
+  else if (s == "F")
+    x = false;
+  else
+    return false;
+  return true;
+}
+
+bool decode_integer(std::string_view s, data& x) {
+  auto f = s.data();
+  auto l = f + s.size();
+  auto negative = *f == '-';
+  if (negative || *f == '+')
+    ++f;
+  uint64_t u;
+  if (!decode_digits(f, l, 18, u) || f != l)
+    return false;
+  auto i = static_cast<integer>(u);
+  x = negative ? -i : i;
+  return true;
+}
+
+bool decode_count(std::string_view s, data& x) {
+  auto f = s.data();
+  auto l = f + s.size();
+  uint64_t u;
+  if (!decode_digits(f, l, 19, u) || f != l)
+    return false;
+  x = count{u};
+  return true;
+}
+
+// Mirrors the real parser: both parts accumulate exactly, and the fractional
+// part gets divided by the same power of 10.
+bool decode_real(std::string_view s, real& x) {
+  static constexpr real pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                   1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14,
+                                   1e15};
+  auto f = s.data();
+  auto l = f + s.size();
+  auto negative = *f == '-';
+  if (negative || *f == '+')
+    ++f;
+  uint64_t integral;
+  uint64_t fractional;
+  if (!decode_digits(f, l, 15, integral) || f == l || *f != '.')
+    return false;
+  auto first = ++f;
+  if (!decode_digits(f, l, 15, fractional) || f != l)
+    return false;
+  x = static_cast<real>(integral)
+      + static_cast<real>(fractional) / pow10[f - first];
+  if (negative)
+    x = -x;
+  return true;
+}
+
+bool decode_ipv4(std::string_view s, data& x) {
+  auto f = s.data();
+  auto l = f + s.size();
+  uint32_t bytes;
+  auto octets = reinterpret_cast<uint8_t*>(&bytes);
+  for (auto i = 0; i < 4; ++i) {
+    if (i > 0 && (f == l || *f++ != '.'))
+      return false;
+    uint64_t octet;
+    if (!decode_digits(f, l, 3, octet) || octet > 255)
+      return false;
+    octets[i] = static_cast<uint8_t>(octet);
+  }
+  if (f != l)
+    return false;
+  x = address{&bytes, address::ipv4, address::network};
+  return true;
+}
+
+bool decode_port(std::string_view s, data& x) {
+  auto f = s.data();
+  auto l = f + s.size();
+  uint64_t u;
+  if (!decode_digits(f, l, 5, u) || f != l || u > 65535)
+    return false;
+  x = port{static_cast<port::number_type>(u), port::unknown};
+  return true;
+}
+
+// Only strings with escape sequences need to go through the unescaper.
+bool decode_string(std::string_view s, data& x) {
+  if (std::memchr(s.data(), '\\', s.size()) != nullptr)
+    return false;
+  x = std::string{s};
+  return true;
+}
+
 } // namespace <anonymous>
 
-reader::reader(std::unique_ptr<std::istream> input) : input_{std::move(input)} {
+field_parser::field_parser(const type& t, const std::string& set_separator)
+  : fallback_{make_bro_parser<iterator_type>(t, set_separator)} {
+  if (is<boolean_type>(t))
+    kind_ = kind::boolean;
+  else if (is<integer_type>(t))
+    kind_ = kind::integer;
+  else if (is<count_type>(t))
+    kind_ = kind::count;
+  else if (is<real_type>(t))
+    kind_ = kind::real;
+  else if (is<timestamp_type>(t))
+    kind_ = kind::timestamp;
+  else if (is<timespan_type>(t))
+    kind_ = kind::timespan;
+  else if (is<string_type>(t))
+    kind_ = kind::string;
+  else if (is<address_type>(t))
+    kind_ = kind::address;
+  else if (is<port_type>(t))
+    kind_ = kind::port;
+}
+
+bool field_parser::operator()(iterator_type& f, const iterator_type& l,
+                              data& x) const {
+  if (f == l)
+    return fallback_(f, l, x);
+  auto s = std::string_view{&*f, static_cast<size_t>(l - f)};
+  auto decode_real_as = [&](auto to_data) {
+    real r;
+    if (!decode_real(s, r))
+      return false;
+    x = to_data(r);
+    return true;
+  };
+  auto decoded = false;
+  switch (kind_) {
+    case kind::other:
+      break;
+    case kind::boolean:
+      decoded = decode_boolean(s, x);
+      break;
+    case kind::integer:
+      decoded = decode_integer(s, x);
+      break;
+    case kind::count:
+      decoded = decode_count(s, x);
+      break;
+    case kind::real:
+      decoded = decode_real_as([](real r) { return r; });
+      break;
+    case kind::timestamp:
+      decoded = decode_real_as([](real r) {
+        return timestamp{
+          std::chrono::duration_cast<timespan>(double_seconds(r))};
+      });
+      break;
+    case kind::timespan:
+      decoded = decode_real_as([](real r) {
+        return std::chrono::duration_cast<timespan>(double_seconds(r));
+      });
+      break;
+    case kind::string:
+      decoded = decode_string(s, x);
+      break;
+    case kind::address:
+      decoded = decode_ipv4(s, x);
+      break;
+    case kind::port:
+      decoded = decode_port(s, x);
+      break;
+  }
+  if (!decoded)
+    return fallback_(f, l, x);
+  f = l;
+  return true;
+}
+
+reader::reader(std::unique_ptr<std::istream> input, size_t parse_threads)
+  : input_{std::move(input)},
+    parse_threads_{std::max(parse_threads, size_t{1})} {
   VAST_ASSERT(input_);
   lines_ = std::make_unique<detail::line_range>(*input_);
+  if (parse_threads_ > 1)
+    pool_ = std::make_unique<detail::thread_pool>(parse_threads_);
 }
 
 expected<event> reader::read() {
+  if (parse_threads_ > 1)
+    return read_parallel();
   if (lines_->done())
     return make_error(ec::end_of_input, "input exhausted");
   if (is<none_type>(type_)) {
@@ -277,9 +474,9 @@ expected<event> reader::read() {
   lines_->next();
   if (lines_->done())
     return make_error(ec::end_of_input, "input exhausted");
-  auto s = detail::split(lines_->get(), separator_);
-  if (s.size() > 0 && !s[0].empty() && s[0].front() == '#') {
-    if (detail::starts_with(s[0], "#separator")) {
+  auto line = lines_->get();
+  if (line.front() == '#') {
+    if (detail::starts_with(line, "#separator")) {
       VAST_DEBUG(name(), "restarts with new log");
       timestamp_field_ = -1;
       separator_.clear();
@@ -289,16 +486,22 @@ expected<event> reader::read() {
       lines_->next();
       if (lines_->done())
         return make_error(ec::end_of_input, "input exhausted");
-      s = detail::split(lines_->get(), separator_);
+      line = lines_->get();
     } else {
       VAST_DEBUG(name(), "ignores comment at line",
-                 lines_->line_number() << ':', lines_->get());
+                 lines_->line_number() << ':', line);
       return no_error;
     }
   }
+  return parse_line(line, lines_->line_number());
+}
+
+expected<event> reader::parse_line(std::string_view line,
+                                   size_t line_number) const {
+  auto s = detail::split(line, separator_);
   if (s.size() != parsers_.size()) {
     VAST_WARNING(name(), "ignores invalid record at line",
-                 lines_->line_number() << ':', "got", s.size(),
+                 line_number << ':', "got", s.size(),
                  "fields but need", parsers_.size());
     return no_error;
   }
@@ -322,8 +525,7 @@ expected<event> reader::read() {
       // The parser needs an lvalue reference to the first iterator.
       auto first = s[i].begin();
       if (!parsers_[i](first, s[i].end(), xs[i]))
-        return make_error(ec::parse_error, "field", i, "line",
-                          lines_->line_number(),
+        return make_error(ec::parse_error, "field", i, "line", line_number,
                           std::string{first, s[i].end()});
     }
     if (i == static_cast<size_t>(timestamp_field_))
@@ -337,6 +539,99 @@ expected<event> reader::read() {
   return e;
 }
 
+expected<event> reader::read_parallel() {
+  if (chunk_pos_ == chunk_.size()) {
+    auto r = parse_chunk();
+    if (!r)
+      return r.error();
+    if (chunk_.empty())
+      return no_error;
+  }
+  return std::move(chunk_[chunk_pos_++]);
+}
+
+expected<void> reader::parse_chunk() {
+  chunk_.clear();
+  chunk_pos_ = 0;
+  if (pending_.empty())
+    if (auto r = dispatch_chunk(); !r)
+      return r;
+  // Splitting off the next chunk overlaps with parsing the current one. A new
+  // log changes the parsers, so its header must wait until no job uses them.
+  if (pending_.size() == 1 && !restart_ && !lines_->done())
+    if (auto r = dispatch_chunk(); !r)
+      return r;
+  // Concatenating the results of the ranges in order preserves the order of
+  // the input.
+  for (auto& f : pending_.front()) {
+    auto xs = f.get();
+    std::move(xs.begin(), xs.end(), std::back_inserter(chunk_));
+  }
+  pending_.pop_front();
+  return no_error;
+}
+
+expected<void> reader::dispatch_chunk() {
+  if (lines_->done())
+    return make_error(ec::end_of_input, "input exhausted");
+  if (is<none_type>(type_) || restart_) {
+    VAST_ASSERT(pending_.empty());
+    if (restart_) {
+      VAST_DEBUG(name(), "restarts with new log");
+      timestamp_field_ = -1;
+      restart_ = false;
+    }
+    auto t = parse_header();
+    if (!t)
+      return t.error();
+  }
+  // Split off the next data lines of the current log. The views into the line
+  // range do not outlive the next line, so we copy the lines into a single
+  // buffer and remember where each one begins.
+  auto c = std::make_shared<chunk>();
+  auto max_lines = parse_threads_ * lines_per_thread;
+  while (c->line_numbers.size() < max_lines) {
+    lines_->next();
+    if (lines_->done())
+      break;
+    auto line = lines_->get();
+    if (line.front() == '#') {
+      // A new log requires a new header, which we parse only after having
+      // parsed all lines of the current log.
+      if (detail::starts_with(line, "#separator")) {
+        restart_ = true;
+        break;
+      }
+      VAST_DEBUG(name(), "ignores comment at line",
+                 lines_->line_number() << ':', line);
+      continue;
+    }
+    c->buffer += line;
+    c->offsets.push_back(c->buffer.size());
+    c->line_numbers.push_back(lines_->line_number());
+  }
+  // Parse contiguous ranges of lines concurrently, sharing the parsers of the
+  // current header.
+  auto n = c->line_numbers.size();
+  auto per_thread = (n + parse_threads_ - 1) / parse_threads_;
+  pending_chunk jobs;
+  for (auto first = size_t{0}; first < n; first += per_thread) {
+    auto last = std::min(first + per_thread, n);
+    jobs.push_back(pool_->submit([=] {
+      std::vector<expected<event>> result;
+      result.reserve(last - first);
+      for (auto i = first; i < last; ++i) {
+        auto line = std::string_view{c->buffer}.substr(
+          c->offsets[i], c->offsets[i + 1] - c->offsets[i]);
+        result.push_back(parse_line(line, c->line_numbers[i]));
+      }
+      return result;
+    }));
+  }
+  pending_.push_back(std::move(jobs));
+  return no_error;
+}
+
 expected<void> reader::schema(const vast::schema& sch) {
   schema_ = sch;
   return no_error;
@@ -378,7 +673,8 @@ expected<void> reader::parse_header() {
   while (pos != std::string::npos) {
     pos = lines_->get().find("\\x", pos);
     if (pos != std::string::npos) {
-      auto c = std::stoi(lines_->get().substr(pos + 2, 2), nullptr, 16);
+      auto hex = std::string{lines_->get().substr(pos + 2, 2)};
+      auto c = std::stoi(hex, nullptr, 16);
       VAST_ASSERT(c >= 0 && c <= 255);
       separator_.push_back(c);
       pos += 2;
@@ -399,7 +695,7 @@ expected<void> reader::parse_header() {
     lines_->next();
     if (lines_->done())
       return make_error(ec::format_error, "not enough header lines");
-    auto& line = lines_->get();
+    auto line = lines_->get();
     pos = line.find(prefixes[i]);
     if (pos != 0)
       return make_error(ec::format_error, "invalid header line, expected",
@@ -408,7 +704,8 @@ expected<void> reader::parse_header() {
     if (pos == std::string::npos)
       return make_error(ec::format_error, "invalid separator in header line");
     if (pos + separator_.size() >= line.size())
-      return make_error(ec::format_error, "missing header content:", line);
+      return make_error(ec::format_error, "missing header content:",
+                        std::string{line});
     header[i] = line.substr(pos + separator_.size());
   }
   // Assign header values.
@@ -465,12 +762,10 @@ expected<void> reader::parse_header() {
     }
   }
   // Create Bro parsers.
-  auto make_parser = [](const auto& type, const auto& set_sep) {
-    return make_bro_parser<iterator_type>(type, set_sep);
-  };
-  parsers_.resize(record_.fields.size());
-  for (size_t i = 0; i < record_.fields.size(); i++)
-    parsers_[i] = make_parser(record_.fields[i].type, set_separator_);
+  parsers_.clear();
+  parsers_.reserve(record_.fields.size());
+  for (auto& field : record_.fields)
+    parsers_.emplace_back(field.type, set_separator_);
   return no_error;
 }
 
@@ -11,6 +11,15 @@
  * contained in the LICENSE file.                                             *
  ******************************************************************************/
 
+#include <algorithm>
+#include <cstring>
+
+#include <caf/detail/scope_guard.hpp>
+
+#include "vast/detail/assert.hpp"
+#include "vast/error.hpp"
+#include "vast/logger.hpp"
+
 #include "vast/format/csv.hpp"
 
 namespace vast {
@@ -21,6 +30,216 @@ constexpr char value_printer::separator[];
 constexpr char value_printer::set_separator[];
 constexpr char value_printer::empty[];
 
+reader::reader(std::unique_ptr<std::istream> input, size_t block_size)
+  : input_{std::move(input)} {
+  VAST_ASSERT(input_);
+  lines_ = std::make_unique<detail::line_range>(*input_, block_size);
+}
+
+expected<event> reader::read() {
+  if (lines_->done())
+    return make_error(ec::end_of_input, "input exhausted");
+  auto line = lines_->get();
+  auto line_number = lines_->line_number();
+  // The fields point into the line, which remains valid only until we advance
+  // the range.
+  auto guard = caf::detail::make_scope_guard([&] { lines_->next(); });
+  if (!line.empty() && line.back() == '\r')
+    line.remove_suffix(1);
+  if (is<none_type>(type_)) {
+    if (auto r = parse_header(line); !r)
+      return r.error();
+    return no_error;
+  }
+  if (!split(line))
+    return make_error(ec::parse_error, "unterminated quote in line",
+                      line_number);
+  // The writer repeats the header when the event type changes.
+  if (has_meta_columns_ && !fields_[0].quoted && fields_[0].text == "type") {
+    if (auto r = parse_header(line); !r)
+      return r.error();
+    return no_error;
+  }
+  if (fields_.size() != columns_.size()) {
+    VAST_WARNING(name(), "ignores invalid record at line", line_number << ':',
+                 "got", fields_.size(), "fields but need", columns_.size());
+    return no_error;
+  }
+  // Construct the record.
+  vector xs(flat_.fields.size());
+  optional<timestamp> ts;
+  for (auto i = 0u; i < fields_.size(); ++i) {
+    auto [text, quoted] = fields_[i];
+    auto column = columns_[i];
+    if (static_cast<int>(i) == timestamp_column_ && column == meta_column) {
+      // The writer prints the event timestamp as nanoseconds since the epoch.
+      count ns;
+      auto f = text.begin();
+      if (parsers::u64(f, text.end(), ns) && f == text.end())
+        ts = timestamp{timespan{ns}};
+      continue;
+    }
+    if (column == meta_column)
+      continue;
+    auto& t = flat_.fields[column].type;
+    // Empty fields are nil, unless quoted strings or containers.
+    if (text.empty()) {
+      if (quoted && (is<string_type>(t) || is_container(t)))
+        xs[column] = construct(t);
+      continue;
+    }
+    auto f = text.begin();
+    if (!parsers_[i](f, text.end(), xs[column]) || f != text.end())
+      return make_error(ec::parse_error, "column", i, "line", line_number,
+                        std::string{text});
+    if (static_cast<int>(i) == timestamp_column_)
+      if (auto tp = get_if<timestamp>(xs[column]))
+        ts = *tp;
+  }
+  auto ys = unflatten(std::move(xs), type_);
+  VAST_ASSERT(ys);
+  event e{{std::move(*ys), type_}};
+  e.timestamp(ts ? *ts : timestamp::clock::now());
+  return e;
+}
+
+bool reader::split(std::string_view line) {
+  fields_.clear();
+  auto f = line.data();
+  auto l = f + line.size();
+  // Most lines have no quotes at all, in which case a search for the
+  // separator finds each field. The C library implements memchr with vector
+  // instructions.
+  if (std::memchr(f, '"', line.size()) == nullptr) {
+    while (true) {
+      auto sep = static_cast<const char*>(std::memchr(f, ',', l - f));
+      auto last = sep ? sep : l;
+      fields_.push_back({std::string_view(f, last - f), false});
+      if (!sep)
+        return true;
+      f = sep + 1;
+    }
+  }
+  // Unescaped quoted fields never exceed the line, so reserving the line
+  // size keeps views into the buffer valid.
+  unescaped_.clear();
+  unescaped_.reserve(line.size());
+  while (true) {
+    if (f != l && *f == '"') {
+      auto first = ++f;
+      auto escaped = false;
+      // Find the closing quote, skipping doubled quotes.
+      while (true) {
+        auto quote = static_cast<const char*>(std::memchr(f, '"', l - f));
+        if (!quote)
+          return false;
+        f = quote + 1;
+        if (f == l || *f != '"')
+          break;
+        escaped = true;
+        ++f;
+      }
+      auto text = std::string_view(first, f - 1 - first);
+      if (escaped) {
+        auto size = unescaped_.size();
+        for (auto i = text.begin(); i != text.end(); ++i) {
+          unescaped_ += *i;
+          if (*i == '"')
+            ++i;
+        }
+        text = std::string_view{unescaped_}.substr(size);
+      }
+      fields_.push_back({text, true});
+      if (f == l)
+        return true;
+      if (*f++ != ',')
+        return false;
+    } else {
+      auto sep = static_cast<const char*>(std::memchr(f, ',', l - f));
+      auto last = sep ? sep : l;
+      fields_.push_back({std::string_view(f, last - f), false});
+      if (!sep)
+        return true;
+      f = sep + 1;
+    }
+  }
+}
+
+expected<void> reader::parse_header(std::string_view line) {
+  if (!split(line))
+    return make_error(ec::format_error, "invalid CSV header:",
+                      std::string{line});
+  std::vector<std::string> names;
+  for (auto& x : fields_)
+    names.emplace_back(x.text);
+  // The writer starts with columns for event meta data.
+  has_meta_columns_ = names.size() >= 3 && names[0] == "type"
+                      && names[1] == "id" && names[2] == "timestamp";
+  auto first = has_meta_columns_ ? names.begin() + 3 : names.begin();
+  // Find the schema type with the fewest fields that has all columns.
+  const type* match = nullptr;
+  record_type flat;
+  for (auto& t : schema_) {
+    auto r = get_if<record_type>(t);
+    if (!r)
+      continue;
+    auto candidate = flatten(*r);
+    if (match && candidate.fields.size() >= flat.fields.size())
+      continue;
+    auto has_column = [&](const std::string& name) {
+      auto pred = [&](auto& field) { return field.name == name; };
+      return std::any_of(candidate.fields.begin(), candidate.fields.end(),
+                         pred);
+    };
+    if (std::all_of(first, names.end(), has_column)) {
+      match = &t;
+      flat = std::move(candidate);
+    }
+  }
+  if (!match)
+    return make_error(ec::format_error, "no schema type matches CSV header:",
+                      std::string{line});
+  VAST_DEBUG(name(), "maps header onto type", match->name());
+  type_ = *match;
+  flat_ = std::move(flat);
+  // Map the columns onto fields and create their parsers.
+  columns_.clear();
+  parsers_.clear();
+  timestamp_column_ = has_meta_columns_ ? 2 : -1;
+  for (auto i = names.begin(); i != names.end(); ++i) {
+    if (i < first) {
+      columns_.push_back(meta_column);
+      parsers_.emplace_back();
+      continue;
+    }
+    auto pred = [&](auto& field) { return field.name == *i; };
+    auto j = std::find_if(flat_.fields.begin(), flat_.fields.end(), pred);
+    VAST_ASSERT(j != flat_.fields.end());
+    columns_.push_back(j - flat_.fields.begin());
+    parsers_.push_back(make_csv_parser<iterator_type>(j->type));
+    if (timestamp_column_ < 0 && is<timestamp_type>(j->type))
+      timestamp_column_ = static_cast<int>(columns_.size() - 1);
+  }
+  return no_error;
+}
+
+expected<void> reader::schema(const vast::schema& sch) {
+  schema_ = sch;
+  return no_error;
+}
+
+expected<schema> reader::schema() const {
+  if (is<none_type>(type_))
+    return make_error(ec::format_error, "schema not yet determined");
+  vast::schema sch;
+  sch.add(type_);
+  return sch;
+}
+
+const char* reader::name() const {
+  return "csv-reader";
+}
+
 } // namespace csv
 } // namespace format
 } // namespace vast
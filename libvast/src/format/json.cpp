@@ -0,0 +1,628 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <caf/detail/scope_guard.hpp>
+
+#include <date/date.h>
+
+#include "vast/concept/parseable/numeric.hpp"
+#include "vast/concept/parseable/vast/address.hpp"
+#include "vast/concept/parseable/vast/port.hpp"
+#include "vast/concept/parseable/vast/subnet.hpp"
+#include "vast/concept/parseable/vast/time.hpp"
+#include "vast/concept/hashable/xxhash.hpp"
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/type.hpp"
+#include "vast/detail/assert.hpp"
+#include "vast/detail/string.hpp"
+#include "vast/error.hpp"
+#include "vast/logger.hpp"
+
+#include "vast/format/json.hpp"
+
+namespace vast::format::json {
+namespace {
+
+// -- scanning ----------------------------------------------------------------
+
+// The scanner locates keys and values of a line in a single pass. It does not
+// materialize any values; instead, it records the location of each value in
+// a token. Searching for the end of a string uses memchr, which the C library
+// implements with vector instructions.
+
+void skip_ws(const char*& f, const char* l) {
+  while (f != l && (*f == ' ' || *f == '\t' || *f == '\r' || *f == '\n'))
+    ++f;
+}
+
+bool scan_string(const char*& f, const char* l, token& x) {
+  VAST_ASSERT(f != l && *f == '"');
+  auto first = ++f;
+  while (true) {
+    auto quote = static_cast<const char*>(std::memchr(f, '"', l - f));
+    if (quote == nullptr)
+      return false;
+    // A quote is escaped iff an odd number of backslashes precedes it.
+    auto backslash = quote;
+    while (backslash != first && *(backslash - 1) == '\\')
+      --backslash;
+    f = quote + 1;
+    if ((quote - backslash) % 2 == 0)
+      break;
+  }
+  x.kind = token::string;
+  x.text = std::string_view{first, static_cast<size_t>(f - 1 - first)};
+  x.escaped = std::memchr(x.text.data(), '\\', x.text.size()) != nullptr;
+  return true;
+}
+
+bool scan_literal(const char*& f, const char* l, std::string_view literal) {
+  if (static_cast<size_t>(l - f) < literal.size()
+      || std::string_view{f, literal.size()} != literal)
+    return false;
+  f += literal.size();
+  return true;
+}
+
+// Scans any value other than an object. Arrays become a single token, since
+// their interpretation depends on the type of the field.
+bool scan_value(const char*& f, const char* l, token& x) {
+  if (f == l)
+    return false;
+  auto first = f;
+  x.escaped = false;
+  switch (*f) {
+    case '"':
+      return scan_string(f, l, x);
+    case '[': {
+      auto depth = 0;
+      token str;
+      while (f != l) {
+        if (*f == '"') {
+          if (!scan_string(f, l, str))
+            return false;
+          continue;
+        }
+        if (*f == '[' || *f == '{') {
+          ++depth;
+        } else if (*f == ']' || *f == '}') {
+          if (--depth == 0) {
+            ++f;
+            x.kind = token::array;
+            x.text = std::string_view{first, static_cast<size_t>(f - first)};
+            return true;
+          }
+        }
+        ++f;
+      }
+      return false;
+    }
+    case 't':
+    case 'f':
+      if (!scan_literal(f, l, *f == 't' ? "true" : "false"))
+        return false;
+      x.kind = token::boolean;
+      break;
+    case 'n':
+      if (!scan_literal(f, l, "null"))
+        return false;
+      x.kind = token::null;
+      break;
+    default:
+      while (f != l && ((*f >= '0' && *f <= '9') || *f == '-' || *f == '+'
+                        || *f == '.' || *f == 'e' || *f == 'E'))
+        ++f;
+      if (f == first)
+        return false;
+      x.kind = token::number;
+      break;
+  }
+  x.text = std::string_view{first, static_cast<size_t>(f - first)};
+  return true;
+}
+
+std::string unescape(std::string_view str) {
+  std::string quoted;
+  quoted.reserve(str.size() + 2);
+  quoted += '"';
+  quoted += str;
+  quoted += '"';
+  return detail::json_unescape(quoted);
+}
+
+// Scans the members of an object. Each key ends up in *keys*, prefixed with
+// the keys of the enclosing objects and terminated by a NUL byte.
+bool scan_object(const char*& f, const char* l, std::string& prefix,
+                 std::string& keys, std::vector<token>& values) {
+  VAST_ASSERT(f != l && *f == '{');
+  ++f;
+  skip_ws(f, l);
+  if (f != l && *f == '}') {
+    ++f;
+    return true;
+  }
+  while (true) {
+    skip_ws(f, l);
+    token key;
+    if (f == l || *f != '"' || !scan_string(f, l, key))
+      return false;
+    skip_ws(f, l);
+    if (f == l || *f++ != ':')
+      return false;
+    skip_ws(f, l);
+    if (f == l)
+      return false;
+    if (*f == '{') {
+      auto size = prefix.size();
+      prefix += key.escaped ? unescape(key.text) : std::string{key.text};
+      prefix += '.';
+      if (!scan_object(f, l, prefix, keys, values))
+        return false;
+      prefix.resize(size);
+    } else {
+      token value;
+      if (!scan_value(f, l, value))
+        return false;
+      keys += prefix;
+      if (key.escaped)
+        keys += unescape(key.text);
+      else
+        keys += key.text;
+      keys += '\0';
+      values.push_back(value);
+    }
+    skip_ws(f, l);
+    if (f == l)
+      return false;
+    if (*f == '}') {
+      ++f;
+      return true;
+    }
+    if (*f++ != ',')
+      return false;
+  }
+}
+
+// Splits an array token into its elements.
+bool scan_array(std::string_view str, std::vector<token>& xs) {
+  auto f = str.data();
+  auto l = f + str.size();
+  VAST_ASSERT(f != l && *f == '[');
+  ++f;
+  skip_ws(f, l);
+  if (f != l && *f == ']')
+    return true;
+  while (true) {
+    skip_ws(f, l);
+    token x;
+    if (!scan_value(f, l, x))
+      return false;
+    xs.push_back(x);
+    skip_ws(f, l);
+    if (f == l)
+      return false;
+    if (*f == ']')
+      return true;
+    if (*f++ != ',')
+      return false;
+  }
+}
+
+// -- conversion --------------------------------------------------------------
+
+template <class Parser, class Attribute>
+bool parse_all(const Parser& p, std::string_view str, Attribute& x) {
+  auto f = str.begin();
+  auto l = str.end();
+  return p(f, l, x) && f == l;
+}
+
+bool parse_number(std::string_view str, real& x) {
+  // JSON numbers may have an exponent, which the real parser does not
+  // support. Numbers are short, so copying them for strtod is cheap.
+  char buf[64];
+  if (str.size() >= sizeof(buf))
+    return false;
+  std::memcpy(buf, str.data(), str.size());
+  buf[str.size()] = '\0';
+  char* end;
+  x = std::strtod(buf, &end);
+  return end == buf + str.size();
+}
+
+// Parses ISO 8601 timestamps of the form YYYY-MM-DDTHH:MM:SS[.f][Z|+hh[:mm]],
+// as written by Suricata and Zeek.
+bool parse_iso8601(std::string_view str, timestamp& x) {
+  using namespace std::chrono;
+  auto f = str.data();
+  auto l = f + str.size();
+  auto num = [&](int digits, int& n) {
+    if (l - f < digits)
+      return false;
+    n = 0;
+    for (auto i = 0; i < digits; ++i, ++f) {
+      if (*f < '0' || *f > '9')
+        return false;
+      n = n * 10 + (*f - '0');
+    }
+    return true;
+  };
+  auto lit = [&](char c) {
+    return f != l && *f++ == c;
+  };
+  int year, month, day, hour, minute, second;
+  if (!(num(4, year) && lit('-') && num(2, month) && lit('-') && num(2, day)))
+    return false;
+  if (f == l || (*f != 'T' && *f != ' '))
+    return false;
+  ++f;
+  if (!(num(2, hour) && lit(':') && num(2, minute) && lit(':')
+        && num(2, second)))
+    return false;
+  auto fraction = timespan{0};
+  if (f != l && *f == '.') {
+    ++f;
+    auto ns = timespan::rep{0};
+    auto digits = 0;
+    for (; f != l && *f >= '0' && *f <= '9'; ++f, ++digits)
+      if (digits < 9)
+        ns = ns * 10 + (*f - '0');
+    if (digits == 0)
+      return false;
+    for (; digits < 9; ++digits)
+      ns *= 10;
+    fraction = timespan{ns};
+  }
+  auto offset = minutes{0};
+  if (f != l && *f == 'Z') {
+    ++f;
+  } else if (f != l && (*f == '+' || *f == '-')) {
+    auto negative = *f++ == '-';
+    int offset_hours;
+    int offset_minutes = 0;
+    if (!num(2, offset_hours))
+      return false;
+    if (f != l && *f == ':')
+      ++f;
+    if (f != l && !num(2, offset_minutes))
+      return false;
+    offset = hours{offset_hours} + minutes{offset_minutes};
+    if (negative)
+      offset = -offset;
+  }
+  if (f != l || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23
+      || minute > 59 || second > 60)
+    return false;
+  date::sys_days days = date::year{year} / month / day;
+  x = timestamp{days} + hours{hour} + minutes{minute} + seconds{second}
+      + fraction - offset;
+  return true;
+}
+
+// Converts a token into data of a given type. A null value is valid for any
+// type, and string fields take the JSON text of values of other kinds.
+bool convert(const token& x, const type& t, data& result) {
+  if (x.kind == token::null) {
+    result = nil;
+    return true;
+  }
+  auto str = [&] {
+    return x.escaped ? unescape(x.text) : std::string{x.text};
+  };
+  if (is<string_type>(t)) {
+    result = str();
+    return true;
+  }
+  if (auto v = get_if<vector_type>(t)) {
+    if (x.kind != token::array)
+      return false;
+    std::vector<token> elements;
+    if (!scan_array(x.text, elements))
+      return false;
+    vector xs(elements.size());
+    for (auto i = 0u; i < elements.size(); ++i)
+      if (!convert(elements[i], v->value_type, xs[i]))
+        return false;
+    result = std::move(xs);
+    return true;
+  }
+  if (auto s = get_if<set_type>(t)) {
+    if (x.kind != token::array)
+      return false;
+    std::vector<token> elements;
+    if (!scan_array(x.text, elements))
+      return false;
+    set xs;
+    for (auto& element : elements) {
+      data y;
+      if (!convert(element, s->value_type, y))
+        return false;
+      xs.insert(std::move(y));
+    }
+    result = std::move(xs);
+    return true;
+  }
+  switch (x.kind) {
+    default:
+      return false;
+    case token::boolean:
+      if (!is<boolean_type>(t))
+        return false;
+      result = x.text == "true";
+      return true;
+    case token::number: {
+      if (is<integer_type>(t)) {
+        integer i;
+        if (!parse_all(parsers::i64, x.text, i))
+          return false;
+        result = i;
+        return true;
+      }
+      if (is<count_type>(t)) {
+        count c;
+        if (!parse_all(parsers::u64, x.text, c))
+          return false;
+        result = c;
+        return true;
+      }
+      if (is<port_type>(t)) {
+        uint16_t n;
+        if (!parse_all(parsers::u16, x.text, n))
+          return false;
+        result = port{n, port::unknown};
+        return true;
+      }
+      real r;
+      if (!parse_number(x.text, r))
+        return false;
+      // Numeric timestamps and durations are fractional seconds, as in Zeek.
+      auto span = std::chrono::duration_cast<timespan>(double_seconds{r});
+      if (is<real_type>(t))
+        result = r;
+      else if (is<timestamp_type>(t))
+        result = timestamp{span};
+      else if (is<timespan_type>(t))
+        result = span;
+      else
+        return false;
+      return true;
+    }
+    case token::string: {
+      auto s = str();
+      if (is<timestamp_type>(t)) {
+        timestamp ts;
+        if (!parse_iso8601(s, ts) && !parse_all(parsers::timestamp, s, ts))
+          return false;
+        result = ts;
+        return true;
+      }
+      auto parse = [&](const auto& p, auto y) {
+        if (!parse_all(p, s, y))
+          return false;
+        result = std::move(y);
+        return true;
+      };
+      if (is<address_type>(t))
+        return parse(parsers::addr, address{});
+      if (is<subnet_type>(t))
+        return parse(parsers::net, subnet{});
+      if (is<port_type>(t))
+        return parse(parsers::port, port{});
+      if (is<timespan_type>(t))
+        return parse(parsers::timespan, timespan{});
+      if (is<pattern_type>(t)) {
+        result = pattern{std::move(s)};
+        return true;
+      }
+      return false;
+    }
+  }
+}
+
+// Infers the type of a value from its first occurrence. Strings holding
+// addresses or ISO 8601 timestamps become values of the respective type.
+type infer(const token& x) {
+  switch (x.kind) {
+    default:
+      return string_type{};
+    case token::boolean:
+      return boolean_type{};
+    case token::number:
+      if (x.text.find_first_of(".eE") != std::string_view::npos)
+        return real_type{};
+      return integer_type{};
+    case token::string: {
+      if (x.escaped)
+        return string_type{};
+      address a;
+      if (parse_all(parsers::addr, x.text, a))
+        return address_type{};
+      timestamp ts;
+      if (parse_iso8601(x.text, ts))
+        return timestamp_type{};
+      return string_type{};
+    }
+    case token::array: {
+      // We only support arrays of scalars; everything else stays JSON text.
+      std::vector<token> elements;
+      if (!scan_array(x.text, elements) || elements.empty())
+        return string_type{};
+      if (elements[0].kind == token::array)
+        return string_type{};
+      return vector_type{infer(elements[0])};
+    }
+  }
+}
+
+std::vector<std::string_view> split_keys(std::string_view keys) {
+  std::vector<std::string_view> result;
+  while (!keys.empty()) {
+    auto i = keys.find('\0');
+    VAST_ASSERT(i != std::string_view::npos);
+    result.push_back(keys.substr(0, i));
+    keys.remove_prefix(i + 1);
+  }
+  return result;
+}
+
+} // namespace <anonymous>
+
+reader::reader(std::unique_ptr<std::istream> input, size_t block_size)
+  : input_{std::move(input)} {
+  VAST_ASSERT(input_);
+  lines_ = std::make_unique<detail::line_range>(*input_, block_size);
+}
+
+expected<event> reader::read() {
+  if (lines_->done())
+    return make_error(ec::end_of_input, "input exhausted");
+  auto line = lines_->get();
+  auto line_number = lines_->line_number();
+  // The tokens point into the line, which remains valid only until we advance
+  // the range. Hence we advance after processing the line.
+  auto guard = caf::detail::make_scope_guard([&] { lines_->next(); });
+  // Locate all keys and values.
+  keys_.clear();
+  prefix_.clear();
+  values_.clear();
+  auto f = line.data();
+  auto l = f + line.size();
+  skip_ws(f, l);
+  if (f == l || *f != '{' || !scan_object(f, l, prefix_, keys_, values_))
+    return make_error(ec::parse_error, "invalid JSON object in line",
+                      line_number);
+  skip_ws(f, l);
+  if (f != l)
+    return make_error(ec::parse_error, "trailing characters in line",
+                      line_number);
+  // Look up the layout of the keys.
+  auto i = layouts_.find(keys_);
+  if (i == layouts_.end()) {
+    i = layouts_.emplace(keys_, make_layout()).first;
+    VAST_DEBUG(name(), "maps line", line_number, "onto type",
+               i->second.event_type.name());
+  }
+  auto& lay = i->second;
+  // Convert the values according to the layout.
+  vector xs(lay.flat.fields.size());
+  for (auto j = 0u; j < values_.size(); ++j) {
+    auto k = lay.fields[j];
+    if (!convert(values_[j], lay.flat.fields[k].type, xs[k]))
+      return make_error(ec::parse_error, "invalid value for field",
+                        lay.flat.fields[k].name, "in line", line_number,
+                        std::string{values_[j].text});
+  }
+  optional<timestamp> ts;
+  if (lay.timestamp_field >= 0)
+    if (auto t = get_if<timestamp>(xs[lay.timestamp_field]))
+      ts = *t;
+  auto ys = unflatten(std::move(xs), lay.event_type);
+  VAST_ASSERT(ys);
+  event e{{std::move(*ys), lay.event_type}};
+  e.timestamp(ts ? *ts : timestamp::clock::now());
+  return e;
+}
+
+reader::layout reader::make_layout() const {
+  auto keys = split_keys(keys_);
+  layout result;
+  // Prefer the schema type that covers all keys with the fewest fields.
+  for (auto& t : schema_) {
+    auto r = get_if<record_type>(t);
+    if (!r)
+      continue;
+    auto flat = flatten(*r);
+    if (!result.flat.fields.empty()
+        && flat.fields.size() >= result.flat.fields.size())
+      continue;
+    std::vector<size_t> fields;
+    for (auto key : keys) {
+      auto pred = [&](auto& field) { return field.name == key; };
+      auto j = std::find_if(flat.fields.begin(), flat.fields.end(), pred);
+      if (j == flat.fields.end())
+        break;
+      fields.push_back(j - flat.fields.begin());
+    }
+    if (fields.size() == keys.size()) {
+      result.event_type = t;
+      result.flat = std::move(flat);
+      result.fields = std::move(fields);
+    }
+  }
+  // Otherwise infer a type. We sort the keys so that the fields of nested
+  // records are adjacent, and so that objects with the same keys in different
+  // order end up with the same type.
+  if (result.flat.fields.empty()) {
+    std::vector<size_t> order(keys.size());
+    for (auto j = 0u; j < order.size(); ++j)
+      order[j] = j;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](auto x, auto y) { return keys[x] < keys[y]; });
+    for (auto j : order) {
+      auto& fields = result.flat.fields;
+      if (fields.empty() || fields.back().name != keys[j])
+        fields.emplace_back(std::string{keys[j]}, infer(values_[j]));
+    }
+    result.fields.resize(keys.size());
+    for (auto j = 0u; j < keys.size(); ++j) {
+      auto pred = [&](auto& field) { return field.name == keys[j]; };
+      auto& fields = result.flat.fields;
+      result.fields[j] = std::find_if(fields.begin(), fields.end(), pred)
+                         - fields.begin();
+    }
+    // Types with the same name must be congruent, so the name includes a
+    // digest of the fields.
+    std::string signature;
+    for (auto& field : result.flat.fields)
+      signature += field.name + ':' + to_string(field.type) + ',';
+    xxhash32 h;
+    h(signature.data(), signature.size());
+    auto digest = static_cast<xxhash32::result_type>(h);
+    result.event_type = unflatten(result.flat);
+    result.event_type.name("json::" + std::to_string(digest));
+  }
+  // Use the first timestamp field as event timestamp.
+  auto& fields = result.flat.fields;
+  auto pred = [](auto& field) { return is<timestamp_type>(field.type); };
+  auto j = std::find_if(fields.begin(), fields.end(), pred);
+  if (j != fields.end())
+    result.timestamp_field = static_cast<int>(j - fields.begin());
+  return result;
+}
+
+expected<void> reader::schema(const vast::schema& sch) {
+  schema_ = sch;
+  layouts_.clear();
+  return no_error;
+}
+
+expected<vast::schema> reader::schema() const {
+  if (layouts_.empty())
+    return make_error(ec::format_error, "schema not yet inferred");
+  vast::schema sch;
+  for (auto& [keys, lay] : layouts_)
+    sch.add(lay.event_type);
+  return sch;
+}
+
+const char* reader::name() const {
+  return "json-reader";
+}
+
+} // namespace vast::format::json
@@ -83,7 +83,7 @@ void null_bitmap_range::scan() {
     if (block_ == last) {
       auto partial = bitvector_->size() % word_type::width;
       if (partial > 0) {
-        auto mask = word_type::mask(partial);
+        auto mask = word_type::lsb_mask(partial);
         if ((*block_ & mask) == (data & mask)) {
           n += partial;
           ++block_;
@@ -0,0 +1,493 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <iterator>
+
+#include "vast/roaring_bitmap.hpp"
+
+#include "vast/detail/assert.hpp"
+#include "vast/detail/simd.hpp"
+
+namespace vast {
+
+namespace {
+
+using block_type = roaring_bitmap::block_type;
+using size_type = roaring_bitmap::size_type;
+using word_type = roaring_bitmap::word_type;
+using container = roaring_bitmap::container;
+
+constexpr auto chunk_blocks = roaring_bitmap::chunk_blocks;
+
+// Sets the bits in [first, last) of a bitset.
+void set_range(block_type* xs, size_t first, size_t last) {
+  if (first == last)
+    return;
+  auto i = first / word_type::width;
+  auto j = (last - 1) / word_type::width;
+  auto lo = word_type::all << (first % word_type::width);
+  auto hi = word_type::all >> (word_type::width - 1 - (last - 1)
+                                                    % word_type::width);
+  if (i == j) {
+    xs[i] |= lo & hi;
+  } else {
+    xs[i] |= lo;
+    std::fill(xs + i + 1, xs + j, word_type::all);
+    xs[j] |= hi;
+  }
+}
+
+// Writes the bits of a container into a bitset of ::chunk_blocks blocks.
+void materialize(const container& c, block_type* xs) {
+  if (c.kind == container::bitset) {
+    std::copy(c.blocks.begin(), c.blocks.end(), xs);
+    return;
+  }
+  std::fill(xs, xs + chunk_blocks, word_type::none);
+  if (c.kind == container::array) {
+    for (auto x : c.values)
+      xs[x / word_type::width] |= word_type::lsb1 << (x % word_type::width);
+  } else {
+    for (auto i = 0u; i < c.values.size(); i += 2)
+      set_range(xs, c.values[i], c.values[i] + c.values[i + 1] + 1u);
+  }
+}
+
+// Creates a container from a bitset, choosing the most compact
+// representation.
+container make_container(uint64_t key, const block_type* xs) {
+  container result{key, container::bitset, 0, {}, {}};
+  size_t runs = 0;
+  block_type carry = 0;
+  for (auto i = 0u; i < chunk_blocks; ++i) {
+    auto x = xs[i];
+    result.cardinality += word_type::popcount(x);
+    runs += word_type::popcount(x & ~((x << 1) | carry));
+    carry = x >> (word_type::width - 1);
+  }
+  auto run_bytes = 4 * runs;
+  auto array_bytes = 2 * size_t{result.cardinality};
+  auto bitset_bytes = chunk_blocks * sizeof(block_type);
+  if (run_bytes < bitset_bytes && run_bytes < array_bytes) {
+    result.kind = container::run;
+    result.values.reserve(2 * runs);
+    carry = 0;
+    for (auto i = 0u; i < chunk_blocks; ++i) {
+      auto x = xs[i];
+      auto next = i + 1 < chunk_blocks ? xs[i + 1] : word_type::none;
+      auto starts = x & ~((x << 1) | carry);
+      auto ends = x & ~((x >> 1) | (next << (word_type::width - 1)));
+      carry = x >> (word_type::width - 1);
+      // A run starts before it ends, possibly at the same position.
+      while (starts != 0 || ends != 0) {
+        auto s = word_type::count_trailing_zeros(starts);
+        auto e = word_type::count_trailing_zeros(ends);
+        if (starts != 0 && (ends == 0 || s <= e)) {
+          result.values.push_back(i * word_type::width + s);
+          starts &= starts - 1;
+        } else {
+          auto start = result.values.back();
+          result.values.push_back(i * word_type::width + e - start);
+          ends &= ends - 1;
+        }
+      }
+    }
+  } else if (result.cardinality <= roaring_bitmap::max_array_size) {
+    result.kind = container::array;
+    result.values.reserve(result.cardinality);
+    for (auto i = 0u; i < chunk_blocks; ++i)
+      for (auto x = xs[i]; x != 0; x &= x - 1)
+        result.values.push_back(i * word_type::width
+                                + word_type::count_trailing_zeros(x));
+  } else {
+    result.blocks.assign(xs, xs + chunk_blocks);
+  }
+  return result;
+}
+
+// Re-encodes a container in its most compact representation.
+void optimize(container& c) {
+  std::vector<block_type> xs(chunk_blocks);
+  materialize(c, xs.data());
+  c = make_container(c.key, xs.data());
+}
+
+bool contains(const container& c, uint16_t x) {
+  if (c.kind == container::array)
+    return std::binary_search(c.values.begin(), c.values.end(), x);
+  if (c.kind == container::bitset)
+    return word_type::test(c.blocks[x / word_type::width],
+                           x % word_type::width);
+  // Find the last run that starts at or before x.
+  size_t lo = 0;
+  size_t hi = c.values.size() / 2;
+  while (lo < hi) {
+    auto mid = lo + (hi - lo) / 2;
+    if (c.values[2 * mid] <= x)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo == 0)
+    return false;
+  auto start = c.values[2 * (lo - 1)];
+  return x - start <= c.values[2 * (lo - 1) + 1];
+}
+
+// Sets the bits in [first, last) of a container, where *first* must not
+// precede the last 1-bit in the container.
+void append_range(container& c, size_t first, size_t last) {
+  VAST_ASSERT(first < last && last <= roaring_bitmap::chunk_size);
+  auto n = last - first;
+  switch (c.kind) {
+    case container::array:
+      if (c.cardinality + n <= roaring_bitmap::max_array_size) {
+        for (auto i = first; i < last; ++i)
+          c.values.push_back(static_cast<uint16_t>(i));
+        break;
+      }
+      c.blocks.resize(chunk_blocks);
+      materialize(c, c.blocks.data());
+      c.values.clear();
+      c.kind = container::bitset;
+      [[fallthrough]];
+    case container::bitset:
+      set_range(c.blocks.data(), first, last);
+      break;
+    case container::run:
+      if (!c.values.empty()
+          && c.values[c.values.size() - 2] + c.values.back() + 1u == first) {
+        c.values.back() += static_cast<uint16_t>(n);
+      } else {
+        c.values.push_back(static_cast<uint16_t>(first));
+        c.values.push_back(static_cast<uint16_t>(n - 1));
+      }
+      break;
+  }
+  c.cardinality += static_cast<uint32_t>(n);
+  // Fall back to a bitset once the runs take more space.
+  if (c.kind == container::run
+      && c.values.size() * sizeof(uint16_t) > chunk_blocks * sizeof(block_type))
+    optimize(c);
+}
+
+enum class bitwise_operation { and_, or_, xor_, nand };
+
+// Combines two containers with the same key. The result may be empty.
+container combine(const container& l, const container& r,
+                  bitwise_operation op) {
+  auto filter = [](const container& xs, const container& ys, bool member) {
+    container result{xs.key, container::array, 0, {}, {}};
+    for (auto x : xs.values)
+      if (contains(ys, x) == member)
+        result.values.push_back(x);
+    result.cardinality = static_cast<uint32_t>(result.values.size());
+    return result;
+  };
+  auto merge = [&](auto algorithm) {
+    container result{l.key, container::array, 0, {}, {}};
+    algorithm(l.values.begin(), l.values.end(), r.values.begin(),
+              r.values.end(), std::back_inserter(result.values));
+    result.cardinality = static_cast<uint32_t>(result.values.size());
+    return result;
+  };
+  // Sparse containers need not go through the bitset representation.
+  if (l.kind == container::array) {
+    if (op == bitwise_operation::and_)
+      return filter(l, r, true);
+    if (op == bitwise_operation::nand)
+      return filter(l, r, false);
+  }
+  if (r.kind == container::array && op == bitwise_operation::and_)
+    return filter(r, l, true);
+  if (l.kind == container::array && r.kind == container::array
+      && l.cardinality + r.cardinality <= roaring_bitmap::max_array_size) {
+    if (op == bitwise_operation::or_)
+      return merge([](auto... xs) { return std::set_union(xs...); });
+    if (op == bitwise_operation::xor_)
+      return merge(
+        [](auto... xs) { return std::set_symmetric_difference(xs...); });
+  }
+  std::vector<block_type> xs(2 * chunk_blocks);
+  auto lhs = xs.data();
+  auto rhs = xs.data() + chunk_blocks;
+  materialize(l, lhs);
+  materialize(r, rhs);
+  switch (op) {
+    case bitwise_operation::and_:
+      detail::block_and(lhs, rhs, lhs, chunk_blocks);
+      break;
+    case bitwise_operation::or_:
+      detail::block_or(lhs, rhs, lhs, chunk_blocks);
+      break;
+    case bitwise_operation::xor_:
+      detail::block_xor(lhs, rhs, lhs, chunk_blocks);
+      break;
+    case bitwise_operation::nand:
+      detail::block_and_not(lhs, rhs, lhs, chunk_blocks);
+      break;
+  }
+  return make_container(l.key, lhs);
+}
+
+roaring_bitmap::container_vector
+combine(const roaring_bitmap& lhs, const roaring_bitmap& rhs,
+        bitwise_operation op) {
+  auto keep_lhs = op != bitwise_operation::and_;
+  auto keep_rhs = op == bitwise_operation::or_ || op == bitwise_operation::xor_;
+  roaring_bitmap::container_vector result;
+  auto& xs = lhs.containers();
+  auto& ys = rhs.containers();
+  auto x = xs.begin();
+  auto y = ys.begin();
+  while (x != xs.end() || y != ys.end()) {
+    if (y == ys.end() || (x != xs.end() && x->key < y->key)) {
+      if (keep_lhs)
+        result.push_back(*x);
+      ++x;
+    } else if (x == xs.end() || y->key < x->key) {
+      if (keep_rhs)
+        result.push_back(*y);
+      ++y;
+    } else {
+      auto c = combine(*x, *y, op);
+      if (c.cardinality > 0)
+        result.push_back(std::move(c));
+      ++x;
+      ++y;
+    }
+  }
+  return result;
+}
+
+} // namespace <anonymous>
+
+bool operator==(const container& x, const container& y) {
+  if (x.key != y.key || x.cardinality != y.cardinality)
+    return false;
+  if (x.kind == y.kind)
+    return x.values == y.values && x.blocks == y.blocks;
+  // The same bits may have a different representation, depending on the
+  // order in which they were appended.
+  std::vector<block_type> xs(2 * chunk_blocks);
+  materialize(x, xs.data());
+  materialize(y, xs.data() + chunk_blocks);
+  return std::equal(xs.begin(), xs.begin() + chunk_blocks,
+                    xs.begin() + chunk_blocks);
+}
+
+roaring_bitmap::roaring_bitmap(size_type n, bool bit) {
+  append_bits(bit, n);
+}
+
+roaring_bitmap::roaring_bitmap(container_vector xs, size_type n)
+  : containers_{std::move(xs)},
+    num_bits_{n} {
+}
+
+bool roaring_bitmap::empty() const {
+  return num_bits_ == 0;
+}
+
+roaring_bitmap::size_type roaring_bitmap::size() const {
+  return num_bits_;
+}
+
+const roaring_bitmap::container_vector& roaring_bitmap::containers() const {
+  return containers_;
+}
+
+bool roaring_bitmap::operator[](size_type i) const {
+  VAST_ASSERT(i < num_bits_);
+  auto key = i / chunk_size;
+  auto pred = [](const container& c, uint64_t k) { return c.key < k; };
+  auto c = std::lower_bound(containers_.begin(), containers_.end(), key, pred);
+  return c != containers_.end() && c->key == key
+         && contains(*c, static_cast<uint16_t>(i % chunk_size));
+}
+
+size_t roaring_bitmap::memusage() const {
+  auto result = containers_.size() * sizeof(container);
+  for (auto& c : containers_)
+    result += c.values.size() * sizeof(uint16_t)
+              + c.blocks.size() * sizeof(block_type);
+  return result;
+}
+
+void roaring_bitmap::append_bit(bool bit) {
+  if (bit)
+    append_ones(num_bits_, num_bits_ + 1);
+  ++num_bits_;
+}
+
+void roaring_bitmap::append_bits(bool bit, size_type n) {
+  if (bit && n > 0)
+    append_ones(num_bits_, num_bits_ + n);
+  num_bits_ += n;
+}
+
+void roaring_bitmap::append_block(block_type bits, size_type n) {
+  VAST_ASSERT(n > 0);
+  VAST_ASSERT(n <= word_type::width);
+  bits &= word_type::lsb_fill(n);
+  // Append runs of 1s rather than single bits.
+  while (bits != 0) {
+    auto first = word_type::count_trailing_zeros(bits);
+    auto length = word_type::count_trailing_ones(bits >> first);
+    append_ones(num_bits_ + first, num_bits_ + first + length);
+    bits &= first + length < word_type::width
+              ? word_type::all << (first + length)
+              : word_type::none;
+  }
+  num_bits_ += n;
+}
+
+void roaring_bitmap::flip() {
+  container_vector result;
+  std::vector<block_type> xs(chunk_blocks);
+  auto x = containers_.begin();
+  auto chunks = (num_bits_ + chunk_size - 1) / chunk_size;
+  for (auto key = uint64_t{0}; key < chunks; ++key) {
+    auto n = std::min(chunk_size, num_bits_ - key * chunk_size);
+    if (x == containers_.end() || x->key != key) {
+      // A missing container turns into a single run of 1s.
+      result.push_back({key, container::run, static_cast<uint32_t>(n),
+                        {0, static_cast<uint16_t>(n - 1)}, {}});
+      continue;
+    }
+    materialize(*x++, xs.data());
+    for (auto& block : xs)
+      block = ~block;
+    std::fill(xs.begin() + (n + word_type::width - 1) / word_type::width,
+              xs.end(), word_type::none);
+    if (n % word_type::width != 0)
+      xs[n / word_type::width] &= word_type::lsb_fill(n % word_type::width);
+    auto c = make_container(key, xs.data());
+    if (c.cardinality > 0)
+      result.push_back(std::move(c));
+  }
+  containers_ = std::move(result);
+}
+
+void roaring_bitmap::append_ones(size_type first, size_type last) {
+  while (first < last) {
+    auto key = first / chunk_size;
+    if (containers_.empty() || containers_.back().key != key) {
+      // Bring the previous container into its final shape before starting
+      // a new one.
+      if (!containers_.empty())
+        optimize(containers_.back());
+      containers_.push_back({key, container::run, 0, {}, {}});
+    }
+    auto offset = key * chunk_size;
+    auto end = std::min(last - offset, chunk_size);
+    append_range(containers_.back(), first - offset, end);
+    first = offset + end;
+  }
+}
+
+bool operator==(const roaring_bitmap& x, const roaring_bitmap& y) {
+  return x.num_bits_ == y.num_bits_ && x.containers_ == y.containers_;
+}
+
+roaring_bitmap binary_and(const roaring_bitmap& lhs,
+                          const roaring_bitmap& rhs) {
+  return {combine(lhs, rhs, bitwise_operation::and_),
+          std::max(lhs.size(), rhs.size())};
+}
+
+roaring_bitmap binary_or(const roaring_bitmap& lhs,
+                         const roaring_bitmap& rhs) {
+  return {combine(lhs, rhs, bitwise_operation::or_),
+          std::max(lhs.size(), rhs.size())};
+}
+
+roaring_bitmap binary_xor(const roaring_bitmap& lhs,
+                          const roaring_bitmap& rhs) {
+  return {combine(lhs, rhs, bitwise_operation::xor_),
+          std::max(lhs.size(), rhs.size())};
+}
+
+roaring_bitmap binary_nand(const roaring_bitmap& lhs,
+                           const roaring_bitmap& rhs) {
+  // Like the generic algorithm, the result extends to the end of the last
+  // block of the LHS.
+  auto size = lhs.size();
+  auto partial = size % word_type::width;
+  if (size < rhs.size() && partial != 0)
+    size = std::min(rhs.size(), size + word_type::width - partial);
+  return {combine(lhs, rhs, bitwise_operation::nand), size};
+}
+
+
+roaring_bitmap_range::roaring_bitmap_range(const roaring_bitmap& bm)
+  : bm_{&bm},
+    num_blocks_{(bm.size() + word_type::width - 1) / word_type::width},
+    done_{bm.empty()} {
+  if (!bm.containers_.empty())
+    buffer_.resize(chunk_blocks);
+  if (!done_)
+    scan();
+}
+
+void roaring_bitmap_range::next() {
+  if (block_ == num_blocks_)
+    done_ = true;
+  else
+    scan();
+}
+
+bool roaring_bitmap_range::done() const {
+  return done_;
+}
+
+void roaring_bitmap_range::scan() {
+  // Emits a sequence of blocks, taking into account that the last block may
+  // be partial.
+  auto emit = [&](block_type x, size_type n) {
+    block_ += n;
+    auto bits = n * word_type::width;
+    if (block_ == num_blocks_)
+      bits -= num_blocks_ * word_type::width - bm_->size();
+    bits_ = {x, bits};
+  };
+  auto& xs = bm_->containers_;
+  auto key = block_ / chunk_blocks;
+  if (container_ == xs.size() || xs[container_].key > key) {
+    // Emit the 0s up to the next container.
+    auto end = num_blocks_;
+    if (container_ < xs.size())
+      end = std::min(end, xs[container_].key * chunk_blocks);
+    emit(word_type::none, end - block_);
+    return;
+  }
+  auto offset = block_ - key * chunk_blocks;
+  if (offset == 0)
+    materialize(xs[container_], buffer_.data());
+  auto end = std::min(chunk_blocks, num_blocks_ - key * chunk_blocks);
+  auto x = buffer_[offset];
+  auto n = size_type{1};
+  if (word_type::all_or_none(x))
+    while (offset + n < end && buffer_[offset + n] == x)
+      ++n;
+  if (offset + n == chunk_blocks)
+    ++container_;
+  emit(x, n);
+}
+
+roaring_bitmap_range bit_range(const roaring_bitmap& bm) {
+  return roaring_bitmap_range{bm};
+}
+
+} // namespace vast
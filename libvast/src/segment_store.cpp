@@ -4,6 +4,7 @@
 #include "vast/event.hpp"
 #include "vast/load.hpp"
 #include "vast/logger.hpp"
+#include "vast/rank_select_directory.hpp"
 #include "vast/save.hpp"
 #include "vast/segment_store.hpp"
 
@@ -125,25 +126,21 @@ expected<void> segment_store::flush() {
 }
 
 expected<std::vector<event>> segment_store::get(const ids& xs) {
-  // Collect candidate segments by seeking through the ID set and
-  // probing each ID interval.
+  // Collect candidate segments by probing each ID interval for at least one
+  // ID from the query. With a rank/select directory over the ID set, each
+  // probe takes logarithmic time.
   std::vector<const uuid*> candidates;
-  auto ones = select(xs);
-  auto i = segments_.begin();
-  auto end = segments_.end();
-  while (ones && i != end) {
-    if (ones.get() < i->left) {
-      // Bitmap must catch up, segment is ahead.
-      ones.skip(i->left - ones.get());
-    } else if (ones.get() < i->right) {
-      // Match: bitmap is within an existing segment.
-      candidates.push_back(&i->value);
-      ones.skip(i->right - ones.get());
-      ++i;
-    } else {
-      // Segment must catch up, bitmap is ahead.
-      ++i;
-    }
+  rank_select_directory<ids> dir{xs};
+  if (rank(dir) > 0) {
+    auto ones_before = [&](id x) -> ids::size_type {
+      x = std::min(x, xs.size());
+      return x == 0 ? 0 : rank(dir, x - 1);
+    };
+    auto last = select(dir, -1);
+    for (auto i = segments_.begin(); i != segments_.end() && i->left <= last;
+         ++i)
+      if (ones_before(i->right) > ones_before(i->left))
+        candidates.push_back(&i->value);
   }
   // Process candidates in reverse order to get maximum LRU cache hits.
   std::vector<event> result;
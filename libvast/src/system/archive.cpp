@@ -47,7 +47,7 @@ archive(archive_type::stateful_pointer<archive_state> self,
     }
   );
   return {
-    [=](const std::vector<event>& xs) {
+    [=](const std::vector<event>& xs) -> result<ok_atom> {
       auto first_id = xs.front().id();
       auto last_id  = xs.back().id();
       VAST_DEBUG(self, "got", xs.size(),
@@ -57,7 +57,9 @@ archive(archive_type::stateful_pointer<archive_state> self,
         VAST_ERROR(self, "failed to store events:",
                    self->system().render(result.error()));
         self->quit(result.error());
+        return result.error();
       }
+      return ok_atom::value;
     },
     [=](const ids& xs) {
       VAST_ASSERT(rank(xs) > 0);
@@ -44,6 +44,8 @@ default_application::default_application() {
   import_->add<reader_command<format::bro::reader>>("bro");
   import_->add<reader_command<format::mrt::reader>>("mrt");
   import_->add<reader_command<format::bgpdump::reader>>("bgpdump");
+  import_->add<reader_command<format::csv::reader>>("csv");
+  import_->add<reader_command<format::json::reader>>("json");
   export_ = add<export_command>("export");
   export_->add<writer_command<format::bro::writer>>("bro");
   export_->add<writer_command<format::csv::writer>>("csv");
@@ -181,7 +181,7 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
       for (auto& candidate : candidates) {
         auto& checker = self->state.checkers[candidate.type()];
         // Construct a candidate checker if we don't have one for this type.
-        if (is<none>(checker)) {
+        if (!checker) {
           auto x = tailor(expr, candidate.type());
           if (!x) {
             VAST_ERROR(self, "failed to tailor expression:",
@@ -190,11 +190,11 @@ behavior exporter(stateful_actor<exporter_state>* self, expression expr,
             self->send_exit(self, exit_reason::normal);
             return;
           }
-          checker = std::move(*x);
-          VAST_DEBUG(self, "tailored AST to", candidate.type() << ':', checker);
+          VAST_DEBUG(self, "tailored AST to", candidate.type() << ':', *x);
+          checker = caf::visit(expression_compiler{candidate.type()}, *x);
         }
         // Perform candidate check and keep event as result on success.
-        if (caf::visit(event_evaluator{candidate}, checker))
+        if (checker(candidate))
           self->state.results.push_back(std::move(candidate));
         else
           VAST_DEBUG(self, "ignores false positive:", candidate);
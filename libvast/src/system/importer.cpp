@@ -11,7 +11,8 @@
  * contained in the LICENSE file.                                             *
  ******************************************************************************/
 
-#include <fstream>
+#include <algorithm>
+#include <sstream>
 
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/error.hpp"
@@ -20,6 +21,7 @@
 
 #include "vast/system/atoms.hpp"
 #include "vast/system/importer.hpp"
+#include "vast/system/relay.hpp"
 
 using namespace std::chrono;
 using namespace std::chrono_literals;
@@ -30,43 +32,50 @@ namespace system {
 
 namespace {
 
-// Persists importer state.
+// The time that a lease should last at the current ingest rate.
+constexpr auto lease_interval = 10s;
+
+// Reads the leases that the importer left unused when it last shut down.
+// Since the importer may hand out any ID of a lease while running, it removes
+// the persisted leases right away. After a crash, it thus requests fresh
+// leases instead of reusing IDs.
 expected<void> read_state(stateful_actor<importer_state>* self) {
-  if (exists(self->state.dir / "available")) {
-    std::ifstream available{to_string(self->state.dir / "available")};
-    available >> self->state.available;
-    VAST_DEBUG(self, "found", self->state.available, "local IDs");
-  }
-  if (exists(self->state.dir / "next")) {
-    std::ifstream next{to_string(self->state.dir / "next")};
-    next >> self->state.next;
-    VAST_DEBUG(self, "found next ID:", self->state.next);
-  }
+  auto filename = self->state.dir / "leases";
+  if (!exists(filename))
+    return {};
+  auto contents = load_contents(filename);
+  if (!contents)
+    return contents.error();
+  std::istringstream in{*contents};
+  auto& st = self->state;
+  in >> st.current.next >> st.current.available >> st.reserved.next
+     >> st.reserved.available;
+  if (!in)
+    return make_error(ec::parse_error, "invalid leases in", filename.str());
+  VAST_DEBUG(self, "found", st.current.available, "+",
+             st.reserved.available, "local IDs");
+  if (!rm(filename))
+    return make_error(ec::filesystem_error, "failed to remove",
+                      filename.str());
   return {};
 }
 
-// Reads persistent importer state.
+// Persists the unused part of the current and the reserved lease with a
+// single synchronized write.
 expected<void> write_state(stateful_actor<importer_state>* self) {
-  if (self->state.available > 0) {
-    if (!exists(self->state.dir)) {
-      auto result = mkdir(self->state.dir);
-      if (!result)
-        return result.error();
-    }
-    std::ofstream available{to_string(self->state.dir / "available")};
-    available << self->state.available;
-    VAST_DEBUG(self, "saved", self->state.available, "available IDs");
-  }
-  if (self->state.next > 0) {
-    if (!exists(self->state.dir)) {
-      auto result = mkdir(self->state.dir);
-      if (!result)
-        return result.error();
-    }
-    std::ofstream next{to_string(self->state.dir / "next")};
-    next << self->state.next;
-    VAST_DEBUG(self, "saved next ID:", self->state.next);
-  }
+  auto& st = self->state;
+  if (st.current.available == 0 && st.reserved.available == 0)
+    return {};
+  if (!exists(st.dir))
+    if (auto result = mkdir(st.dir); !result)
+      return result.error();
+  std::ostringstream out;
+  out << st.current.next << ' ' << st.current.available << ' '
+      << st.reserved.next << ' ' << st.reserved.available << '\n';
+  if (auto result = write_contents(st.dir / "leases", out.str()); !result)
+    return result.error();
+  VAST_DEBUG(self, "saved", st.current.available, "+",
+             st.reserved.available, "available IDs");
   return {};
 }
 
@@ -74,7 +83,9 @@ expected<void> write_state(stateful_actor<importer_state>* self) {
 // components.
 auto shutdown(stateful_actor<importer_state>* self) {
   return [=](const exit_msg& msg) {
-    write_state(self);
+    if (auto result = write_state(self); !result)
+      VAST_ERROR(self, "failed to save state:",
+                 self->system().render(result.error()));
     self->anon_send(self->state.archive, sys_atom::value, delete_atom::value);
     self->anon_send(self->state.index, sys_atom::value, delete_atom::value);
     self->send_exit(self->state.archive, msg.reason);
@@ -83,76 +94,132 @@ auto shutdown(stateful_actor<importer_state>* self) {
   };
 }
 
-// Ships a batch of events to archive and index.
-void ship(stateful_actor<importer_state>* self, std::vector<event>&& batch) {
-  VAST_ASSERT(batch.size() <= self->state.available);
+// Returns a function that acknowledges a batch to its source.
+auto acknowledge(response_promise rp) {
+  return [=]() mutable { rp.deliver(ok_atom::value); };
+}
+
+// Ships a batch of events to archive and index, and invokes *f* once both
+// have acknowledged the batch. Continuous queries receive the batch without
+// flow control, so that a slow query cannot stall ingestion.
+template <class F>
+void ship(stateful_actor<importer_state>* self, std::vector<event>&& batch,
+          F f) {
+  auto& lease = self->state.current;
+  VAST_ASSERT(batch.size() <= lease.available);
   for (auto& e : batch)
-    e.id(self->state.next++);
-  self->state.available -= batch.size();
+    e.id(lease.next++);
+  lease.available -= batch.size();
   VAST_DEBUG(self, "ships", batch.size(), "events");
   // TODO: How to retain type safety without copying the entire batch?
+  auto n = batch.size();
   auto msg = make_message(std::move(batch));
-  self->send(actor_cast<actor>(self->state.archive), msg);
-  self->send(self->state.index, msg);
   for (auto& e : self->state.continuous_queries)
     self->send(e, msg);
+  relay(self, {self->state.archive, self->state.index}, msg,
+        [=]() mutable {
+          self->state.acknowledged += n;
+          f();
+        });
 }
 
-// Asks the metastore for more IDs.
-void replenish(stateful_actor<importer_state>* self) {
+void drain(stateful_actor<importer_state>* self);
+
+// Requests the next lease from the meta store in the background, unless we
+// already hold or await one.
+void lease(stateful_actor<importer_state>* self) {
+  auto& st = self->state;
+  if (st.leasing || st.reserved.available > 0 || !st.meta_store)
+    return;
   auto now = steady_clock::now();
-  if (now - self->state.last_replenish < 10s) {
-    VAST_DEBUG(self, "had to replenish twice within 10 secs");
-    VAST_DEBUG(self, "doubles batch size:", self->state.batch_size,
-                    "->", self->state.batch_size * 2);
-    self->state.batch_size *= 2;
+  // Size the lease such that it lasts for about one lease interval at the
+  // rate at which archive and index acknowledge events. The lease thus
+  // shrinks when they slow down and grows geometrically while they keep up.
+  if (st.last_lease != steady_clock::time_point::min()) {
+    using fractional_seconds = duration<double>;
+    auto elapsed = duration_cast<fractional_seconds>(now - st.last_lease);
+    auto interval = duration_cast<fractional_seconds>(lease_interval);
+    auto rate = st.acknowledged / elapsed.count();
+    auto n = static_cast<size_t>(rate * interval.count());
+    n = std::clamp(n, st.min_batch_size, st.batch_size * 2);
+    if (n != st.batch_size) {
+      VAST_DEBUG(self, "adjusts lease size to acknowledged rate of",
+                 size_t(rate), "events/sec:", st.batch_size, "->", n);
+      st.batch_size = n;
+    }
   }
-  if (self->state.remainder.size() > self->state.batch_size) {
-    VAST_DEBUG(self, "raises batch size to buffered events:",
-               self->state.batch_size, "->", self->state.remainder.size());
-    self->state.batch_size = self->state.remainder.size();
+  // Make sure that a single lease covers all buffered events.
+  size_t buffered = 0;
+  for (auto& x : st.remainder)
+    buffered += x.first.size();
+  if (buffered > st.batch_size) {
+    VAST_DEBUG(self, "raises lease size to buffered events:",
+               st.batch_size, "->", buffered);
+    st.batch_size = buffered;
   }
-  self->state.last_replenish = now;
-  VAST_DEBUG(self, "replenishes", self->state.batch_size, "IDs");
-  VAST_ASSERT(max_id - self->state.next >= self->state.batch_size);
-  auto n = self->state.batch_size;
-  // If we get an EXIT message while expecting a response from the metastore,
-  // we'll give it a bit of time to come back;
-  self->set_exit_handler(
-    [=](const exit_msg& msg) {
-      self->delayed_send(self, 5s, msg);
-      self->set_exit_handler(shutdown(self));
-    }
-  );
-  self->send(self->state.meta_store, add_atom::value, "id", data{n});
-  self->become(
-    keep_behavior,
+  st.acknowledged = 0;
+  st.last_lease = now;
+  VAST_DEBUG(self, "requests a lease of", st.batch_size, "IDs");
+  if (st.accountant)
+    self->send(st.accountant, "importer.ids.block", uint64_t{st.batch_size});
+  auto n = st.batch_size;
+  st.leasing = true;
+  self->request(st.meta_store, infinite, add_atom::value, "id", data{n}).then(
     [=](const data& old) {
       auto x = is<none>(old) ? count{0} : get<count>(old);
       VAST_DEBUG(self, "got", n, "new IDs starting at", x);
-      self->state.available = n;
-      self->state.next = x;
-      if (!self->state.remainder.empty())
-        ship(self, std::move(self->state.remainder));
-      auto result = write_state(self);
-      if (!result) {
-        VAST_ERROR(self, "failed to save state:",
-                   self->system().render(result.error()));
-        self->quit(result.error());
-      }
-      self->set_exit_handler(shutdown(self));
-      self->unbecome();
+      VAST_ASSERT(max_id - x >= n);
+      self->state.leasing = false;
+      self->state.reserved = {x, n};
+      drain(self);
+    },
+    [=](const error& e) {
+      VAST_ERROR(self, "failed to lease IDs:", self->system().render(e));
+      self->quit(e);
     }
   );
 }
 
+// Assigns IDs to buffered batches and ships them for as long as the leases
+// last. A batch that spans two leases ships in two parts. Since archive and
+// index process batches in order, acknowledging the last part implies that
+// they also processed the first.
+void drain(stateful_actor<importer_state>* self) {
+  auto& st = self->state;
+  while (!st.remainder.empty()) {
+    auto& [events, rp] = st.remainder.front();
+    if (events.size() <= st.current.available) {
+      ship(self, std::move(events), acknowledge(std::move(rp)));
+      st.remainder.pop_front();
+      continue;
+    }
+    if (st.current.available > 0) {
+      auto first = events.begin();
+      auto last = first + st.current.available;
+      std::vector<event> head(std::make_move_iterator(first),
+                              std::make_move_iterator(last));
+      events.erase(first, last);
+      ship(self, std::move(head), [] {});
+    }
+    if (st.reserved.available == 0)
+      break;
+    VAST_DEBUG(self, "switches to lease of", st.reserved.available,
+               "IDs starting at", st.reserved.next);
+    st.current = st.reserved;
+    st.reserved = {};
+  }
+  if (st.reserved.available == 0)
+    lease(self);
+}
+
 } // namespace <anonymous>
 
 behavior importer(stateful_actor<importer_state>* self, path dir,
                   size_t batch_size) {
   self->state.dir = dir;
   self->state.batch_size = batch_size;
-  self->state.last_replenish = steady_clock::time_point::min();
+  self->state.min_batch_size = batch_size;
+  self->state.last_lease = steady_clock::time_point::min();
   auto result = read_state(self);
   if (!result) {
     VAST_ERROR(self, "failed to load state:",
@@ -160,6 +227,8 @@ behavior importer(stateful_actor<importer_state>* self, path dir,
     self->quit(result.error());
     return {};
   }
+  if (auto acc = self->system().registry().get(accountant_atom::value))
+    self->state.accountant = actor_cast<accountant_type>(acc);
   auto eu = self->system().dummy_execution_unit();
   self->state.archive = actor_pool::make(eu, actor_pool::round_robin());
   self->monitor(self->state.archive);
@@ -205,29 +274,17 @@ behavior importer(stateful_actor<importer_state>* self, path dir,
     [=](std::vector<event>& events) {
       VAST_ASSERT(!events.empty());
       VAST_DEBUG(self, "got", events.size(), "events");
-      VAST_DEBUG(self, "has", self->state.available, "IDs available");
+      VAST_DEBUG(self, "has", self->state.current.available, "+",
+                 self->state.reserved.available, "IDs available");
       if (!self->state.meta_store) {
         self->quit(make_error(ec::unspecified, "no meta store configured"));
         return;
       }
-      if (events.size() <= self->state.available) {
-        // Ship the events immediately if we have enough IDs.
-        ship(self, std::move(events));
-      } else if (self->state.available > 0) {
-        // Ship a subset if we have any IDs left.
-        auto remainder = std::vector<event>(
-          std::make_move_iterator(events.begin() + self->state.available),
-          std::make_move_iterator(events.end()));
-        events.resize(self->state.available);
-        ship(self, std::move(events));
-        self->state.remainder = std::move(remainder);
-      } else {
-        // Buffer events otherwise.
-        self->state.remainder = std::move(events);
-      }
-      auto running_low = self->state.available < self->state.batch_size * 0.1;
-      if (running_low || !self->state.remainder.empty())
-        replenish(self);
+      // The source receives our acknowledgement once archive and index have
+      // processed the entire batch, which returns its credit.
+      self->state.remainder.emplace_back(std::move(events),
+                                         self->make_response_promise());
+      drain(self);
     }
   };
 }
@@ -30,8 +30,11 @@
 #include "vast/save.hpp"
 
 #include "vast/system/accountant.hpp"
+#include "vast/system/atoms.hpp"
+#include "vast/system/collect_statistics.hpp"
 #include "vast/system/index.hpp"
 #include "vast/system/partition.hpp"
+#include "vast/system/relay.hpp"
 #include "vast/system/task.hpp"
 
 #include "vast/detail/cache.hpp"
@@ -55,6 +58,11 @@ void partition_index::add(const std::vector<event> xs, const uuid& partition) {
   // Update index.
   auto& x = partitions_[partition];
   x.range = bound(x.range, result);
+  for (auto& e : xs) {
+    x.ids.from = std::min(x.ids.from, e.id());
+    x.ids.to = std::max(x.ids.to, e.id());
+  }
+  x.events += xs.size();
 }
 
 std::vector<uuid> partition_index::lookup(const expression& expr) const {
@@ -65,6 +73,62 @@ std::vector<uuid> partition_index::lookup(const expression& expr) const {
   return result;
 }
 
+std::vector<uuid> partition_index::compaction_candidates(
+  size_t max_events, const detail::flat_set<uuid>& excluded) const {
+  using value_type = decltype(partitions_)::value_type;
+  std::vector<const value_type*> xs;
+  xs.reserve(partitions_.size());
+  for (auto& x : partitions_)
+    xs.push_back(&x);
+  auto cmp = [](auto x, auto y) {
+    return x->second.range.from < y->second.range.from;
+  };
+  std::sort(xs.begin(), xs.end(), cmp);
+  std::vector<uuid> result;
+  std::vector<id_interval> ids;
+  uint64_t events = 0;
+  for (auto x : xs) {
+    auto& [id, synopsis] = *x;
+    auto overlaps = [own = synopsis.ids](auto& y) {
+      return own.from <= y.to && y.from <= own.to;
+    };
+    auto skip = synopsis.events > max_events || excluded.count(id) > 0;
+    if (skip || events + synopsis.events > max_events
+        || std::any_of(ids.begin(), ids.end(), overlaps)) {
+      // The current run ends before this partition.
+      if (result.size() > 1)
+        return result;
+      result.clear();
+      ids.clear();
+      events = 0;
+      if (skip)
+        continue;
+    }
+    result.push_back(id);
+    ids.push_back(synopsis.ids);
+    events += synopsis.events;
+  }
+  if (result.size() < 2)
+    result.clear();
+  return result;
+}
+
+void partition_index::replace(const std::vector<uuid>& xs,
+                              const uuid& partition) {
+  auto& y = partitions_[partition];
+  for (auto& x : xs) {
+    auto i = partitions_.find(x);
+    if (i == partitions_.end())
+      continue;
+    y.range.from = std::min(y.range.from, i->second.range.from);
+    y.range.to = std::max(y.range.to, i->second.range.to);
+    y.ids.from = std::min(y.ids.from, i->second.ids.from);
+    y.ids.to = std::max(y.ids.to, i->second.ids.to);
+    y.events += i->second.events;
+    partitions_.erase(i);
+  }
+}
+
 namespace {
 
 // -- scheduling --------------------------------------------------------------
@@ -85,11 +149,13 @@ void evict(stateful_actor<index_state>* self) {
 void schedule(stateful_actor<index_state>* self, const uuid& part,
               const uuid& lookup) {
   auto& ctx = self->state.lookups[lookup];
-  // If we're dealing with the active partition, we dispatch immediately.
-  if (part == self->state.active.id) {
-    VAST_DEBUG(self, "dispatches to active partition", part);
-    send_as(ctx.sink, self->state.active.partition, ctx.expr);
-    return;
+  // If we're dealing with an active partition, we dispatch immediately.
+  for (auto& [importer, active] : self->state.active) {
+    if (part == active.id) {
+      VAST_DEBUG(self, "dispatches to active partition", part);
+      send_as(ctx.sink, active.partition, ctx.expr);
+      return;
+    }
   }
   // If the partition is loaded, we can also dispatch immediately.
   auto l = self->state.loaded.find(part);
@@ -122,6 +188,19 @@ void schedule(stateful_actor<index_state>* self, const uuid& part,
   }
 }
 
+// Takes an active partition out of service by moving it to the cache, or by
+// shutting it down if the cache is full.
+void retire(stateful_actor<index_state>* self,
+            const active_partition_state& active) {
+  if (self->state.loaded.size() == self->state.capacity) {
+    VAST_DEBUG(self, "evicts active partition", active.id);
+    self->send(active.partition, shutdown_atom::value);
+  } else {
+    VAST_DEBUG(self, "moves active partition to cache", active.id);
+    self->state.loaded.emplace(active.id, active.partition);
+  }
+}
+
 // FIXME: erase lookups that have completed.
 void unschedule(stateful_actor<index_state>* self, const actor& part) {
   // Check if we got an evicted partition.
@@ -151,6 +230,106 @@ void unschedule(stateful_actor<index_state>* self, const actor& part) {
   }
 }
 
+// -- compaction --------------------------------------------------------------
+
+// Merges partitions on disk. Since this blocks on I/O, the job runs in its own
+// thread.
+behavior compactor(event_based_actor* self, path dir, std::vector<path> parts) {
+  return {
+    [=](compact_atom) {
+      auto rp = self->make_response_promise();
+      if (auto result = merge_partitions(dir, parts); !result)
+        rp.deliver(result.error());
+      else
+        rp.deliver(ok_atom::value);
+      self->quit();
+    }
+  };
+}
+
+// Collects the partitions that a compaction must not touch: the ones in
+// memory and the ones that lookups still refer to.
+detail::flat_set<uuid> busy_partitions(stateful_actor<index_state>* self) {
+  detail::flat_set<uuid> result;
+  for (auto& [importer, active] : self->state.active)
+    result.insert(active.id);
+  for (auto& x : self->state.loaded)
+    result.insert(x.first);
+  for (auto& x : self->state.scheduled)
+    result.insert(x.id);
+  for (auto& x : self->state.lookups)
+    result.insert(x.second.partitions.begin(), x.second.partitions.end());
+  return result;
+}
+
+void finish_compaction(stateful_actor<index_state>* self, size_t merged) {
+  for (auto& rp : self->state.compaction.requests)
+    rp.deliver(merged);
+  self->state.compaction = {};
+}
+
+void complete_compaction(stateful_actor<index_state>* self) {
+  auto& st = self->state;
+  auto& parts = st.compaction.partitions;
+  auto dir = st.dir / to_string(st.compaction.id);
+  // A lookup may have started using one of the original partitions in the
+  // meantime, in which case we keep them and discard the merged one.
+  auto busy = busy_partitions(self);
+  auto is_busy = [&](auto& x) { return busy.count(x) > 0; };
+  if (std::any_of(parts.begin(), parts.end(), is_busy)) {
+    VAST_DEBUG(self, "discards merged partition", st.compaction.id);
+    rm(dir);
+    finish_compaction(self, 0);
+    return;
+  }
+  st.part_index.replace(parts, st.compaction.id);
+  if (auto result = save(st.dir / "meta", st.part_index); !result) {
+    VAST_ERROR(self, "failed to persist partition index:",
+               self->system().render(result.error()));
+    self->quit(result.error());
+    return;
+  }
+  st.dirty = false;
+  for (auto& x : parts)
+    rm(st.dir / to_string(x));
+  VAST_DEBUG(self, "merged", parts.size(), "partitions into",
+             st.compaction.id);
+  finish_compaction(self, parts.size());
+}
+
+// Merges a run of small partitions unless a compaction is in progress.
+void compact(stateful_actor<index_state>* self, size_t max_events) {
+  auto& st = self->state;
+  if (!st.compaction.partitions.empty())
+    return;
+  auto parts = st.part_index.compaction_candidates(max_events,
+                                                   busy_partitions(self));
+  if (parts.empty()) {
+    finish_compaction(self, 0);
+    return;
+  }
+  st.compaction.id = uuid::random();
+  st.compaction.partitions = parts;
+  VAST_DEBUG(self, "merges", parts.size(), "partitions into",
+             st.compaction.id);
+  std::vector<path> dirs;
+  for (auto& x : parts)
+    dirs.push_back(st.dir / to_string(x));
+  auto dir = st.dir / to_string(st.compaction.id);
+  auto job = self->spawn<detached>(compactor, dir, std::move(dirs));
+  self->request(job, infinite, compact_atom::value).then(
+    [=](ok_atom) {
+      complete_compaction(self);
+    },
+    [=](const error& e) {
+      VAST_ERROR(self, "failed to merge partitions:",
+                 self->system().render(e));
+      rm(dir);
+      finish_compaction(self, 0);
+    }
+  );
+}
+
 } // namespace <anonymous>
 
 behavior index(stateful_actor<index_state>* self, const path& dir,
@@ -174,35 +353,43 @@ behavior index(stateful_actor<index_state>* self, const path& dir,
       return {};
     }
   }
+  // Merge small partitions from previous runs.
+  compact(self, max_events);
   self->set_exit_handler(
     [=](const exit_msg& msg) {
       auto can_terminate = [=] {
-        return !self->state.active.partition && self->state.loaded.empty();
+        return self->state.active.empty() && self->state.loaded.empty();
       };
+      // Save our own state only if we have written something.
+      auto written = self->state.dirty;
       // Shut down all partitions.
       if (!can_terminate()) {
-        if (self->state.active.partition)
-          self->send(self->state.active.partition, shutdown_atom::value);
+        for (auto& [importer, active] : self->state.active)
+          self->send(active.partition, shutdown_atom::value);
         for (auto& x : self->state.loaded)
           self->send(x.second, shutdown_atom::value);
         self->set_down_handler(
           [=](const down_msg& msg) {
-            if (self->state.active.partition == msg.source) {
-              self->state.active.partition = {};
+            auto is_source = [&](auto& x) {
+              return x.second.partition == msg.source;
+            };
+            auto i = std::find_if(self->state.active.begin(),
+                                  self->state.active.end(), is_source);
+            if (i != self->state.active.end()) {
+              self->state.active.erase(i);
             } else {
               auto pred = [&](auto& x) { return x.second == msg.source; };
-              auto i = std::find_if(self->state.loaded.begin(),
+              auto j = std::find_if(self->state.loaded.begin(),
                                     self->state.loaded.end(), pred);
-              if (i != self->state.loaded.end())
-                self->state.loaded.erase(i);
+              if (j != self->state.loaded.end())
+                self->state.loaded.erase(j);
             }
             if (can_terminate())
               self->quit(msg.reason);
           }
         );
       }
-      // Save our own state only if we have written something.
-      if (self->state.active.partition) {
+      if (written) {
         VAST_DEBUG(self, "persists partition index");
         if (!exists(self->state.dir)) {
           auto result = mkdir(self->state.dir);
@@ -243,6 +430,12 @@ behavior index(stateful_actor<index_state>* self, const path& dir,
         VAST_IGNORE_UNUSED(n);
         VAST_DEBUG(self, "erases", n, "scheduled lookups");
         self->state.scheduled.erase(j, self->state.scheduled.end());
+      } else if (auto a = self->state.active.find(msg.source);
+                 a != self->state.active.end()) {
+        // An importer went down, so its partition receives no more events.
+        VAST_DEBUG(self, "retires partition of importer", msg.source);
+        retire(self, a->second);
+        self->state.active.erase(a);
       } else {
         // A partition went down.
         unschedule(self, actor_cast<actor>(msg.source));
@@ -254,30 +447,32 @@ behavior index(stateful_actor<index_state>* self, const path& dir,
       VAST_DEBUG(self, "got", events.size(), "events ["
                  << events.front().id() << ',' << (events.back().id() + 1)
                  << ')');
-      auto partition_full = self->state.active.events > 0
-        && self->state.active.events + events.size() > max_events;
-      if (partition_full || !self->state.active.partition) {
+      // Each importer fills its own partition.
+      auto importer = actor_cast<actor_addr>(self->current_sender());
+      auto [i, added] = self->state.active.try_emplace(importer);
+      if (added)
+        self->monitor(importer);
+      auto& active = i->second;
+      auto partition_full = active.events > 0
+        && active.events + events.size() > max_events;
+      if (partition_full || !active.partition) {
         if (partition_full) {
           VAST_DEBUG(self, "encountered full partition");
-          if (self->state.loaded.size() == self->state.capacity) {
-            VAST_DEBUG(self, "evicts active partition");
-            self->send(self->state.active.partition, shutdown_atom::value);
-          } else {
-            VAST_DEBUG(self, "moves active partition to cache");
-            self->state.loaded.emplace(self->state.active.id,
-                                       self->state.active.partition);
-          }
+          retire(self, active);
         }
         auto id = uuid::random();
         VAST_DEBUG(self, "spawns new active partition", id);
         auto part_dir = self->state.dir / to_string(id);
         auto part = self->spawn<monitored>(partition, part_dir);
-        self->state.active = {id, part, 0};
+        active = {id, part, 0};
+        if (partition_full)
+          compact(self, max_events);
       }
-      self->state.active.events += events.size();
-      self->state.part_index.add(events, self->state.active.id);
+      active.events += events.size();
+      self->state.part_index.add(events, active.id);
+      self->state.dirty = true;
       auto msg = self->current_mailbox_element()->move_content_to_message();
-      self->send(self->state.active.partition, msg);
+      relay(self, {active.partition}, msg);
     },
     [=](const expression& expr) -> result<uuid, size_t, size_t> {
       auto sender = actor_cast<actor>(self->current_sender());
@@ -321,6 +516,20 @@ behavior index(stateful_actor<index_state>* self, const path& dir,
         schedule(self, *i, id);
       ctx.partitions.resize(ctx.partitions.size() - n);
     },
+    [=](statistics_atom) {
+      // Report the partitions in memory, starting with the active ones.
+      std::vector<std::pair<std::string, actor>> xs;
+      for (auto& [importer, active] : self->state.active)
+        xs.emplace_back(to_string(active.id), active.partition);
+      for (auto& [id, a] : self->state.loaded)
+        xs.emplace_back(to_string(id), a);
+      collect_statistics(self, std::move(xs));
+    },
+    [=](compact_atom) {
+      self->state.compaction.requests.push_back(
+        self->make_response_promise());
+      compact(self, max_events);
+    },
   };
 }
 
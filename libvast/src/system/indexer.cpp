@@ -31,7 +31,9 @@
 #include "vast/value_index.hpp"
 
 #include "vast/system/atoms.hpp"
+#include "vast/system/collect_statistics.hpp"
 #include "vast/system/indexer.hpp"
+#include "vast/system/relay.hpp"
 
 using namespace caf;
 
@@ -44,6 +46,7 @@ struct value_indexer_state {
   vast::type type;
   std::unique_ptr<value_index> idx;
   value_index::size_type last_flush = 0;
+  std::vector<data> batch;
   static inline const char* name = "value-indexer";
 };
 
@@ -72,24 +75,45 @@ behavior value_indexer(stateful_actor<value_indexer_state>* self,
       self->quit(make_error(ec::unspecified, "failed to construct index"));
   }
   return {
-    [=](const std::vector<event>& events) {
+    [=](const std::vector<event>& events) -> result<ok_atom> {
       VAST_TRACE(self, "got", events.size(), "events");
+      // Hand runs of data with consecutive IDs to the index in one go.
+      auto& batch = self->state.batch;
+      auto first = invalid_id;
+      auto flush = [&]() -> expected<void> {
+        if (batch.empty())
+          return {};
+        auto result = self->state.idx->append(batch, first);
+        batch.clear();
+        if (!result) {
+          VAST_ERROR(self->system().render(result.error()));
+          self->quit(result.error());
+          return result.error();
+        }
+        return {};
+      };
       for (auto& e : events) {
         VAST_ASSERT(e.id() != invalid_id);
         if (auto data = extract(e)) {
-          auto result = self->state.idx->push_back(*data, e.id());
-          if (!result) {
-            VAST_ERROR(self->system().render(result.error()));
-            self->quit(result.error());
-            break;
-          }
+          if (!batch.empty() && e.id() != first + batch.size())
+            if (auto result = flush(); !result)
+              return result.error();
+          if (batch.empty())
+            first = e.id();
+          batch.push_back(*data);
         }
       }
+      if (auto result = flush(); !result)
+        return result.error();
+      return ok_atom::value;
     },
     [=](const predicate& pred) -> result<bitmap> {
       VAST_TRACE(self, "got predicate:", pred);
       return self->state.idx->lookup(pred.op, get<data>(pred.rhs));
     },
+    [=](statistics_atom) -> data {
+      return self->state.idx->statistics();
+    },
     [=](shutdown_atom) {
       // Flush index to disk.
       auto offset = self->state.idx->offset();
@@ -121,6 +145,12 @@ behavior value_indexer(stateful_actor<value_indexer_state>* self,
   };
 }
 
+// The type of the event timestamp index. Timestamps arrive mostly in order,
+// which the `sorted` attribute exploits by selecting the ::time_index.
+type time_index_type() {
+  return timestamp_type{}.attributes({{"sorted"}});
+}
+
 // In the current event indexing design, all indexers receive all events and
 // pick the aspect of the event that's relevant to them. For event meta data
 // indexers, every event is relevant. Event data indexers concern themselves
@@ -128,19 +158,11 @@ behavior value_indexer(stateful_actor<value_indexer_state>* self,
 
 behavior time_indexer(stateful_actor<value_indexer_state>* self,
                       const path& p) {
-  // TODO: add type attributes to tune index, e.g., for seconds granularity.
-  auto t = timestamp_type{};
+  auto t = time_index_type();
   auto extract = [](const event& e) { return optional<data>{e.timestamp()}; };
   return value_indexer(self, p, t, extract);
 }
 
-behavior type_indexer(stateful_actor<value_indexer_state>* self,
-                      const path& p) {
-  auto t = string_type{};
-  auto extract = [](const event& e) { return optional<data>{e.type().name()}; };
-  return value_indexer(self, p, t, extract);
-}
-
 // Indexes the data from non-record event type.
 behavior flat_data_indexer(stateful_actor<value_indexer_state>* self,
                            path dir, type event_type) {
@@ -179,6 +201,41 @@ bool skip(const type& t) {
   return std::find_if(attrs.begin(), attrs.end(), pred) != attrs.end();
 }
 
+// Lists the value indexes of an event indexer as paths relative to its
+// directory along with their types, following the layout of EVENT_INDEXER.
+std::vector<std::pair<path, type>> value_index_layout(const type& event_type) {
+  std::vector<std::pair<path, type>> result;
+  result.emplace_back(path{"meta"} / "time", time_index_type());
+  if (skip(event_type))
+    return result;
+  auto r = get_if<record_type>(event_type);
+  if (!r) {
+    result.emplace_back("data", event_type);
+    return result;
+  }
+  for (auto& f : record_type::each{*r}) {
+    auto& value_type = f.trace.back()->type;
+    if (skip(value_type))
+      continue;
+    path p = "data";
+    for (auto& k : f.key())
+      p /= k;
+    result.emplace_back(std::move(p), value_type);
+  }
+  return result;
+}
+
+// Retrieves the time indexer, loading it from disk if necessary.
+actor load_time_indexer(stateful_actor<event_indexer_state>* self) {
+  auto p = self->state.dir / "meta" / "time";
+  auto& a = self->state.indexers[p];
+  if (!a) {
+    VAST_DEBUG(self, "loads time index at", p);
+    a = self->spawn<monitored>(time_indexer, p);
+  }
+  return a;
+}
+
 // Loads indexes for a predicate.
 struct loader {
   using result_type = std::vector<actor>;
@@ -210,23 +267,9 @@ struct loader {
 
   result_type operator()(const attribute_extractor& ex, const data& x) {
     result_type result;
-    auto p = self->state.dir / "meta";
     if (ex.attr == "time") {
       VAST_ASSERT(is<timestamp>(x));
-      p /= ex.attr;
-      VAST_DEBUG(self, "loads time index at", p);
-      auto& a = self->state.indexers[p];
-      if (!a)
-        a = self->spawn<monitored>(time_indexer, p);
-      result.push_back(a);
-    } else if (ex.attr == "type") {
-      VAST_ASSERT(is<std::string>(x));
-      p /= ex.attr;
-      VAST_DEBUG(self, "loads type index at", p);
-      auto& a = self->state.indexers[p];
-      if (!a)
-        a = self->spawn<monitored>(type_indexer, p);
-      result.push_back(a);
+      result.push_back(load_time_indexer(self));
     } else {
       VAST_WARNING(self, "got unsupported attribute:", ex.attr);
     }
@@ -282,9 +325,6 @@ behavior event_indexer(stateful_actor<event_indexer_state>* self,
     auto p = dir / "meta" / "time";
     auto a = self->spawn<monitored>(time_indexer, p);
     self->state.indexers.emplace(p, a);
-    p = dir / "meta" / "type";
-    a = self->spawn<monitored>(type_indexer, p);
-    self->state.indexers.emplace(p, a);
     // Spawn indexers for event data.
     if (skip(event_type)) {
       VAST_DEBUG(self, "skips event:", event_type);
@@ -329,8 +369,11 @@ behavior event_indexer(stateful_actor<event_indexer_state>* self,
   return {
     [=](const std::vector<event>&) {
       auto msg = self->current_mailbox_element()->move_content_to_message();
+      std::vector<actor> indexers;
+      indexers.reserve(self->state.indexers.size());
       for (auto& x : self->state.indexers)
-        self->send(x.second, msg);
+        indexers.push_back(x.second);
+      relay(self, std::move(indexers), msg);
     },
     [=](const predicate& pred) {
       VAST_DEBUG(self, "got predicate:", pred);
@@ -339,6 +382,20 @@ behavior event_indexer(stateful_actor<event_indexer_state>* self,
       // expression, i.e., LHS an extractor type and RHS of type data.
       auto rhs = caf::get_if<data>(&pred.rhs);
       VAST_ASSERT(rhs);
+      // All events of an event indexer have the same type. Hence the answer
+      // to a type predicate is either nothing or every event, i.e., all IDs
+      // with a timestamp, so that we do not need a dedicated type index.
+      if (auto ex = caf::get_if<attribute_extractor>(&pred.lhs);
+          ex && ex->attr == "type") {
+        if (!evaluate(self->state.event_type.name(), pred.op, *rhs)) {
+          rp.deliver(bitmap{});
+          return;
+        }
+        auto all = predicate{attribute_extractor{"time"}, not_equal,
+                             data{nil}};
+        rp.delegate(load_time_indexer(self), std::move(all));
+        return;
+      }
       auto resolved = type_resolver{self->state.event_type}(pred);
       if (!resolved) {
         VAST_DEBUG(self, "failed to resolve predicate:",
@@ -375,6 +432,14 @@ behavior event_indexer(stateful_actor<event_indexer_state>* self,
       for (auto& x : indexers)
         send_as(reducer, x, msg);
     },
+    [=](statistics_atom) {
+      // Name each indexer by its path relative to our directory.
+      std::vector<std::pair<std::string, actor>> xs;
+      auto prefix = self->state.dir.str().size() + 1;
+      for (auto& [p, a] : self->state.indexers)
+        xs.emplace_back(p.str().substr(prefix), a);
+      collect_statistics(self, std::move(xs));
+    },
     [=](shutdown_atom) {
       for (auto& i : self->state.indexers)
         self->send(i.second, shutdown_atom::value);
@@ -390,5 +455,40 @@ behavior event_indexer(stateful_actor<event_indexer_state>* self,
   };
 }
 
+expected<void> merge_event_indexers(const path& dir,
+                                    const std::vector<path>& dirs,
+                                    const type& event_type) {
+  for (auto& [file, t] : value_index_layout(event_type)) {
+    std::vector<std::unique_ptr<value_index>> xs;
+    for (auto& d : dirs) {
+      auto filename = d / file;
+      if (!exists(filename))
+        continue;
+      std::unique_ptr<value_index> idx;
+      value_index::size_type last_flush;
+      detail::value_index_inspect_helper helper{t, idx};
+      if (auto result = load(filename, last_flush, helper); !result)
+        return result.error();
+      xs.push_back(std::move(idx));
+    }
+    if (xs.empty())
+      continue;
+    // Merge the indexes in the order of their IDs.
+    auto cmp = [](auto& x, auto& y) { return x->offset() < y->offset(); };
+    std::sort(xs.begin(), xs.end(), cmp);
+    for (auto i = xs.begin() + 1; i != xs.end(); ++i)
+      if (auto result = xs.front()->merge(**i); !result)
+        return result.error();
+    auto filename = dir / file;
+    if (auto result = mkdir(filename.parent()); !result)
+      return result.error();
+    auto offset = xs.front()->offset();
+    detail::value_index_inspect_helper helper{t, xs.front()};
+    if (auto result = save(filename, offset, helper); !result)
+      return result.error();
+  }
+  return {};
+}
+
 } // namespace system
 } // namespace vast
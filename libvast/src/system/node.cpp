@@ -13,6 +13,7 @@
 
 #include <csignal>
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <sstream>
@@ -31,6 +32,7 @@
 #include "vast/logger.hpp"
 
 #include "vast/system/accountant.hpp"
+#include "vast/system/collect_statistics.hpp"
 #include "vast/system/consensus.hpp"
 #include "vast/system/node.hpp"
 #include "vast/system/spawn.hpp"
@@ -79,10 +81,42 @@ void peer(node_ptr self, message args) {
   rp.delegate(*peer, peer_atom::value, t, self->state.name);
 }
 
-void show(node_ptr self, message /* args */) {
+// Converts data to JSON, rendering maps with string keys as JSON objects.
+json to_json(const data& x) {
+  if (auto xs = get_if<map>(x)) {
+    auto has_string_key = [](auto& kvp) { return is<std::string>(kvp.first); };
+    if (std::all_of(xs->begin(), xs->end(), has_string_key)) {
+      json::object result;
+      for (auto& [key, value] : *xs)
+        result.emplace(get<std::string>(key), to_json(value));
+      return json{std::move(result)};
+    }
+  }
+  json result;
+  convert(x, result);
+  return result;
+}
+
+void show(node_ptr self, message args) {
   auto rp = self->make_response_promise();
+  // With "statistics" as argument, we show the statistics of the value
+  // indexes in memory instead of the components.
+  auto show_statistics = !args.empty() && args.match_element<std::string>(0)
+                         && args.get_as<std::string>(0) == "statistics";
   self->request(self->state.tracker, infinite, get_atom::value).then(
     [=](const registry& reg) mutable {
+      if (show_statistics) {
+        std::vector<std::pair<std::string, actor>> xs;
+        auto i = reg.components.find(self->state.name);
+        if (i != reg.components.end())
+          for (auto& [component, state] : i->second)
+            if (component == "index")
+              xs.emplace_back(state.label, state.actor);
+        collect_statistics(self, std::move(xs), [=](data& x) mutable {
+          rp.deliver(to_string(to_json(x)));
+        });
+        return;
+      }
       json::object result;
       for (auto& peer : reg.components) {
         json::array xs;
@@ -84,9 +84,14 @@ expected<actor> node_command::spawn_node(scoped_actor& self,
     auto err = error::eval(
       spawn_component("metastore"),
       spawn_component("archive"),
-      spawn_component("index"),
-      spawn_component("importer")
+      spawn_component("index")
     );
+    // Each importer leases its own ID ranges from the metastore, so that
+    // several of them can ingest in parallel. The tracker connects every
+    // source to all importers, which the source then feeds round-robin.
+    auto importers = get_or<uint64_t>(opts, "importers", 1u);
+    for (uint64_t i = 0; !err && i < importers; ++i)
+      err = spawn_component("importer")();
     if (err) {
       VAST_ERROR(self->system().render(err));
       cleanup(node);
@@ -13,6 +13,7 @@
 
 #include <caf/all.hpp>
 
+#include "vast/bitmap_evaluator.hpp"
 #include "vast/ids.hpp"
 #include "vast/concept/parseable/numeric/integral.hpp"
 #include "vast/concept/parseable/to.hpp"
@@ -33,8 +34,10 @@
 
 #include "vast/system/accountant.hpp"
 #include "vast/system/atoms.hpp"
+#include "vast/system/collect_statistics.hpp"
 #include "vast/system/indexer.hpp"
 #include "vast/system/partition.hpp"
+#include "vast/system/relay.hpp"
 #include "vast/system/task.hpp"
 
 #include "vast/detail/flat_set.hpp"
@@ -80,52 +83,62 @@ behavior collector(stateful_actor<collector_state>* self, predicate pred,
   };
 }
 
-struct ids_evaluator {
-  ids_evaluator(const std::unordered_map<predicate, ids>& xs)
-    : xs{xs} {
+// Compiles an expression into a DAG over the hits of its predicates.
+// Predicates without hits become empty leaves.
+struct ids_compiler {
+  using node_id = bitmap_evaluator::node_id;
+
+  ids_compiler(const std::unordered_map<predicate, ids>& xs,
+               bitmap_evaluator& eval)
+    : xs{xs},
+      eval{eval} {
     // nop
   }
 
-  ids operator()(none) const {
-    return {};
+  node_id operator()(none) {
+    return eval.add_leaf(empty);
   }
 
-  ids operator()(const conjunction& c) const {
-    auto result = caf::visit(*this, c[0]);
-    if (result.empty() || all<0>(result))
-      return {};
-    for (size_t i = 1; i < c.size(); ++i) {
-      result &= caf::visit(*this, c[i]);
-      if (result.empty() || all<0>(result)) // short-circuit
-        return {};
-    }
-    return result;
+  node_id operator()(const conjunction& c) {
+    return eval.add_conjunction(operands(c));
   }
 
-  ids operator()(const disjunction& d) const {
-    ids result;
-    for (auto& op : d) {
-      result |= caf::visit(*this, op);
-      if (all<1>(result)) // short-circuit
-        break;
-    }
-    return result;
+  node_id operator()(const disjunction& d) {
+    return eval.add_disjunction(operands(d));
   }
 
-  ids operator()(const negation& n) const {
-    auto result = caf::visit(*this, n.expr());
-    result.flip();
-    return result;
+  node_id operator()(const negation& n) {
+    return eval.add_negation(caf::visit(*this, n.expr()));
   }
 
-  ids operator()(const predicate& pred) const {
+  node_id operator()(const predicate& pred) {
     auto i = xs.find(pred);
-    return i != xs.end() ? i->second : ids{};
+    return eval.add_leaf(i != xs.end() ? i->second : empty);
+  }
+
+  std::vector<node_id> operands(const std::vector<expression>& ops) {
+    std::vector<node_id> result;
+    result.reserve(ops.size());
+    for (auto& op : ops)
+      result.push_back(caf::visit(*this, op));
+    return result;
   }
 
   const std::unordered_map<predicate, ids>& xs;
+  bitmap_evaluator& eval;
+  ids empty;
 };
 
+// Evaluates an expression over the hits of its predicates in a single pass,
+// without materializing the result of every intermediate operator.
+ids evaluate_hits(const expression& expr,
+                  const std::unordered_map<predicate, ids>& xs) {
+  bitmap_evaluator eval;
+  ids_compiler compiler{xs, eval};
+  auto root = caf::visit(compiler, expr);
+  return eval.evaluate(root);
+}
+
 struct evaluator_state {
   ids hits;
   std::unordered_map<predicate, ids> predicates;
@@ -139,7 +152,7 @@ behavior evaluator(stateful_actor<evaluator_state>* self,
   return {
     [=](predicate& pred, ids& hits) {
       self->state.predicates.emplace(std::move(pred), std::move(hits));
-      auto expr_hits = caf::visit(ids_evaluator{self->state.predicates}, expr);
+      auto expr_hits = evaluate_hits(expr, self->state.predicates);
       auto delta = expr_hits - self->state.hits;
       VAST_DEBUG(self, "evaluated",
                  self->state.predicates.size() << '/' << num_predicates,
@@ -198,10 +211,10 @@ behavior partition(stateful_actor<partition_state>* self, path dir) {
         }
         indexers.insert(a);
       }
-      // Forward events to relevant indexers.
+      // Forward events to relevant indexers and acknowledge them once all
+      // indexers did.
       auto msg = self->current_mailbox_element()->move_content_to_message();
-      for (auto& indexer : indexers)
-        self->send(indexer, msg);
+      relay(self, std::vector<actor>(indexers.begin(), indexers.end()), msg);
     },
     [=](const expression& expr) {
       VAST_DEBUG(self, "got expression:", expr);
@@ -209,7 +222,7 @@ behavior partition(stateful_actor<partition_state>* self, path dir) {
       auto rp = self->make_response_promise<ids>();
       // For each known type, check whether the expression could match.
       // If so, locate/load the corresponding indexer.
-      std::vector<actor> indexers;
+      std::vector<std::pair<type, actor>> indexers;
       for (auto& [t, a] : self->state.indexers) {
         auto resolved = caf::visit(type_resolver{t}, expr);
         if (resolved && caf::visit(matcher{t}, *resolved)) {
@@ -219,7 +232,7 @@ behavior partition(stateful_actor<partition_state>* self, path dir) {
             auto indexer_dir = dir / to_digest(t);
             a = self->spawn(event_indexer, indexer_dir, t);
           }
-          indexers.push_back(a);
+          indexers.emplace_back(t, a);
         }
       }
       if (indexers.empty()) {
@@ -256,14 +269,31 @@ behavior partition(stateful_actor<partition_state>* self, path dir) {
       auto predicates = caf::visit(predicatizer{}, expr);
       auto eval = self->spawn(evaluator, expr, predicates.size(), accumulator);
       for (auto& pred : predicates) {
-        // FIXME: locate the smallest subset of indexers (checking whether the
-        // predicate could match the type of the indexer) instead of querying
-        // all indexers.
-        auto coll = self->spawn(collector, pred, eval, indexers.size());
-        for (auto& x : indexers)
+        // Only ask the indexers whose type could match the predicate. The
+        // others would answer with no hits anyway.
+        std::vector<actor> xs;
+        for (auto& [t, a] : indexers) {
+          auto resolved = type_resolver{t}(pred);
+          if (resolved && caf::visit(matcher{t}, *resolved))
+            xs.push_back(a);
+        }
+        if (xs.empty()) {
+          self->send(eval, pred, ids{});
+          continue;
+        }
+        auto coll = self->spawn(collector, pred, eval, xs.size());
+        for (auto& x : xs)
           send_as(coll, x, pred);
       }
     },
+    [=](statistics_atom) {
+      // Only consider event indexers in memory instead of loading all.
+      std::vector<std::pair<std::string, actor>> xs;
+      for (auto& [t, a] : self->state.indexers)
+        if (a)
+          xs.emplace_back(t.name(), a);
+      collect_statistics(self, std::move(xs));
+    },
     [=](shutdown_atom) {
       if (self->state.indexers.empty()) {
         VAST_ASSERT(self->state.meta_data.types.empty());
@@ -308,5 +338,27 @@ behavior partition(stateful_actor<partition_state>* self, path dir) {
   };
 }
 
+expected<void> merge_partitions(const path& dir,
+                                const std::vector<path>& parts) {
+  partition_meta_data meta;
+  std::vector<partition_meta_data> xs(parts.size());
+  for (auto i = 0u; i < parts.size(); ++i) {
+    if (auto result = load(parts[i] / "meta", xs[i]); !result)
+      return result.error();
+    meta.types.insert(xs[i].types.begin(), xs[i].types.end());
+  }
+  for (auto& [digest, t] : meta.types) {
+    std::vector<path> dirs;
+    for (auto i = 0u; i < parts.size(); ++i)
+      if (xs[i].types.count(digest) > 0)
+        dirs.push_back(parts[i] / digest);
+    if (auto result = merge_event_indexers(dir / digest, dirs, t); !result)
+      return result;
+  }
+  if (auto result = mkdir(dir); !result)
+    return result;
+  return save(dir / "meta", meta);
+}
+
 } // namespace system
 } // namespace vast
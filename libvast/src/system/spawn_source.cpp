@@ -27,6 +27,8 @@
 #include "vast/format/bgpdump.hpp"
 #include "vast/format/mrt.hpp"
 #include "vast/format/bro.hpp"
+#include "vast/format/csv.hpp"
+#include "vast/format/json.hpp"
 #ifdef VAST_HAVE_PCAP
 #include "vast/format/pcap.hpp"
 #endif
@@ -86,12 +88,20 @@ expected<actor> spawn_source(local_actor* self, options& opts) {
                                 pseudo_realtime};
     src = self->spawn(source<format::pcap::reader>, std::move(reader));
 #endif
-  } else if (format == "bro" || format == "bgpdump" || format == "mrt") {
+  } else if (format == "bro" || format == "bgpdump" || format == "mrt"
+             || format == "csv" || format == "json") {
     auto in = detail::make_input_stream(input, r.opts.count("uds") > 0);
     if (!in)
       return in.error();
     if (format == "bro") {
-      format::bro::reader reader{std::move(*in)};
+      auto parse_threads = size_t{1};
+      r = r.remainder.extract_opts({
+        {"parse-threads", "number of threads parsing the input",
+         parse_threads}
+      });
+      if (!r.error.empty())
+        return make_error(ec::syntax_error, r.error);
+      format::bro::reader reader{std::move(*in), parse_threads};
       src = self->spawn(source<format::bro::reader>, std::move(reader));
     } else if (format == "bgpdump") {
       format::bgpdump::reader reader{std::move(*in)};
@@ -99,6 +109,12 @@ expected<actor> spawn_source(local_actor* self, options& opts) {
     } else if (format == "mrt") {
       format::mrt::reader reader{std::move(*in)};
       src = self->spawn(source<format::mrt::reader>, std::move(reader));
+    } else if (format == "csv") {
+      format::csv::reader reader{std::move(*in)};
+      src = self->spawn(source<format::csv::reader>, std::move(reader));
+    } else if (format == "json") {
+      format::json::reader reader{std::move(*in)};
+      src = self->spawn(source<format::json::reader>, std::move(reader));
     }
   } else if (format == "test") {
     auto seed = size_t{0};
@@ -37,6 +37,7 @@ using namespace std::chrono_literals;
 start_command::start_command(command* parent, std::string_view name)
   : node_command{parent, name} {
   add_opt("bare", "spawn empty node without any components", false);
+  add_opt("importers", "number of importers to spawn", 1u);
   add_opt("foreground,f", "run in foreground (do not daemonize)", false);
 }
 
@@ -11,9 +11,14 @@
  * contained in the LICENSE file.                                             *
  ******************************************************************************/
 
+#include <algorithm>
 #include <cmath>
+#include <string_view>
+#include <typeinfo>
 
 #include "vast/base.hpp"
+#include "vast/bitmap_algorithms.hpp"
+#include "vast/bitmap_evaluator.hpp"
 #include "vast/concept/parseable/numeric/integral.hpp"
 #include "vast/concept/parseable/to.hpp"
 #include "vast/concept/parseable/vast/base.hpp"
@@ -38,6 +43,71 @@ optional<base> parse_base(const type& t) {
   return base::uniform<64>(10);
 }
 
+optional<size_t> parse_max_size(const type& t) {
+  if (auto a = extract_attribute(t, "max_size")) {
+    if (auto x = to<size_t>(*a))
+      return *x;
+    return {};
+  }
+  return value_index::default_max_size;
+}
+
+// Serializes an optional polymorphic value index of a given type.
+void serialize_index(caf::serializer& sink, const type& t,
+                     const std::unique_ptr<value_index>& x) {
+  auto present = x != nullptr;
+  sink & present;
+  if (present) {
+    auto& idx = const_cast<std::unique_ptr<value_index>&>(x);
+    auto helper = detail::value_index_inspect_helper{t, idx};
+    sink & helper;
+  }
+}
+
+// Deserializes an optional polymorphic value index of a given type.
+void deserialize_index(caf::deserializer& source, const type& t,
+                       std::unique_ptr<value_index>& x) {
+  auto present = false;
+  source & present;
+  if (present) {
+    auto helper = detail::value_index_inspect_helper{t, x};
+    source & helper;
+  } else {
+    x.reset();
+  }
+}
+
+template <class T>
+bool compare(const T& x, relational_operator op, const T& y) {
+  switch (op) {
+    default:
+      return false;
+    case less:
+      return x < y;
+    case less_equal:
+      return x <= y;
+    case greater:
+      return x > y;
+    case greater_equal:
+      return x >= y;
+    case equal:
+      return x == y;
+    case not_equal:
+      return x != y;
+  }
+}
+
+// Appends *y* to *x* such that the first bit of *y* becomes bit *pos* of *x*.
+// The bits of *y* that overlap with *x* must be 0.
+void append_bitmap_at(ewah_bitmap& x, const ewah_bitmap& y, size_t pos) {
+  if (pos >= x.size()) {
+    x.append_bits(false, pos - x.size());
+    x.append(y);
+  } else {
+    x.append(drop(y, x.size() - pos));
+  }
+}
+
 } // namespace <anonymous>
 
 value_index::~value_index() {
@@ -78,6 +148,8 @@ std::unique_ptr<value_index> value_index::make(const type& t) {
       return std::make_unique<arithmetic_index<timespan>>(std::move(*b));
     }
     result_type operator()(const timestamp_type& t) const {
+      if (detail::has_sorted_attribute(t))
+        return std::make_unique<time_index>();
       auto b = parse_base(t);
       if (!b)
         return nullptr;
@@ -105,31 +177,26 @@ std::unique_ptr<value_index> value_index::make(const type& t) {
     result_type operator()(const port_type&) const {
       return std::make_unique<port_index>();
     }
-    result_type operator()(const enumeration_type&) const {
-      return nullptr;
+    result_type operator()(const enumeration_type& t) const {
+      return std::make_unique<enumeration_index>(t);
     }
     result_type operator()(const vector_type& t) const {
-      auto max_size = size_t{1024};
-      if (auto a = extract_attribute(t, "max_size")) {
-        if (auto x = to<size_t>(*a))
-          max_size = *x;
-        else
-          return nullptr;
-      }
-      return std::make_unique<sequence_index>(t.value_type, max_size);
+      auto max_size = parse_max_size(t);
+      if (!max_size)
+        return nullptr;
+      return std::make_unique<sequence_index>(t.value_type, *max_size);
     }
     result_type operator()(const set_type& t) const {
-      auto max_size = size_t{1024};
-      if (auto a = extract_attribute(t, "max_size")) {
-        if (auto x = to<size_t>(*a))
-          max_size = *x;
-        else
-          return nullptr;
-      }
-      return std::make_unique<sequence_index>(t.value_type, max_size);
+      auto max_size = parse_max_size(t);
+      if (!max_size)
+        return nullptr;
+      return std::make_unique<sequence_index>(t.value_type, *max_size);
     }
-    result_type operator()(const map_type&) const {
-      return nullptr;
+    result_type operator()(const map_type& t) const {
+      auto max_size = parse_max_size(t);
+      if (!max_size)
+        return nullptr;
+      return std::make_unique<map_index>(t.key_type, t.value_type, *max_size);
     }
     result_type operator()(const record_type&) const {
       return nullptr;
@@ -148,6 +215,7 @@ expected<void> value_index::push_back(const data& x) {
   } else {
     if (!push_back_impl(x, nils_))
       return make_error(ec::unspecified, "push_back_impl");
+    distinct_.add(std::hash<data>{}(x));
     nils_ = 0;
     none_.append_bit(false);
   }
@@ -155,7 +223,8 @@ expected<void> value_index::push_back(const data& x) {
   return {};
 }
 
-expected<void> value_index::push_back(const data& x, id pos) { 
+expected<void> value_index::push_back(const data& x, id pos) {
+  init_base(pos);
   auto off = offset();
   if (pos < off)
     // Can only append at the end
@@ -166,10 +235,11 @@ expected<void> value_index::push_back(const data& x, id pos) {
   if (is<none>(x)) {
     none_.append_bits(false, skip);
     none_.append_bit(true);
-    ++nils_;
+    nils_ += skip + 1;
   } else {
     if (!push_back_impl(x, skip + nils_))
       return make_error(ec::unspecified, "push_back_impl");
+    distinct_.add(std::hash<data>{}(x));
     nils_ = 0;
     none_.append_bits(false, skip + 1);
   }
@@ -178,22 +248,392 @@ expected<void> value_index::push_back(const data& x, id pos) {
   return {};
 }
 
+expected<void> value_index::append(detail::span<const data> xs, id first) {
+  using block_type = ewah_bitmap::block_type;
+  using word_type = ewah_bitmap::word_type;
+  init_base(first);
+  auto off = offset();
+  if (first < off)
+    // Can only append at the end
+    return make_error(ec::unspecified, first, '<', off);
+  auto skip = first - off;
+  if (!append_impl(xs, skip + nils_))
+    return make_error(ec::unspecified, "append_impl");
+  auto size = static_cast<size_type>(xs.size());
+  none_.append_bits(false, skip);
+  nils_ += skip;
+  for (size_type i = 0; i < size; i += word_type::width) {
+    auto n = std::min<size_type>(size - i, word_type::width);
+    block_type block = 0;
+    for (size_type j = 0; j < n; ++j) {
+      if (is<none>(xs[i + j])) {
+        block |= block_type{1} << j;
+        ++nils_;
+      } else {
+        distinct_.add(std::hash<data>{}(xs[i + j]));
+        nils_ = 0;
+      }
+    }
+    none_.append_block(block, n);
+  }
+  mask_.append_bits(false, skip);
+  mask_.append_bits(true, size);
+  return {};
+}
+
 expected<ids> value_index::lookup(relational_operator op, const data& x) const {
+  auto result = lookup_local(op, x);
+  if (!result)
+    return result;
+  return translate(std::move(*result));
+}
+
+expected<value_index::size_type>
+value_index::estimate(relational_operator op, const data& x) const {
   if (is<none>(x)) {
     if (!(op == equal || op == not_equal))
       return make_error(ec::unsupported_operator, op);
-    return op == equal ? none_ & mask_ : ~none_ & mask_;
+    return op == equal ? rank(none_) : values();
+  }
+  auto n = values();
+  if (n == 0)
+    return size_type{0};
+  auto selectivity = estimate_impl(op, x);
+  if (!selectivity)
+    return selectivity.error();
+  auto result = std::clamp(*selectivity, 0.0, 1.0) * n;
+  return static_cast<size_type>(std::llround(result));
+}
+
+value_index::size_type value_index::distinct() const {
+  return static_cast<size_type>(std::llround(distinct_.estimate()));
+}
+
+data value_index::statistics() const {
+  map result;
+  result.emplace("values", count{values()});
+  result.emplace("nils", count{rank(none_)});
+  result.emplace("distinct", count{distinct()});
+  statistics_impl(result);
+  return result;
+}
+
+expected<void> value_index::merge(const value_index& other, id shift) {
+  if (typeid(*this) != typeid(other))
+    return make_error(ec::type_clash, "cannot merge different value indexes");
+  if (other.mask_.empty())
+    return {};
+  auto first = other.base_ + shift;
+  init_base(first);
+  if (first < base_)
+    return make_error(ec::unspecified, first, '<', base_);
+  // The other index rounds its base down to a word boundary, so its bitmaps
+  // may begin before our end. We can only append at the end, which holds as
+  // long as its first actual entry does not precede our end.
+  auto off = offset();
+  if (first < off) {
+    auto head = select(other.mask_, 1);
+    if (head == ewah_bitmap::word_type::npos)
+      return {};
+    if (first + head < off)
+      return make_error(ec::unspecified, first + head, '<', off);
+  }
+  auto pos = first - base_;
+  if (other.nils_ < other.mask_.size()) {
+    if (!merge_impl(other, pos))
+      return make_error(ec::unspecified, "merge_impl");
+    nils_ = other.nils_;
+  } else {
+    // The other index consists of nils only and leaves the concrete index
+    // untouched.
+    nils_ += pos + other.mask_.size() - mask_.size();
+  }
+  append_bitmap_at(mask_, other.mask_, pos);
+  append_bitmap_at(none_, other.none_, pos);
+  distinct_.merge(other.distinct_);
+  return {};
+}
+
+value_index::size_type value_index::offset() const {
+  return base_ + mask_.size(); // none_ would work just as well.
+}
+
+value_index::size_type value_index::values() const {
+  return rank(mask_) - rank(none_);
+}
+
+expected<double>
+value_index::estimate_impl(relational_operator op, const data& x) const {
+  // Assume that every distinct value occurs equally often.
+  auto uniform = 1.0 / std::max(size_type{1}, distinct());
+  auto elements = [&](auto& xs) -> expected<double> {
+    auto result = 0.0;
+    for (auto& y : xs) {
+      auto selectivity = estimate_impl(equal, y);
+      if (!selectivity)
+        return selectivity;
+      result += *selectivity;
+    }
+    result = std::min(result, 1.0);
+    return op == in ? result : 1.0 - result;
+  };
+  switch (op) {
+    default:
+      // Without any knowledge about the order or structure of the values, we
+      // resort to the traditional guess of one third for range predicates.
+      return 1.0 / 3;
+    case equal:
+      return uniform;
+    case not_equal:
+      return 1.0 - uniform;
+    case in:
+    case not_in:
+      if (auto xs = get_if<vector>(x))
+        return elements(*xs);
+      if (auto xs = get_if<set>(x))
+        return elements(*xs);
+      return 1.0 / 3;
+  }
+}
+
+void value_index::statistics_impl(map&) const {
+  // nop
+}
+
+expected<ids>
+value_index::container_lookup(relational_operator op, const data& x) const {
+  auto lookup = [&](auto& xs) -> expected<ids> {
+    if (!(op == in || op == not_in))
+      return make_error(ec::unsupported_operator, op);
+    std::vector<ids> hits;
+    hits.reserve(xs.size());
+    for (auto& y : xs) {
+      auto r = lookup_local(equal, y);
+      if (!r)
+        return r;
+      hits.push_back(std::move(*r));
+    }
+    // Combine the hits of all elements in a single pass rather than
+    // accumulating them one bitmap at a time.
+    auto base = ids{mask_.size(), op == not_in};
+    if (hits.empty())
+      return base;
+    bitmap_evaluator eval;
+    std::vector<bitmap_evaluator::node_id> leaves;
+    leaves.reserve(hits.size());
+    for (auto& hit : hits)
+      leaves.push_back(eval.add_leaf(hit));
+    auto matches = eval.add_disjunction(std::move(leaves));
+    auto root = op == in
+      ? eval.add_disjunction({eval.add_leaf(base), matches})
+      : eval.add_conjunction({eval.add_leaf(base), eval.add_negation(matches)});
+    return ids{eval.evaluate(root)};
+  };
+  return visit(detail::overload(
+    [&](const auto& x) -> expected<ids> { return make_error(ec::type_clash, x); },
+    [&](const vector& xs) { return lookup(xs); },
+    [&](const set& xs) { return lookup(xs); }
+  ), x);
+}
+
+void value_index::init_base(id first) {
+  if (mask_.empty())
+    base_ = first - first % ewah_bitmap::word_type::width;
+}
+
+expected<ids>
+value_index::lookup_local(relational_operator op, const data& x) const {
+  if (is<none>(x)) {
+    if (!(op == equal || op == not_equal))
+      return make_error(ec::unsupported_operator, op);
+    return op == equal ? none_ & mask_ : mask_ - none_;
   }
   auto result = lookup_impl(op, x);
   if (!result)
     return result;
-  return (*result - none_) & mask_;
+  result->and_not_and(none_, mask_);
+  return result;
 }
 
-value_index::size_type value_index::offset() const {
-  return mask_.size(); // none_ would work just as well.
+ids value_index::translate(ids local) const {
+  if (base_ == 0)
+    return local;
+  if (auto x = detail::ewah_cast(local)) {
+    ewah_bitmap result{base_, false};
+    result.append(*x);
+    return result;
+  }
+  ids result{base_, false};
+  result.append(local);
+  return result;
+}
+
+bool value_index::append_impl(detail::span<const data> xs, size_type skip) {
+  for (auto& x : xs) {
+    if (is<none>(x)) {
+      ++skip;
+    } else {
+      if (!push_back_impl(x, skip))
+        return false;
+      skip = 0;
+    }
+  }
+  return true;
+}
+
+bool time_index::disordered() const {
+  return disordered_;
+}
+
+bool time_index::push_back_impl(const data& x, size_type skip) {
+  auto t = get_if<timestamp>(x);
+  if (!t)
+    return false;
+  append_key(binner_type::bin(t->time_since_epoch().count()), skip);
+  return true;
+}
+
+expected<ids>
+time_index::lookup_impl(relational_operator op, const data& d) const {
+  return visit(detail::overload(
+    [&](const auto& x) -> expected<ids> {
+      return make_error(ec::type_clash, x);
+    },
+    [&](timestamp x) -> expected<ids> {
+      switch (op) {
+        default:
+          return make_error(ec::unsupported_operator, op);
+        case less:
+        case less_equal:
+        case greater:
+        case greater_equal:
+        case equal:
+        case not_equal:
+          return lookup_key(op, binner_type::bin(x.time_since_epoch().count()));
+      }
+    },
+    [&](const vector& xs) { return container_lookup(op, xs); },
+    [&](const set& xs) { return container_lookup(op, xs); }
+  ), d);
+}
+
+bool time_index::merge_impl(const value_index& other, size_type pos) {
+  auto& x = static_cast<const time_index&>(other);
+  if (x.disordered_) {
+    if (!disordered_)
+      fall_back();
+    fallback_.append_at(x.fallback_, pos);
+    size_ = pos + x.size_;
+    values_ += x.values_;
+    return true;
+  }
+  // Replaying the values keeps the table intact if the other index continues
+  // where this one ends.
+  x.each([&](size_type i, value_type key) {
+    append_key(key, pos + i - size_);
+  });
+  return true;
+}
+
+void time_index::append_key(value_type key, size_type skip) {
+  auto pos = size_ + skip;
+  size_ = pos + 1;
+  ++values_;
+  if (disordered_) {
+    fallback_.push_back(key, pos - fallback_.size());
+    return;
+  }
+  sorted_.append_bits(false, pos - sorted_.size());
+  if (runs_.empty() || key >= runs_.back().key) {
+    if (runs_.empty() || key > runs_.back().key)
+      runs_.push_back({key, pos});
+    sorted_.append_bit(true);
+    return;
+  }
+  sorted_.append_bit(false);
+  outliers_.push_back({pos, key});
+  if (outliers_.size() >= min_outliers
+      && outliers_.size() > max_disorder * values_)
+    fall_back();
+}
+
+ids time_index::lookup_key(relational_operator op, value_type key) const {
+  if (disordered_)
+    return fallback_.lookup(op, key);
+  // Determine the positions of the table that satisfy the predicate.
+  auto cmp = [](const run& r, value_type k) { return r.key < k; };
+  auto lb = std::lower_bound(runs_.begin(), runs_.end(), key, cmp);
+  auto ub = lb != runs_.end() && lb->key == key ? lb + 1 : lb;
+  auto position = [&](auto i) { return i == runs_.end() ? size_ : i->first; };
+  auto first = size_type{0};
+  auto last = size_;
+  switch (op) {
+    default:
+      break;
+    case less:
+      last = position(lb);
+      break;
+    case less_equal:
+      last = position(ub);
+      break;
+    case greater:
+      first = position(ub);
+      break;
+    case greater_equal:
+      first = position(lb);
+      break;
+    case equal:
+    case not_equal:
+      first = position(lb);
+      last = position(ub);
+      break;
+  }
+  ewah_bitmap result(first, false);
+  result.append_bits(true, last - first);
+  result.append_bits(false, size_ - last);
+  if (op == not_equal)
+    result = sorted_ - result;
+  else
+    result &= sorted_;
+  // Check the values that break the order one by one.
+  if (!outliers_.empty()) {
+    ewah_bitmap hits;
+    for (auto& x : outliers_) {
+      if (compare(x.key, op, key)) {
+        hits.append_bits(false, x.position - hits.size());
+        hits.append_bit(true);
+      }
+    }
+    hits.append_bits(false, size_ - hits.size());
+    result |= hits;
+  }
+  return result;
 }
 
+void time_index::fall_back() {
+  each([&](size_type pos, value_type key) {
+    fallback_.push_back(key, pos - fallback_.size());
+  });
+  runs_ = {};
+  sorted_ = {};
+  outliers_ = {};
+  disordered_ = true;
+}
+
+template <class F>
+void time_index::each(F f) const {
+  auto r = runs_.begin();
+  auto o = outliers_.begin();
+  for (auto i : select(sorted_)) {
+    for (; o != outliers_.end() && o->position < i; ++o)
+      f(o->position, o->key);
+    while (r + 1 != runs_.end() && (r + 1)->first <= i)
+      ++r;
+    f(i, r->key);
+  }
+  for (; o != outliers_.end(); ++o)
+    f(o->position, o->key);
+}
 
 string_index::string_index(size_t max_length) : max_length_{max_length} {
 }
@@ -222,6 +662,7 @@ bool string_index::push_back_impl(const data& x, size_type skip) {
     chars_[i].push_back(static_cast<uint8_t>((*str)[i]), gap + skip);
   }
   length_.push_back(length, skip);
+  top_.add(std::string_view{*str}.substr(0, length));
   return true;
 }
 
@@ -289,11 +730,55 @@ string_index::lookup_impl(relational_operator op, const data& x) const {
         }
       }
     },
-    [&](const vector& xs) { return detail::container_lookup(*this, op, xs); },
-    [&](const set& xs) { return detail::container_lookup(*this, op, xs); }
+    [&](const vector& xs) { return container_lookup(op, xs); },
+    [&](const set& xs) { return container_lookup(op, xs); }
   ), x);
 }
 
+expected<double>
+string_index::estimate_impl(relational_operator op, const data& x) const {
+  auto str = get_if<std::string>(x);
+  if (!str || !(op == equal || op == not_equal))
+    return value_index::estimate_impl(op, x);
+  auto n = static_cast<double>(values());
+  auto key = std::string_view{*str}.substr(0, max_length_);
+  auto result = 0.0;
+  if (auto e = top_.find(key)) {
+    result = std::min(e->frequency / n, 1.0);
+  } else {
+    // Distribute the values not among the most frequent ones uniformly over
+    // the remaining distinct values.
+    auto entries = top_.entries();
+    auto rest = n;
+    for (auto& e : entries)
+      rest -= e.frequency - e.error;
+    auto others = distinct() > entries.size() ? distinct() - entries.size() : 1;
+    result = std::max(rest, 0.0) / n / others;
+  }
+  return op == equal ? result : 1.0 - result;
+}
+
+bool string_index::merge_impl(const value_index& other, size_type pos) {
+  auto& x = static_cast<const string_index&>(other);
+  if (x.length_.coder().storage().empty())
+    return true;
+  init();
+  length_.append_at(x.length_, pos);
+  if (x.chars_.size() > chars_.size())
+    chars_.resize(x.chars_.size(), char_bitmap_index{8});
+  for (auto i = 0u; i < x.chars_.size(); ++i)
+    chars_[i].append_at(x.chars_[i], pos);
+  top_.merge(x.top_);
+  return true;
+}
+
+void string_index::statistics_impl(map& xs) const {
+  map top;
+  for (auto& e : top_.entries())
+    top.emplace(e.value, count{e.frequency});
+  xs.emplace("top", std::move(top));
+}
+
 void address_index::init() {
   if (bytes_[0].coder().storage().empty())
     // Initialize on first to make deserialization feasible.
@@ -364,11 +849,22 @@ address_index::lookup_impl(relational_operator op, const data& d) const {
         result.flip();
       return result;
     },
-    [&](const vector& xs) { return detail::container_lookup(*this, op, xs); },
-    [&](const set& xs) { return detail::container_lookup(*this, op, xs); }
+    [&](const vector& xs) { return container_lookup(op, xs); },
+    [&](const set& xs) { return container_lookup(op, xs); }
   ), d);
 }
 
+bool address_index::merge_impl(const value_index& other, size_type pos) {
+  auto& x = static_cast<const address_index&>(other);
+  if (x.bytes_[0].coder().storage().empty())
+    return true;
+  init();
+  for (auto i = 0u; i < bytes_.size(); ++i)
+    bytes_[i].append_at(x.bytes_[i], pos);
+  v4_.append_at(x.v4_, pos);
+  return true;
+}
+
 void subnet_index::init() {
   if (length_.coder().storage().empty())
     length_ = prefix_index{128 + 1}; // Valid prefixes range from /0 to /128.
@@ -437,11 +933,20 @@ subnet_index::lookup_impl(relational_operator op, const data& d) const {
         }
       }
     },
-    [&](const vector& xs) { return detail::container_lookup(*this, op, xs); },
-    [&](const set& xs) { return detail::container_lookup(*this, op, xs); }
+    [&](const vector& xs) { return container_lookup(op, xs); },
+    [&](const set& xs) { return container_lookup(op, xs); }
   ), d);
 }
 
+bool subnet_index::merge_impl(const value_index& other, size_type pos) {
+  auto& x = static_cast<const subnet_index&>(other);
+  if (x.length_.coder().storage().empty())
+    return true;
+  init();
+  length_.append_at(x.length_, pos);
+  // The network index operates on our positions relative to the base ID.
+  return !!network_.merge(x.network_, pos);
+}
 
 void port_index::init() {
   if (num_.coder().storage().empty()) {
@@ -473,16 +978,132 @@ port_index::lookup_impl(relational_operator op, const data& d) const {
         return make_error(ec::unsupported_operator, op);
       auto n = num_.lookup(op, x.number());
       if (n.empty() || all<0>(n))
-        return bitmap{offset(), false};
+        return bitmap{num_.size(), false};
       if (x.type() != port::unknown)
         n &= proto_.lookup(equal, x.type());
       return n;
     },
-    [&](const vector& xs) { return detail::container_lookup(*this, op, xs); },
-    [&](const set& xs) { return detail::container_lookup(*this, op, xs); }
+    [&](const vector& xs) { return container_lookup(op, xs); },
+    [&](const set& xs) { return container_lookup(op, xs); }
+  ), d);
+}
+
+bool port_index::merge_impl(const value_index& other, size_type pos) {
+  auto& x = static_cast<const port_index&>(other);
+  if (x.num_.coder().storage().empty())
+    return true;
+  init();
+  num_.append_at(x.num_, pos);
+  proto_.append_at(x.proto_, pos);
+  return true;
+}
+
+enumeration_index::enumeration_index(enumeration_type t) : type_{std::move(t)} {
+}
+
+void enumeration_index::init() {
+  if (index_.coder().storage().empty())
+    index_ = index_type{type_.fields.size()};
+}
+
+bool enumeration_index::push_back_impl(const data& x, size_type skip) {
+  auto e = get_if<enumeration>(x);
+  if (!e || *e >= type_.fields.size())
+    return false;
+  init();
+  index_.push_back(*e, skip);
+  return true;
+}
+
+expected<ids>
+enumeration_index::lookup_impl(relational_operator op, const data& d) const {
+  auto lookup = [&](enumeration x) -> expected<ids> {
+    if (!(op == equal || op == not_equal))
+      return make_error(ec::unsupported_operator, op);
+    if (x >= index_.coder().storage().size())
+      return bitmap{index_.size(), op == not_equal};
+    return index_.lookup(op, x);
+  };
+  return visit(detail::overload(
+    [&](const auto& x) -> expected<ids> {
+      return make_error(ec::type_clash, x);
+    },
+    [&](enumeration x) { return lookup(x); },
+    [&](const std::string& x) {
+      // Resolve the field name to its ordinal value.
+      auto& fields = type_.fields;
+      auto i = std::find(fields.begin(), fields.end(), x);
+      return lookup(static_cast<enumeration>(i - fields.begin()));
+    },
+    [&](const vector& xs) { return container_lookup(op, xs); },
+    [&](const set& xs) { return container_lookup(op, xs); }
   ), d);
 }
 
+bool enumeration_index::merge_impl(const value_index& other, size_type pos) {
+  auto& x = static_cast<const enumeration_index&>(other);
+  if (x.type_ != type_)
+    return false;
+  if (x.index_.coder().storage().empty())
+    return true;
+  init();
+  index_.append_at(x.index_, pos);
+  return true;
+}
+
+namespace detail {
+
+void container_row_map::push_back(size_type n, size_type skip) {
+  auto row = size_ + skip;
+  size_ = row + 1;
+  if (n == 0)
+    return;
+  rows_.append_bits(false, row - rows_.size());
+  rows_.append_bit(true);
+  starts_.append_bit(true);
+  starts_.append_bits(false, n - 1);
+}
+
+void container_row_map::append_at(const container_row_map& other,
+                                  size_type pos) {
+  append_bitmap_at(rows_, other.rows_, pos);
+  starts_.append(other.starts_);
+  size_ = std::max(size_, pos + other.size_);
+}
+
+ids container_row_map::project(const ids& hits) const {
+  using word_type = ewah_bitmap::word_type;
+  ids result;
+  auto starts = select(starts_);
+  auto rows = select(rows_);
+  if (!starts.done()) {
+    // The current row and the element position where the next one begins.
+    auto row = rows.get();
+    starts.next();
+    auto next = starts.done() ? word_type::npos : starts.get();
+    for (auto i : select(hits)) {
+      while (i >= next) {
+        rows.next();
+        row = rows.get();
+        starts.next();
+        next = starts.done() ? word_type::npos : starts.get();
+      }
+      // Multiple elements of the same container map to the same row.
+      if (row >= result.size()) {
+        result.append_bits(false, row - result.size());
+        result.append_bit(true);
+      }
+    }
+  }
+  result.append_bits(false, size_ - result.size());
+  return result;
+}
+
+container_row_map::size_type container_row_map::size() const {
+  return size_;
+}
+
+} // namespace detail
 
 sequence_index::sequence_index(vast::type t, size_t max_size)
   : max_size_{max_size},
@@ -490,11 +1111,9 @@ sequence_index::sequence_index(vast::type t, size_t max_size)
 }
 
 void sequence_index::init() {
-  if (size_.coder().storage().empty()) {
-    size_t components = std::log10(max_size_);
-    if (max_size_ % 10 != 0)
-      ++components;
-    size_ = size_bitmap_index{base::uniform(10, components)};
+  if (!elements_) {
+    elements_ = value_index::make(value_type_);
+    VAST_ASSERT(elements_);
   }
 }
 
@@ -510,72 +1129,167 @@ expected<ids>
 sequence_index::lookup_impl(relational_operator op, const data& x) const {
   if (!(op == ni || op == not_ni))
     return make_error(ec::unsupported_operator, op);
-  if (elements_.empty())
-    return bitmap{};
-  auto result = elements_[0]->lookup(equal, x);
-  if (!result)
-    return result;
-  for (auto i = 1u; i < elements_.size(); ++i) {
-    auto mbm = elements_[i]->lookup(equal, x);
-    if (mbm)
-      *result |= *mbm;
-    else
-      return mbm;
-  }
+  if (!elements_)
+    return bitmap{rows_.size(), op == not_ni};
+  auto hits = elements_->lookup(equal, x);
+  if (!hits)
+    return hits;
+  auto result = rows_.project(*hits);
   if (op == not_ni)
-    result->flip();
+    result.flip();
   return result;
 }
 
+bool sequence_index::merge_impl(const value_index& other, size_type pos) {
+  auto& x = static_cast<const sequence_index&>(other);
+  if (x.value_type_ != value_type_)
+    return false;
+  if (!x.elements_)
+    return true;
+  init();
+  // The elements of the other index follow our elements in the stream.
+  if (!elements_->merge(*x.elements_, elements_->offset()))
+    return false;
+  rows_.append_at(x.rows_, pos);
+  return true;
+}
+
 void serialize(caf::serializer& sink, const sequence_index& idx) {
   sink & static_cast<const value_index&>(idx);
   sink & idx.value_type_;
   sink & idx.max_size_;
-  sink & idx.size_;
-  // Polymorphic indexes.
-  std::vector<detail::value_index_inspect_helper> xs;
-  xs.reserve(idx.elements_.size());
-  std::transform(idx.elements_.begin(),
-                 idx.elements_.end(),
-                 std::back_inserter(xs),
-                 [&](auto& vi) {
-                   auto& t = const_cast<type&>(idx.value_type_);
-                   auto& x = const_cast<std::unique_ptr<value_index>&>(vi);
-                   return detail::value_index_inspect_helper{t, x};
-                 });
-  sink & xs;
+  sink & idx.rows_;
+  serialize_index(sink, idx.value_type_, idx.elements_);
 }
 
 void serialize(caf::deserializer& source, sequence_index& idx) {
   source & static_cast<value_index&>(idx);
   source & idx.value_type_;
   source & idx.max_size_;
-  source & idx.size_;
-  // Polymorphic indexes.
-  size_t n;
-  auto construct = [&] {
-    idx.elements_.resize(n);
-    std::vector<detail::value_index_inspect_helper> xs;
-    xs.reserve(n);
-    std::transform(idx.elements_.begin(),
-                   idx.elements_.end(),
-                   std::back_inserter(xs),
-                   [&](auto& vi) {
-                     auto& t = idx.value_type_;
-                     auto& x = vi;
-                     return detail::value_index_inspect_helper{t, x};
-                   });
-    for (auto& x : xs)
-      source & x;
-    return error{};
-  };
-  auto e = error::eval(
-    [&] { return source.begin_sequence(n); },
-    [&] { return construct(); },
-    [&] { return source.end_sequence(); }
-  );
-  if (e)
-    throw std::runtime_error{to_string(e)};
+  source & idx.rows_;
+  deserialize_index(source, idx.value_type_, idx.elements_);
+}
+
+map_index::map_index(vast::type key_type, vast::type value_type,
+                     size_t max_size)
+  : max_size_{max_size},
+    key_type_{std::move(key_type)},
+    value_type_{std::move(value_type)} {
+}
+
+void map_index::init() {
+  if (!keys_) {
+    keys_ = value_index::make(key_type_);
+    values_ = value_index::make(value_type_);
+    VAST_ASSERT(keys_);
+    VAST_ASSERT(values_);
+  }
+}
+
+bool map_index::push_back_impl(const data& x, size_type skip) {
+  auto m = get_if<map>(x);
+  if (!m)
+    return false;
+  init();
+  auto map_size = std::min(m->size(), max_size_);
+  auto entry = m->begin();
+  // Keys and values join by position, so a rejected key or value becomes nil
+  // rather than putting both streams out of step.
+  for (auto i = 0u; i < map_size; ++i, ++entry) {
+    if (!keys_->push_back(entry->first))
+      keys_->push_back(nil);
+    if (!values_->push_back(entry->second))
+      values_->push_back(nil);
+  }
+  rows_.push_back(map_size, skip);
+  return true;
+}
+
+expected<ids>
+map_index::lookup_impl(relational_operator op, const data& x) const {
+  if (!(op == ni || op == not_ni))
+    return make_error(ec::unsupported_operator, op);
+  auto result = visit(detail::overload(
+    [&](const auto&) { return lookup_key(x); },
+    [&](const map& xs) -> expected<ids> {
+      // A map on the RHS selects all maps that contain all its entries.
+      ids result{rows_.size(), true};
+      for (auto& entry : xs) {
+        auto r = lookup_entry(entry.first, entry.second);
+        if (!r)
+          return r;
+        result &= *r;
+        if (all<0>(result)) // short-circuit
+          break;
+      }
+      return result;
+    }
+  ), x);
+  if (result && op == not_ni)
+    result->flip();
+  return result;
+}
+
+expected<ids> map_index::lookup_key(const data& key) const {
+  if (!keys_)
+    return bitmap{rows_.size(), false};
+  auto hits = keys_->lookup(equal, key);
+  if (!hits)
+    return hits;
+  return rows_.project(*hits);
+}
+
+expected<ids> map_index::lookup_entry(const data& key,
+                                      const data& value) const {
+  if (!keys_)
+    return bitmap{rows_.size(), false};
+  auto hits = keys_->lookup(equal, key);
+  if (!hits)
+    return hits;
+  if (!all<0>(*hits)) {
+    // Join key and value by their position in the entry stream.
+    auto values = values_->lookup(equal, value);
+    if (!values)
+      return values;
+    *hits &= *values;
+  }
+  return rows_.project(*hits);
+}
+
+bool map_index::merge_impl(const value_index& other, size_type pos) {
+  auto& x = static_cast<const map_index&>(other);
+  if (x.key_type_ != key_type_ || x.value_type_ != value_type_)
+    return false;
+  if (!x.keys_ || !x.values_)
+    return true;
+  init();
+  // Keys and values remain aligned because both indexes hold one entry per
+  // map entry.
+  auto entries = keys_->offset();
+  if (!keys_->merge(*x.keys_, entries) || !values_->merge(*x.values_, entries))
+    return false;
+  rows_.append_at(x.rows_, pos);
+  return true;
+}
+
+void serialize(caf::serializer& sink, const map_index& idx) {
+  sink & static_cast<const value_index&>(idx);
+  sink & idx.key_type_;
+  sink & idx.value_type_;
+  sink & idx.max_size_;
+  sink & idx.rows_;
+  serialize_index(sink, idx.key_type_, idx.keys_);
+  serialize_index(sink, idx.value_type_, idx.values_);
+}
+
+void serialize(caf::deserializer& source, map_index& idx) {
+  source & static_cast<value_index&>(idx);
+  source & idx.key_type_;
+  source & idx.value_type_;
+  source & idx.max_size_;
+  source & idx.rows_;
+  deserialize_index(source, idx.key_type_, idx.keys_);
+  deserialize_index(source, idx.value_type_, idx.values_);
 }
 
 } // namespace vast
@@ -0,0 +1,65 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <cmath>
+
+#include "vast/value_statistics.hpp"
+#include "vast/word.hpp"
+
+namespace vast {
+
+void hyperloglog::add(uint64_t digest) {
+  if (registers_.empty())
+    registers_.resize(registers, 0);
+  auto i = digest >> (64 - precision);
+  // The rank is the position of the first 1-bit in the remaining bits, which
+  // we cap at the number of remaining bits plus one.
+  auto w = digest << precision;
+  auto rank = w == 0 ? 64 - precision + 1
+                     : word<uint64_t>::count_leading_zeros(w) + 1;
+  if (registers_[i] < rank)
+    registers_[i] = static_cast<uint8_t>(rank);
+}
+
+void hyperloglog::merge(const hyperloglog& other) {
+  if (other.registers_.empty())
+    return;
+  if (registers_.empty()) {
+    registers_ = other.registers_;
+    return;
+  }
+  for (size_t i = 0; i < registers; ++i)
+    registers_[i] = std::max(registers_[i], other.registers_[i]);
+}
+
+double hyperloglog::estimate() const {
+  if (registers_.empty())
+    return 0.0;
+  auto m = static_cast<double>(registers);
+  auto alpha = 0.7213 / (1.0 + 1.079 / m);
+  auto sum = 0.0;
+  auto zeros = size_t{0};
+  for (auto x : registers_) {
+    sum += std::ldexp(1.0, -x);
+    if (x == 0)
+      ++zeros;
+  }
+  auto result = alpha * m * m / sum;
+  // Use linear counting for small cardinalities, where the raw estimate is
+  // biased. With 64-bit digests, no correction for large ones is necessary.
+  if (result <= 2.5 * m && zeros > 0)
+    result = m * std::log(m / zeros);
+  return result;
+}
+
+} // namespace vast
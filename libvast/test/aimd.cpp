@@ -0,0 +1,65 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/detail/aimd.hpp"
+
+#define SUITE detail
+#include "test.hpp"
+
+using namespace vast;
+using namespace std::chrono_literals;
+
+TEST(aimd additive increase) {
+  detail::aimd x{100, 10, 130, 1s, 10};
+  CHECK(x.observe(500ms, x.epoch()));
+  CHECK_EQUAL(x.value(), 110u);
+  CHECK(x.observe(1s, x.epoch()));
+  CHECK_EQUAL(x.value(), 120u);
+  CHECK(x.observe(0s, x.epoch()));
+  CHECK_EQUAL(x.value(), 130u);
+  MESSAGE("the value never exceeds the maximum");
+  CHECK(!x.observe(0s, x.epoch()));
+  CHECK_EQUAL(x.value(), 130u);
+  CHECK_EQUAL(x.epoch(), 0u);
+}
+
+TEST(aimd multiplicative decrease) {
+  detail::aimd x{100, 10, 1000, 1s, 10};
+  auto epoch = x.epoch();
+  CHECK(x.observe(2s, epoch));
+  CHECK_EQUAL(x.value(), 50u);
+  CHECK_EQUAL(x.epoch(), epoch + 1);
+  MESSAGE("measurements from before the decrease do not back off again");
+  CHECK(!x.observe(3s, epoch));
+  CHECK_EQUAL(x.value(), 50u);
+  CHECK(x.observe(3s, x.epoch()));
+  CHECK_EQUAL(x.value(), 25u);
+  CHECK(x.observe(3s, x.epoch()));
+  CHECK_EQUAL(x.value(), 12u);
+  MESSAGE("the value never falls below the minimum");
+  CHECK(x.observe(3s, x.epoch()));
+  CHECK_EQUAL(x.value(), 10u);
+  CHECK(!x.observe(3s, x.epoch()));
+  CHECK_EQUAL(x.value(), 10u);
+}
+
+TEST(aimd target and value) {
+  detail::aimd x{100, 10, 1000, 1s, 10};
+  x.value(5000);
+  CHECK_EQUAL(x.value(), 1000u);
+  x.value(1);
+  CHECK_EQUAL(x.value(), 10u);
+  x.target(10ms);
+  CHECK(x.target() == timespan{10ms});
+  CHECK(!x.observe(20ms, x.epoch()));
+}
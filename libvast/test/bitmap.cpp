@@ -13,7 +13,11 @@
 
 #include "vast/bitmap.hpp"
 #include "vast/ewah_bitmap.hpp"
+#include "vast/load.hpp"
 #include "vast/null_bitmap.hpp"
+#include "vast/rank_select_directory.hpp"
+#include "vast/roaring_bitmap.hpp"
+#include "vast/save.hpp"
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/bitmap.hpp"
 
@@ -266,6 +270,29 @@ struct bitmap_test_harness {
     CHECK(!rng);
   }
 
+  void test_directory() {
+    MESSAGE("rank/select directory");
+    rank_select_directory<Bitmap> dir{b, 2};
+    CHECK_EQUAL(rank(dir), rank<1>(b));
+    CHECK_EQUAL(rank<0>(dir), rank<0>(b));
+    for (auto i = 1u; i < b.size(); i += 7) {
+      CHECK_EQUAL(rank(dir, i), rank<1>(b, i));
+      CHECK_EQUAL(rank<0>(dir, i), rank<0>(b, i));
+    }
+    for (auto i = 1u; i <= rank<1>(b) + 1; ++i)
+      CHECK_EQUAL(select(dir, i), select<1>(b, i));
+    for (auto i = 1u; i <= rank<0>(b); ++i)
+      CHECK_EQUAL(select<0>(dir, i), select<0>(b, i));
+    CHECK_EQUAL(select(dir, -1), select<1>(b, -1));
+    CHECK_EQUAL(select<0>(dir, -1), select<0>(b, -1));
+    MESSAGE("rank/select directory - empty bitmap");
+    Bitmap empty;
+    rank_select_directory<Bitmap> nil{empty};
+    CHECK_EQUAL(rank(nil), 0u);
+    CHECK_EQUAL(select(nil, 1), Bitmap::word_type::npos);
+    CHECK_EQUAL(select(nil, -1), Bitmap::word_type::npos);
+  }
+
   void test_span() {
     MESSAGE("span");
     // Empty bitmap.
@@ -345,6 +372,7 @@ struct bitmap_test_harness {
     test_bitwise_nary();
     test_rank();
     test_select();
+    test_directory();
     test_span();
     test_all();
     test_any();
@@ -364,6 +392,13 @@ TEST(null_bitmap) {
   execute();
 }
 
+TEST(null_bitmap block append after run) {
+  null_bitmap bm;
+  bm.append_bits(false, 65);
+  bm.append_block(1, 1);
+  CHECK_EQUAL(to_string(bm), std::string(65, '0') + '1');
+}
+
 FIXTURE_SCOPE_END()
 
 FIXTURE_SCOPE(ewah_bitmap_tests, bitmap_test_harness<ewah_bitmap>)
@@ -382,6 +417,14 @@ TEST(wah_bitmap) {
 
 FIXTURE_SCOPE_END()
 
+FIXTURE_SCOPE(roaring_bitmap_tests, bitmap_test_harness<roaring_bitmap>)
+
+TEST(roaring_bitmap) {
+  execute();
+}
+
+FIXTURE_SCOPE_END()
+
 FIXTURE_SCOPE(bitmap_tests, bitmap_test_harness<bitmap>)
 
 TEST(bitmap) {
@@ -754,6 +797,110 @@ TEST(EWAH bitwise NAND) {
   CHECK(to_block_string(bm2 - bm3), str);
 }
 
+TEST(EWAH bitwise operations on dirty runs) {
+  // Build bitmaps that mix long clean runs with long dirty runs, such that the
+  // block kernels see runs of various lengths. The NULL bitmap serves as
+  // reference implementation.
+  auto make = [](auto& bm, uint64_t seed, size_t n) {
+    for (auto i = 0u; i < n; ++i) {
+      auto phase = (i / 7 + seed) % 4;
+      if (phase == 0)
+        bm.append_bits(seed % 2 == 0, 64 * (i % 5 + 1));
+      else
+        bm.append_block(0x9e3779b97f4a7c15 * (i + seed));
+    }
+  };
+  ewah_bitmap x;
+  ewah_bitmap y;
+  null_bitmap x_ref;
+  null_bitmap y_ref;
+  make(x, 1, 100);
+  make(x_ref, 1, 100);
+  make(y, 2, 120);
+  make(y_ref, 2, 120);
+  y.append_bits(true, 42);
+  y_ref.append_bits(true, 42);
+  REQUIRE_EQUAL(to_string(x), to_string(x_ref));
+  REQUIRE_EQUAL(to_string(y), to_string(y_ref));
+  CHECK_EQUAL(to_string(x & y), to_string(x_ref & y_ref));
+  CHECK_EQUAL(to_string(x | y), to_string(x_ref | y_ref));
+  CHECK_EQUAL(to_string(x ^ y), to_string(x_ref ^ y_ref));
+  CHECK_EQUAL(to_string(y - x), to_string(y_ref - x_ref));
+  CHECK_EQUAL(to_string(x - y), to_string(x_ref - y_ref));
+  MESSAGE("single-pass n-ary operations");
+  ewah_bitmap z;
+  null_bitmap z_ref;
+  make(z, 3, 80);
+  make(z_ref, 3, 80);
+  auto xs = std::vector<ewah_bitmap>{x, y, z};
+  auto xs_ref = std::vector<null_bitmap>{x_ref, y_ref, z_ref};
+  CHECK_EQUAL(to_string(nary_and(xs.begin(), xs.end())),
+              to_string(nary_and(xs_ref.begin(), xs_ref.end())));
+  CHECK_EQUAL(to_string(nary_or(xs.begin(), xs.end())),
+              to_string(nary_or(xs_ref.begin(), xs_ref.end())));
+  CHECK_EQUAL(nary_and(xs.begin(), xs.end()), x & y & z);
+  CHECK_EQUAL(nary_or(xs.begin(), xs.end()), x | y | z);
+  MESSAGE("type-erased bitmaps");
+  auto bms = std::vector<bitmap>{x, y, z};
+  CHECK_EQUAL(to_string(nary_or(bms.begin(), bms.end())),
+              to_string(x | y | z));
+  CHECK_EQUAL(to_string(bitmap{x} & bitmap{x_ref}), to_string(x & x));
+}
+
+TEST(fused bitwise operations) {
+  auto make = [](auto& bm, uint64_t seed) {
+    for (auto i = 0u; i < 50; ++i)
+      if ((i / 5 + seed) % 3 == 0)
+        bm.append_bits(seed % 2 == 0, 64 * (i % 4 + 1));
+      else
+        bm.append_block(0x9e3779b97f4a7c15 * (i + seed));
+    bm.append_bits(true, 10'000 - bm.size());
+  };
+  ewah_bitmap x, y, z;
+  null_bitmap x_ref, y_ref, z_ref;
+  make(x, 1);
+  make(x_ref, 1);
+  make(y, 2);
+  make(y_ref, 2);
+  make(z, 3);
+  make(z_ref, 3);
+  auto expected = to_string((x_ref - y_ref) & z_ref);
+  CHECK_EQUAL(to_string(and_not_and(x, y, z)), expected);
+  CHECK_EQUAL(to_string(and_not_and(x_ref, y_ref, z_ref)), expected);
+  CHECK_EQUAL(to_string(and_not_and(x, y_ref, z)), expected);
+  CHECK_EQUAL(and_not_and(bitmap{x}, y, z), bitmap{and_not_and(x, y, z)});
+  MESSAGE("in-place variant");
+  auto w = x;
+  w.and_not_and(y, z);
+  CHECK_EQUAL(w, and_not_and(x, y, z));
+  MESSAGE("padding");
+  ewah_bitmap a;
+  a.append_bits(false, 100);
+  a.append_block(0b101, 3);
+  auto op = [](auto lhs, auto rhs) { return lhs & ~rhs; };
+  auto n = x.size() + 42;
+  auto r = fused_eval<ewah_bitmap>(n, op, bit_cursor<ewah_bitmap>{x, true},
+                                   bit_cursor<ewah_bitmap>{a, true});
+  // Past its end, *a* consists of 1s and masks out everything.
+  auto str = to_string(x).substr(0, 103) + std::string(n - 103, '0');
+  str[100] = '0';
+  str[102] = '0';
+  CHECK_EQUAL(r.size(), n);
+  CHECK_EQUAL(to_string(r), str);
+  MESSAGE("cursors over different bitmap types");
+  auto s = fused_eval<null_bitmap>(n, op, bit_cursor<ewah_bitmap>{x, true},
+                                   bit_cursor<null_bitmap>{y_ref});
+  CHECK_EQUAL(to_string(s), to_string(x - y) + std::string(42, '1'));
+}
+
+TEST(EWAH flip with full last block) {
+  ewah_bitmap bm;
+  bm.append_bits(false, 128);
+  bm.flip();
+  CHECK_EQUAL(rank<1>(bm), 128u);
+  CHECK_EQUAL(to_string(bm), std::string(128, '1'));
+}
+
 TEST(EWAH block append) {
   ewah_bitmap bm;
   bm.append_bits(true, 10);
@@ -805,3 +952,67 @@ TEST(EWAH RLE print 2) {
   //CHECK_EQUAL(str, "1F1T421F2T");
   CHECK_EQUAL(str, "1F1T62F320F39F2T");
 }
+
+TEST(Roaring containers) {
+  using container = roaring_bitmap::container;
+  roaring_bitmap bm;
+  null_bitmap ref;
+  auto append = [&](bool bit, size_t n) {
+    bm.append_bits(bit, n);
+    ref.append_bits(bit, n);
+  };
+  // Chunk 0: sparse 1s.
+  for (auto i = 0; i < 100; ++i) {
+    append(false, 99);
+    append(true, 1);
+  }
+  append(false, roaring_bitmap::chunk_size - bm.size());
+  // Chunk 1: a few long runs.
+  append(true, 10000);
+  append(false, 10000);
+  append(true, 20000);
+  append(false, 2 * roaring_bitmap::chunk_size - bm.size());
+  // Chunk 2: dense random-looking bits.
+  for (auto i = 0u; i < roaring_bitmap::chunk_blocks; ++i) {
+    auto block = 0x9e3779b97f4a7c15 * (i + 1);
+    bm.append_block(block);
+    ref.append_block(block);
+  }
+  // Chunk 3 stays empty, chunk 4 has a partial array.
+  append(false, roaring_bitmap::chunk_size + 42);
+  append(true, 3);
+  REQUIRE_EQUAL(to_string(bm), to_string(ref));
+  auto& xs = bm.containers();
+  REQUIRE_EQUAL(xs.size(), 4u);
+  CHECK(xs[0].kind == container::array);
+  CHECK_EQUAL(xs[0].cardinality, 100u);
+  CHECK(xs[1].kind == container::run);
+  CHECK_EQUAL(xs[1].cardinality, 30000u);
+  CHECK(xs[2].kind == container::bitset);
+  CHECK_EQUAL(xs[3].key, 4u);
+  MESSAGE("random access");
+  for (auto i : {0u, 99u, 100u, 65536u, 75535u, 75536u, 95536u, 131072u,
+                 262144u + 42u, 262144u + 44u})
+    CHECK_EQUAL(bm[i], ref[i]);
+  CHECK_EQUAL(rank<1>(bm), rank<1>(ref));
+  CHECK_EQUAL(select<1>(bm, 5000), select<1>(ref, 5000));
+  CHECK_EQUAL(select<1>(bm, -1), bm.size() - 1);
+  MESSAGE("bitwise operations across containers");
+  auto flipped = ~bm;
+  CHECK_EQUAL(to_string(flipped), to_string(~ref));
+  CHECK_EQUAL(to_string(bm & flipped), to_string(ref & ~ref));
+  CHECK_EQUAL(to_string(bm | flipped), to_string(ref | ~ref));
+  CHECK_EQUAL(to_string(bm ^ ~flipped), to_string(ref ^ ref));
+  CHECK_EQUAL(to_string(bm - flipped), to_string(ref));
+  CHECK_EQUAL(~flipped, bm);
+  MESSAGE("type-erased bitmap");
+  bitmap erased{bm};
+  CHECK_EQUAL(to_string(erased & bitmap{flipped}), to_string(bm & flipped));
+  CHECK_EQUAL(to_string(erased | bitmap{ref}), to_string(ref));
+  MESSAGE("serialization");
+  std::string buf;
+  save(buf, bm);
+  roaring_bitmap bm2;
+  load(buf, bm2);
+  CHECK_EQUAL(bm, bm2);
+}
@@ -0,0 +1,118 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include "vast/bitmap_evaluator.hpp"
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/bitmap.hpp"
+#include "vast/null_bitmap.hpp"
+
+#define SUITE bitmap_evaluator
+#include "test.hpp"
+
+using namespace vast;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    x.append_bits(true, 100);
+    x.append_bits(false, 200);
+    x.append_block(0xdeadbeef, 40);
+    y.append_block(0xcafebabe);
+    y.append_bits(false, 300);
+    y.append_block(0xf00, 20);
+    z.append_bits(false, 64);
+    z.append_bits(true, 128);
+    z.append_block(0x5555);
+  }
+
+  ewah_bitmap x;
+  ewah_bitmap y;
+  ewah_bitmap z;
+};
+
+} // namespace <anonymous>
+
+FIXTURE_SCOPE(bitmap_evaluator_tests, fixture)
+
+TEST(leaves) {
+  bitmap_evaluator eval;
+  auto a = eval.add_leaf(x);
+  CHECK_EQUAL(eval.add_leaf(x), a);
+  CHECK_EQUAL(eval.size(a), x.size());
+  CHECK_EQUAL(eval.evaluate(a), x);
+  MESSAGE("leaves of other bitmap types");
+  null_bitmap n;
+  n.append(x);
+  auto b = eval.add_leaf(bitmap{n});
+  CHECK_EQUAL(eval.evaluate(b), x);
+}
+
+TEST(single operations) {
+  bitmap_evaluator eval;
+  auto a = eval.add_leaf(x);
+  auto b = eval.add_leaf(y);
+  auto c = eval.add_leaf(z);
+  CHECK_EQUAL(eval.evaluate(eval.add_negation(a)), ~x);
+  CHECK_EQUAL(eval.evaluate(eval.add_conjunction({a, b, c})), x & y & z);
+  CHECK_EQUAL(eval.evaluate(eval.add_disjunction({a, b, c})), x | y | z);
+}
+
+TEST(nested operations) {
+  bitmap_evaluator eval;
+  auto a = eval.add_leaf(x);
+  auto b = eval.add_leaf(y);
+  auto c = eval.add_leaf(z);
+  // (x || !y) && !(z && x)
+  auto lhs = eval.add_disjunction({a, eval.add_negation(b)});
+  auto rhs = eval.add_negation(eval.add_conjunction({c, a}));
+  auto root = eval.add_conjunction({lhs, rhs});
+  auto expected = (x | ~y) & ~(z & x);
+  auto result = eval.evaluate(root);
+  CHECK_EQUAL(result.size(), expected.size());
+  CHECK_EQUAL(to_string(result), to_string(expected));
+  MESSAGE("shared subexpressions");
+  auto shared = eval.add_disjunction({root, eval.add_conjunction({root, c})});
+  CHECK_EQUAL(to_string(eval.evaluate(shared)), to_string(expected));
+}
+
+TEST(negation of shorter operands) {
+  // The negation of a shorter bitmap does not extend beyond its size.
+  bitmap_evaluator eval;
+  ewah_bitmap short_bm;
+  short_bm.append_bits(false, 10);
+  auto a = eval.add_leaf(short_bm);
+  auto b = eval.add_leaf(z);
+  auto root = eval.add_disjunction({eval.add_negation(a), b});
+  auto expected = std::string(10, '1') + to_string(z).substr(10);
+  CHECK_EQUAL(to_string(eval.evaluate(root)), expected);
+}
+
+TEST(many leaves) {
+  std::vector<ewah_bitmap> xs(1000);
+  ewah_bitmap expected;
+  for (auto i = 0u; i < xs.size(); ++i) {
+    xs[i].append_bits(false, i * 7);
+    xs[i].append_bit(true);
+    xs[i].append_bits(false, 10'000 - xs[i].size());
+  }
+  bitmap_evaluator eval;
+  std::vector<bitmap_evaluator::node_id> leaves;
+  for (auto& bm : xs)
+    leaves.push_back(eval.add_leaf(bm));
+  auto result = eval.evaluate(eval.add_disjunction(std::move(leaves)));
+  CHECK_EQUAL(result, nary_or(xs.begin(), xs.end()));
+  CHECK_EQUAL(rank(result), xs.size());
+}
+
+FIXTURE_SCOPE_END()
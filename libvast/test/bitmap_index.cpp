@@ -207,6 +207,43 @@ TEST(bitslice-coder append) {
   append_test<bitslice_coder<null_bitmap>>();
 }
 
+TEST(batch append) {
+  using coder_type = multi_level_coder<range_coder<null_bitmap>>;
+  auto bmi1 = bitmap_index<int16_t, coder_type>{base::uniform(10, 5)};
+  auto bmi2 = bitmap_index<int16_t, coder_type>{base::uniform(10, 5)};
+  std::vector<int16_t> xs;
+  for (auto i = 0; i < 200; ++i)
+    xs.push_back(i * 37 % 101 - 50);
+  bmi1.push_back(xs[0], 3);
+  for (auto i = 1u; i < xs.size(); ++i)
+    bmi1.push_back(xs[i]);
+  bmi2.append(xs, 3);
+  REQUIRE_EQUAL(bmi2.size(), 203u);
+  CHECK(bmi1 == bmi2);
+  for (auto op : {less, less_equal, equal, not_equal, greater_equal, greater})
+    for (auto x : {-50, -1, 0, 7, 50})
+      CHECK_EQUAL(to_string(bmi1.lookup(op, x)), to_string(bmi2.lookup(op, x)));
+}
+
+TEST(parallel batch append) {
+  using coder_type = multi_level_coder<range_coder<null_bitmap>>;
+  std::vector<int16_t> xs;
+  for (auto i = 0; i < 1000; ++i)
+    xs.push_back(i * 37 % 101 - 50);
+  auto bmi1 = bitmap_index<int16_t, coder_type>{base::uniform(10, 5)};
+  bmi1.append(xs, 3);
+  for (auto threads : {2, 3, 7}) {
+    MESSAGE(threads << " threads");
+    auto bmi2 = bitmap_index<int16_t, coder_type>{base::uniform(10, 5)};
+    bmi2.append(xs, 3, threads);
+    REQUIRE_EQUAL(bmi2.size(), 1003u);
+    for (auto op : {less, equal, not_equal, greater_equal})
+      for (auto x : {-50, -1, 0, 7, 50})
+        CHECK_EQUAL(to_string(bmi1.lookup(op, x)),
+                    to_string(bmi2.lookup(op, x)));
+  }
+}
+
 TEST(fractional precision-binner) {
   using binner = precision_binner<2, 3>;
   using coder_type = multi_level_coder<range_coder<null_bitmap>>;
@@ -142,6 +142,19 @@ TEST(range-coder) {
   // of 1s. That's because the Range-Eval-Opt algorithm turns them into 0s.
   c.encode(7, 1, 3);
   CHECK_EQUAL(to_string(c.decode(greater_equal, 7)), "010000000000001");
+  MESSAGE("lazy extension");
+  range_coder<null_bitmap> l{4};
+  l.encode(0);
+  l.encode(0);
+  l.encode(2);
+  CHECK_EQUAL(l.storage()[0].size(), 3u);
+  CHECK_EQUAL(l.storage()[1].size(), 3u);
+  CHECK_EQUAL(l.storage()[2].size(), 0u);
+  CHECK_EQUAL(to_string(l.decode(less_equal, 0)), "110");
+  CHECK_EQUAL(to_string(l.decode(equal, 0)), "110");
+  CHECK_EQUAL(to_string(l.decode(equal, 2)), "001");
+  CHECK_EQUAL(to_string(l.decode(equal, 3)), "000");
+  CHECK_EQUAL(to_string(l.decode(greater, 1)), "001");
 }
 
 TEST(bitslice-coder) {
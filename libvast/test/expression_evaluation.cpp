@@ -155,4 +155,37 @@ TEST(evaluation - schema) {
   CHECK(caf::holds_alternative<none>(*ast_resolved));
 }
 
+TEST(evaluation - compiled) {
+  auto exprs = {
+    ":count == 42",
+    ":int != +101",
+    ":string ~ /bar/ && :int == +100",
+    ":real >= -4.8",
+    ":int <= -3 || :int >= +100 && :string !~ /bar/ || :real > 1.0",
+    "! c < 10",
+    "s1 != \"cheetah\"",
+    "\"abb\" in s1",
+    "d1 > 0.5",
+    "r.b == F",
+    "&type == \"foo\"",
+  };
+  for (auto str : exprs) {
+    auto ast = to<expression>(str);
+    REQUIRE(ast);
+    for (auto x : {&e0, &e1}) {
+      auto& t = x->type();
+      auto resolved = caf::visit(type_resolver{t}, *ast);
+      REQUIRE(resolved);
+      auto tailored = caf::visit(type_pruner{t}, *resolved);
+      auto f = caf::visit(expression_compiler{t}, tailored);
+      MESSAGE(str << " on " << t.name());
+      CHECK_EQUAL(f(*x), caf::visit(event_evaluator{*x}, tailored));
+    }
+  }
+  auto ast = to<expression>(":count == 42 && s1 == \"babba\"");
+  REQUIRE(ast);
+  auto f = caf::visit(expression_compiler{*foo}, *tailor(*ast, *foo));
+  CHECK(f(e0));
+}
+
 FIXTURE_SCOPE_END()
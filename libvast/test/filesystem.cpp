@@ -179,3 +179,21 @@ TEST(file_and_directory_manipulation) {
   CHECK(rm(p.parent()));
   CHECK(!p.parent().is_directory());
 }
+
+TEST(writing_and_loading_contents) {
+  path p("/tmp");
+  p /= "vast-unit-test-file-contents-"
+       + std::to_string(detail::process_id());
+  CHECK(!exists(p));
+  REQUIRE(write_contents(p, "foo"));
+  auto contents = load_contents(p);
+  REQUIRE(contents);
+  CHECK_EQUAL(*contents, "foo");
+  MESSAGE("replacing existing contents");
+  REQUIRE(write_contents(p, "bar baz"));
+  contents = load_contents(p);
+  REQUIRE(contents);
+  CHECK_EQUAL(*contents, "bar baz");
+  CHECK(!exists(path{p.str() + ".tmp"}));
+  CHECK(rm(p));
+}
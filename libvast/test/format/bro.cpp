@@ -11,6 +11,12 @@
  * contained in the LICENSE file.                                             *
  ******************************************************************************/
 
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
 #include "vast/concept/parseable/to.hpp"
 #include "vast/event.hpp"
 
@@ -60,8 +66,97 @@ TEST(bro data parsing) {
   CHECK(d == set{"49329", "42"});
 }
 
+TEST(bro field parser) {
+  // The specialized decoders must agree with the combinator parsers, both on
+  // the fast path and for inputs that fall back.
+  auto check = [](const type& t, std::string_view s) {
+    MESSAGE("parse " << s);
+    auto fast = format::bro::field_parser{t, ","};
+    auto slow = format::bro::make_bro_parser<std::string_view::const_iterator>(
+      t, is_container(t) ? "," : "");
+    data x;
+    data y;
+    auto f = s.begin();
+    auto g = s.begin();
+    CHECK_EQUAL(fast(f, s.end(), x), slow(g, s.end(), y));
+    CHECK_EQUAL(x, y);
+    CHECK(f == g);
+  };
+  check(boolean_type{}, "T");
+  check(boolean_type{}, "F");
+  check(integer_type{}, "-49329");
+  check(integer_type{}, "+42");
+  check(integer_type{}, "42x");
+  check(count_type{}, "18446744073709551615");
+  check(real_type{}, "-0.125");
+  check(real_type{}, "3.");
+  check(timestamp_type{}, "1258594163.566694");
+  check(timespan_type{}, "0.000263");
+  check(string_type{}, "foo bar");
+  check(string_type{}, "\\x2afoo*");
+  check(address_type{}, "192.168.1.103");
+  check(address_type{}, "192.168.1.256");
+  check(address_type{}, "fe80::1");
+  check(port_type{}, "65535");
+  check(port_type{}, "65536");
+  check(set_type{address_type{}}, "10.0.0.1,10.0.0.2");
+}
+
 FIXTURE_SCOPE(bro_tests, fixtures::events)
 
+TEST(bro parallel reader) {
+  // Parsing on several threads must yield the same events in the same order.
+  auto logs = {std::make_pair(bro::conn, &bro_conn_log),
+               std::make_pair(bro::http, &bro_http_log)};
+  for (auto [filename, log] : logs) {
+    MESSAGE("parse " << filename);
+    auto input = std::make_unique<std::ifstream>(filename);
+    auto xs = extract(format::bro::reader{std::move(input), 3});
+    auto& ys = *log;
+    REQUIRE_EQUAL(xs.size(), ys.size());
+    for (auto i = 0u; i < xs.size(); ++i) {
+      CHECK_EQUAL(xs[i].type(), ys[i].type());
+      CHECK_EQUAL(xs[i].data(), ys[i].data());
+      CHECK_EQUAL(xs[i].timestamp(), ys[i].timestamp());
+    }
+  }
+}
+
+TEST(bro parallel reader with several chunks) {
+  // Logs that exceed a single chunk keep the thread pool busy with the next
+  // chunk while the reader hands out the current one. Repeating the data
+  // lines of the conn log yields several chunks, and a subsequent HTTP log
+  // forces a new header in between.
+  auto slurp = [](const std::string& filename) {
+    std::ifstream in{filename};
+    std::string result;
+    for (std::string line; std::getline(in, line);)
+      result += line + '\n';
+    return result;
+  };
+  std::string header;
+  std::string body;
+  std::istringstream conn{slurp(bro::conn)};
+  for (std::string line; std::getline(conn, line);) {
+    if (line.front() != '#')
+      body += line + '\n';
+    else if (body.empty())
+      header += line + '\n';
+  }
+  auto str = header + body + body + body + slurp(bro::http);
+  auto xs = extract(format::bro::reader{
+    std::make_unique<std::istringstream>(str), 3});
+  auto ys = extract(format::bro::reader{
+    std::make_unique<std::istringstream>(str)});
+  REQUIRE_EQUAL(xs.size(), 3 * bro_conn_log.size() + bro_http_log.size());
+  REQUIRE_EQUAL(xs.size(), ys.size());
+  for (auto i = 0u; i < xs.size(); ++i) {
+    CHECK_EQUAL(xs[i].type(), ys[i].type());
+    CHECK_EQUAL(xs[i].data(), ys[i].data());
+    CHECK_EQUAL(xs[i].timestamp(), ys[i].timestamp());
+  }
+}
+
 TEST(bro writer) {
   // Sanity check some Bro events.
   CHECK_EQUAL(bro_conn_log.size(), 8462u);
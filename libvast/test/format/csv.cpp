@@ -0,0 +1,172 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <caf/streambuf.hpp>
+
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/address.hpp"
+#include "vast/concept/parseable/vast/schema.hpp"
+#include "vast/event.hpp"
+
+#include "vast/format/csv.hpp"
+
+#define SUITE format
+#include "test.hpp"
+#include "fixtures/events.hpp"
+
+using namespace vast;
+using namespace std::string_literals;
+
+namespace {
+
+auto make_reader(std::string str,
+                 size_t block_size
+                 = detail::line_range::default_block_size) {
+  auto input = std::make_unique<std::istringstream>(std::move(str));
+  return format::csv::reader{std::move(input), block_size};
+}
+
+} // namespace <anonymous>
+
+TEST(csv reader) {
+  auto sch = to<schema>(R"__(
+    type asset = record{
+      host: addr,
+      port: port,
+      owner: string,
+      tags: vector<string>,
+      info: record{
+        seen: count,
+        ok: bool
+      }
+    }
+  )__");
+  REQUIRE(sch);
+  auto reader = make_reader(
+    "host,owner,info.seen,tags,port\r\n"
+    "10.0.0.1,alice,42,a | b,80/tcp\n"
+    "10.0.0.2,\"bob, \"\"the admin\"\"\",,\"\",443\n"
+    "10.0.0.3,,7,,\"22\"\n"
+    "10.0.0.4,eve\n"
+    "10.0.0.5,\"mallory,1,,22\n"
+    "not an address,x,1,,22\n");
+  REQUIRE(reader.schema(*sch));
+  // The header does not produce an event.
+  auto e = reader.read();
+  REQUIRE(!e && !e.error());
+  e = reader.read();
+  REQUIRE(e);
+  CHECK_EQUAL(e->type().name(), "asset");
+  auto xs = flatten(get<vector>(e->data()));
+  REQUIRE_EQUAL(xs.size(), 6u);
+  CHECK_EQUAL(xs[0], data{*to<address>("10.0.0.1")});
+  CHECK_EQUAL(xs[1], data{port{80, port::tcp}});
+  CHECK_EQUAL(xs[2], data{"alice"});
+  CHECK_EQUAL(xs[3], data(vector{"a", "b"}));
+  CHECK_EQUAL(xs[4], data{count{42}});
+  CHECK_EQUAL(xs[5], data{nil});
+  // Quoted fields may contain separators and doubled quotes, and quoted
+  // empty fields are empty strings or containers instead of nil.
+  e = reader.read();
+  REQUIRE(e);
+  xs = flatten(get<vector>(e->data()));
+  CHECK_EQUAL(xs[1], data{port{443, port::unknown}});
+  CHECK_EQUAL(xs[2], data{"bob, \"the admin\""});
+  CHECK_EQUAL(xs[3], data{vector{}});
+  CHECK_EQUAL(xs[4], data{nil});
+  e = reader.read();
+  REQUIRE(e);
+  xs = flatten(get<vector>(e->data()));
+  CHECK_EQUAL(xs[1], data{port{22, port::unknown}});
+  CHECK_EQUAL(xs[2], data{nil});
+  CHECK_EQUAL(xs[3], data{nil});
+  // Lines with too few fields are skipped; unterminated quotes and invalid
+  // values are parse errors.
+  e = reader.read();
+  CHECK(!e && !e.error());
+  e = reader.read();
+  REQUIRE(!e);
+  CHECK(e.error() == ec::parse_error);
+  e = reader.read();
+  REQUIRE(!e);
+  CHECK(e.error() == ec::parse_error);
+  e = reader.read();
+  REQUIRE(!e);
+  CHECK(e.error() == ec::end_of_input);
+}
+
+TEST(csv reader without matching type) {
+  auto reader = make_reader("a,b\n1,2\n");
+  auto e = reader.read();
+  REQUIRE(!e);
+  CHECK(e.error() == ec::format_error);
+}
+
+FIXTURE_SCOPE(csv_tests, fixtures::events)
+
+TEST(csv reader reads writer output) {
+  std::string str;
+  auto sb = new caf::containerbuf<std::string>{str};
+  format::csv::writer writer{std::make_unique<std::ostream>(sb)};
+  for (auto& e : bro_conn_log)
+    REQUIRE(writer.write(e));
+  writer.flush();
+  auto reader = make_reader(std::move(str));
+  schema sch;
+  sch.add(bro_conn_log[0].type());
+  REQUIRE(reader.schema(sch));
+  auto xs = extract(reader);
+  REQUIRE_EQUAL(xs.size(), bro_conn_log.size());
+  for (auto i = 0u; i < xs.size(); ++i) {
+    CHECK_EQUAL(xs[i].type(), bro_conn_log[i].type());
+    CHECK(xs[i].timestamp() == bro_conn_log[i].timestamp());
+    // The writer prints times and durations with reduced precision, so we
+    // compare all other fields.
+    auto x = flatten(get<vector>(xs[i].data()));
+    auto y = flatten(get<vector>(bro_conn_log[i].data()));
+    REQUIRE_EQUAL(x.size(), y.size());
+    for (auto j = 1u; j < x.size(); ++j)
+      if (j != 8)
+        CHECK_EQUAL(x[j], y[j]);
+  }
+}
+
+TEST(csv reader small blocks) {
+  // Refilling the line buffer moves the data, so the reader must not advance
+  // to the next line before it has processed the current one.
+  std::string str;
+  auto sb = new caf::containerbuf<std::string>{str};
+  format::csv::writer writer{std::make_unique<std::ostream>(sb)};
+  for (auto& e : bro_conn_log)
+    REQUIRE(writer.write(e));
+  writer.flush();
+  schema sch;
+  sch.add(bro_conn_log[0].type());
+  auto expected_reader = make_reader(str);
+  auto reader = make_reader(std::move(str), 16);
+  REQUIRE(expected_reader.schema(sch));
+  REQUIRE(reader.schema(sch));
+  auto xs = extract(expected_reader);
+  auto ys = extract(reader);
+  REQUIRE_EQUAL(xs.size(), bro_conn_log.size());
+  REQUIRE_EQUAL(ys.size(), xs.size());
+  for (auto i = 0u; i < xs.size(); ++i)
+    CHECK_EQUAL(ys[i].data(), xs[i].data());
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,161 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/address.hpp"
+#include "vast/concept/parseable/vast/schema.hpp"
+#include "vast/detail/string.hpp"
+#include "vast/event.hpp"
+
+#include "vast/format/json.hpp"
+
+#define SUITE format
+#include "test.hpp"
+
+using namespace vast;
+using namespace std::string_literals;
+
+namespace {
+
+std::vector<expected<event>> read_all(format::json::reader& reader) {
+  std::vector<expected<event>> result;
+  while (true) {
+    auto e = reader.read();
+    if (!e && e.error() == ec::end_of_input)
+      return result;
+    result.push_back(std::move(e));
+  }
+}
+
+auto make_reader(std::string str,
+                 size_t block_size
+                 = detail::line_range::default_block_size) {
+  auto input = std::make_unique<std::istringstream>(std::move(str));
+  return format::json::reader{std::move(input), block_size};
+}
+
+} // namespace <anonymous>
+
+TEST(json reader inference) {
+  auto reader = make_reader(
+    R"({"ts": "2009-11-18T08:00:21.040000Z", "id": {"orig_h": "10.0.0.1",)"
+    R"( "orig_p": 53}, "proto": "udp", "ok": true, "tags": ["a", "b"]})" "\n"
+    R"({"ok": false, "proto": "tcp", "tags": ["c"], "id": {"orig_p": 80,)"
+    R"( "orig_h": "10.0.0.2"}, "ts": "2009-11-18T08:00:22Z"})" "\n"
+    R"({"x": -1.5e1, "y": null})" "\n");
+  auto xs = read_all(reader);
+  REQUIRE_EQUAL(xs.size(), 3u);
+  REQUIRE(xs[0]);
+  REQUIRE(xs[1]);
+  REQUIRE(xs[2]);
+  // Objects with the same keys in a different order share a type.
+  CHECK(xs[0]->type() == xs[1]->type());
+  CHECK(xs[0]->type() != xs[2]->type());
+  CHECK(detail::starts_with(xs[0]->type().name(), "json::"));
+  auto expected_type = record_type{
+    {"id", record_type{
+      {"orig_h", address_type{}},
+      {"orig_p", integer_type{}}
+    }},
+    {"ok", boolean_type{}},
+    {"proto", string_type{}},
+    {"tags", vector_type{string_type{}}},
+    {"ts", timestamp_type{}}
+  };
+  CHECK(congruent(xs[0]->type(), expected_type));
+  auto v = get_if<vector>(xs[1]->data());
+  REQUIRE(v);
+  REQUIRE_EQUAL(v->size(), 5u);
+  CHECK_EQUAL(v->at(0), data(vector{*to<address>("10.0.0.2"), integer{80}}));
+  CHECK_EQUAL(v->at(1), data{false});
+  CHECK_EQUAL(v->at(2), data{"tcp"});
+  CHECK_EQUAL(v->at(3), data{vector{"c"}});
+  // The first timestamp field becomes the event timestamp.
+  auto ts = timestamp{std::chrono::seconds{1258531222}};
+  CHECK_EQUAL(v->at(4), data{ts});
+  CHECK(xs[1]->timestamp() == ts);
+  v = get_if<vector>(xs[2]->data());
+  REQUIRE(v);
+  CHECK_EQUAL(v->at(0), data{real{-15.0}});
+  CHECK_EQUAL(v->at(1), data{nil});
+}
+
+TEST(json reader schema) {
+  auto sch = to<schema>(R"__(
+    type flow = record{
+      ts: time,
+      src: addr,
+      dst: addr,
+      port: port,
+      bytes: count,
+      payload: string
+    }
+  )__");
+  REQUIRE(sch);
+  auto reader = make_reader(
+    R"({"ts": 1258531221.5, "src": "10.0.0.1", "dst": "10.0.0.2",)"
+    R"( "port": 53, "bytes": 42, "payload": "a\tb"})" "\n"
+    R"({"src": "10.0.0.1", "bytes": 42, "extra": 1})" "\n"
+    R"({"src": "10.0.0.1", "bytes": -1})" "\n"
+    R"({"src": "10.0.0.1", )" "\n");
+  REQUIRE(reader.schema(*sch));
+  auto xs = read_all(reader);
+  REQUIRE_EQUAL(xs.size(), 4u);
+  // All keys belong to the schema type.
+  REQUIRE(xs[0]);
+  CHECK_EQUAL(xs[0]->type().name(), "flow");
+  auto v = get_if<vector>(xs[0]->data());
+  REQUIRE(v);
+  REQUIRE_EQUAL(v->size(), 6u);
+  CHECK_EQUAL(v->at(3), data{port{53, port::unknown}});
+  CHECK_EQUAL(v->at(4), data{count{42}});
+  CHECK_EQUAL(v->at(5), data{"a\tb"});
+  // An unknown key requires an inferred type.
+  REQUIRE(xs[1]);
+  CHECK_NOT_EQUAL(xs[1]->type().name(), "flow");
+  // Values that do not fit the field type and malformed lines are errors.
+  REQUIRE(!xs[2]);
+  CHECK(xs[2].error() == ec::parse_error);
+  REQUIRE(!xs[3]);
+  CHECK(xs[3].error() == ec::parse_error);
+  auto inferred = reader.schema();
+  REQUIRE(inferred);
+  CHECK(inferred->find("flow"));
+  CHECK_EQUAL(inferred->size(), 2u);
+}
+
+TEST(json reader small blocks) {
+  // Refilling the line buffer moves the data, so the reader must not advance
+  // to the next line before it has processed the current one.
+  std::string str;
+  for (auto i = 0; i < 10; ++i)
+    str += R"({"name": "event-)" + std::to_string(i) + R"(", "n": )"
+           + std::to_string(i) + "}\n";
+  auto reader = make_reader(std::move(str), 8);
+  auto xs = read_all(reader);
+  REQUIRE_EQUAL(xs.size(), 10u);
+  for (auto i = 0; i < 10; ++i) {
+    REQUIRE(xs[i]);
+    auto v = get_if<vector>(xs[i]->data());
+    REQUIRE(v);
+    REQUIRE_EQUAL(v->size(), 2u);
+    // Inferred types order their fields by name.
+    CHECK_EQUAL(v->at(0), data{integer{i}});
+    CHECK_EQUAL(v->at(1), data{"event-" + std::to_string(i)});
+  }
+}
@@ -0,0 +1,62 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "vast/detail/line_range.hpp"
+
+#define SUITE line_range
+#include "test.hpp"
+
+using namespace std::string_literals;
+using namespace vast;
+
+namespace {
+
+auto lines(const std::string& str, size_t block_size) {
+  std::istringstream in{str};
+  detail::line_range rng{in, block_size};
+  std::vector<std::pair<size_t, std::string>> result;
+  while (!rng.done()) {
+    result.emplace_back(rng.line_number(), std::string{rng.get()});
+    rng.next();
+  }
+  return result;
+}
+
+} // namespace <anonymous>
+
+TEST(non-empty lines) {
+  auto str = "foo\n\nbar baz\n\n\nqux"s;
+  using pairs = std::vector<std::pair<size_t, std::string>>;
+  auto expected = pairs{{1, "foo"}, {3, "bar baz"}, {6, "qux"}};
+  // Small blocks force lines to span several reads.
+  for (auto block_size : {1, 2, 3, 5, 1024})
+    CHECK(lines(str, block_size) == expected);
+  CHECK(lines(str + '\n', 2) == expected);
+}
+
+TEST(empty input) {
+  CHECK(lines("", 4).empty());
+  CHECK(lines("\n\n", 4).empty());
+}
+
+TEST(long lines) {
+  auto str = std::string(1000, 'x') + '\n' + std::string(3000, 'y');
+  auto xs = lines(str, 64);
+  REQUIRE_EQUAL(xs.size(), 2u);
+  CHECK_EQUAL(xs[0].second, std::string(1000, 'x'));
+  CHECK_EQUAL(xs[1].second, std::string(3000, 'y'));
+}
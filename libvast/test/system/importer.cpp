@@ -11,6 +11,8 @@
  * contained in the LICENSE file.                                             *
  ******************************************************************************/
 
+#include <algorithm>
+
 #include "vast/concept/printable/stream.hpp"
 #include "vast/concept/printable/vast/event.hpp"
 
@@ -37,13 +39,64 @@ TEST(importer) {
   MESSAGE("sending events");
   self->send(importer, bro_conn_log);
   self->send(importer, bro_dns_log);
-  MESSAGE("receiving reflected events");
-  for (auto i = 0; i < 4; ++i)
+  MESSAGE("receiving reflected events and acknowledgements");
+  // The importer may split a batch that spans two ID leases.
+  size_t reflected = 0;
+  size_t acknowledged = 0;
+  while (acknowledged < 2)
     self->receive(
-      [&](const std::vector<event>&) { },
+      [&](const std::vector<event>& xs) {
+        reflected += xs.size();
+        return system::ok_atom::value;
+      },
+      [&](system::ok_atom) {
+        ++acknowledged;
+      },
       error_handler()
     );
+  // Archive and index each receive all events.
+  CHECK_EQUAL(reflected, 2 * (bro_conn_log.size() + bro_dns_log.size()));
   self->send_exit(importer, exit_reason::user_shutdown);
 }
 
+TEST(multiple importers) {
+  auto store = self->spawn(system::data_store<std::string, data>);
+  std::vector<actor> importers;
+  for (auto label : {"importer-1", "importer-2"}) {
+    auto importer = self->spawn(system::importer, directory / label, 1024);
+    self->send(importer, store);
+    self->send(importer, actor_cast<system::archive_type>(self));
+    self->send(importer, system::index_atom::value, self);
+    importers.push_back(importer);
+  }
+  MESSAGE("sending events to both importers");
+  for (auto& importer : importers)
+    self->send(importer, bro_conn_log);
+  MESSAGE("checking that the ID leases are disjoint");
+  std::vector<id> xs;
+  size_t acknowledged = 0;
+  while (acknowledged < importers.size())
+    self->receive(
+      [&](const std::vector<event>& events) {
+        for (auto& e : events)
+          xs.push_back(e.id());
+        return system::ok_atom::value;
+      },
+      [&](system::ok_atom) {
+        ++acknowledged;
+      },
+      error_handler()
+    );
+  // Archive and index each receive every ID once.
+  REQUIRE_EQUAL(xs.size(), 4 * bro_conn_log.size());
+  std::sort(xs.begin(), xs.end());
+  for (auto i = 0u; i < xs.size(); i += 2) {
+    CHECK_EQUAL(xs[i], xs[i + 1]);
+    if (i + 2 < xs.size())
+      CHECK_NOT_EQUAL(xs[i], xs[i + 2]);
+  }
+  for (auto& importer : importers)
+    self->send_exit(importer, exit_reason::user_shutdown);
+}
+
 FIXTURE_SCOPE_END()
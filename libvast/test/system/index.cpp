@@ -16,6 +16,7 @@
 #include "vast/concept/parseable/vast/expression.hpp"
 #include "vast/query_options.hpp"
 
+#include "vast/system/atoms.hpp"
 #include "vast/system/index.hpp"
 
 #define SUITE index
@@ -98,4 +99,134 @@ TEST(index) {
   self->wait_for(index);
 }
 
+TEST(compaction) {
+  directory /= "index";
+  auto slice = [&](size_t first, size_t last) {
+    return std::vector<event>(bro_conn_log.begin() + first,
+                              bro_conn_log.begin() + last);
+  };
+  MESSAGE("creating small partitions in separate runs");
+  for (auto i = 0u; i < 2; ++i) {
+    auto index = self->spawn(system::index, directory, 1000, 5, 10);
+    self->send(index, slice(i * 100, (i + 1) * 100));
+    self->send_exit(index, exit_reason::user_shutdown);
+    self->wait_for(index);
+  }
+  MESSAGE("merging partitions");
+  auto index = self->spawn(system::index, directory, 1000, 5, 10);
+  self->request(index, infinite, system::compact_atom::value).receive(
+    [&](size_t) {
+      // The index has merged the partitions upon startup already.
+    },
+    error_handler()
+  );
+  MESSAGE("querying the merged partition");
+  auto expr = to<expression>("&type == \"bro::conn\"");
+  REQUIRE(expr);
+  self->send(index, *expr);
+  self->receive(
+    [&](const uuid&, size_t total, size_t scheduled) {
+      CHECK_EQUAL(total, 1u);
+      CHECK_EQUAL(scheduled, 1u);
+      self->receive(
+        [&](const ids& hits) { CHECK_EQUAL(rank(hits), 200u); },
+        error_handler()
+      );
+    },
+    error_handler()
+  );
+  self->send_exit(index, exit_reason::user_shutdown);
+  self->wait_for(index);
+}
+
+TEST(multiple importers) {
+  directory /= "index";
+  auto slice = [&](size_t first, size_t last) {
+    return std::vector<event>(bro_conn_log.begin() + first,
+                              bro_conn_log.begin() + last);
+  };
+  auto index = self->spawn(system::index, directory, 1000, 5, 10);
+  MESSAGE("sending interleaved ID ranges from two importers");
+  scoped_actor other{self->system()};
+  self->request(index, infinite, slice(100, 200)).receive(
+    [](system::ok_atom) { /* nop */ },
+    error_handler()
+  );
+  other->request(index, infinite, slice(0, 100)).receive(
+    [](system::ok_atom) { /* nop */ },
+    error_handler()
+  );
+  self->request(index, infinite, slice(300, 400)).receive(
+    [](system::ok_atom) { /* nop */ },
+    error_handler()
+  );
+  other->request(index, infinite, slice(200, 300)).receive(
+    [](system::ok_atom) { /* nop */ },
+    error_handler()
+  );
+  MESSAGE("querying both active partitions");
+  auto expr = to<expression>("&type == \"bro::conn\"");
+  REQUIRE(expr);
+  self->send(index, *expr);
+  self->receive(
+    [&](const uuid&, size_t total, size_t scheduled) {
+      CHECK_EQUAL(total, 2u);
+      CHECK_EQUAL(scheduled, 2u);
+      size_t i = 0;
+      ids all;
+      self->receive_for(i, scheduled)(
+        [&](const ids& hits) { all |= hits; },
+        error_handler()
+      );
+      CHECK_EQUAL(rank(all), 400u);
+    },
+    error_handler()
+  );
+  self->send_exit(index, exit_reason::user_shutdown);
+  self->wait_for(index);
+  MESSAGE("keeping partitions with overlapping IDs apart");
+  index = self->spawn(system::index, directory, 1000, 5, 10);
+  self->request(index, infinite, system::compact_atom::value).receive(
+    [&](size_t merged) { CHECK_EQUAL(merged, 0u); },
+    error_handler()
+  );
+  self->send_exit(index, exit_reason::user_shutdown);
+  self->wait_for(index);
+}
+
+TEST(terminated importer) {
+  directory /= "index";
+  auto index = self->spawn(system::index, directory, 1000, 5, 10);
+  MESSAGE("indexing events from a short-lived importer");
+  {
+    scoped_actor importer{self->system()};
+    auto xs = std::vector<event>(bro_conn_log.begin(),
+                                 bro_conn_log.begin() + 100);
+    importer->request(index, infinite, std::move(xs)).receive(
+      [](system::ok_atom) { /* nop */ },
+      error_handler()
+    );
+  }
+  self->send_exit(index, exit_reason::user_shutdown);
+  self->wait_for(index);
+  MESSAGE("querying the retired partition after a restart");
+  index = self->spawn(system::index, directory, 1000, 5, 10);
+  auto expr = to<expression>("&type == \"bro::conn\"");
+  REQUIRE(expr);
+  self->send(index, *expr);
+  self->receive(
+    [&](const uuid&, size_t total, size_t scheduled) {
+      CHECK_EQUAL(total, 1u);
+      CHECK_EQUAL(scheduled, 1u);
+      self->receive(
+        [&](const ids& hits) { CHECK_EQUAL(rank(hits), 100u); },
+        error_handler()
+      );
+    },
+    error_handler()
+  );
+  self->send_exit(index, exit_reason::user_shutdown);
+  self->wait_for(index);
+}
+
 FIXTURE_SCOPE_END()
@@ -66,6 +66,7 @@ TEST(indexer) {
   CHECK(exists(directory));
   CHECK(exists(directory / "data" / "id" / "orig_h"));
   CHECK(exists(directory / "meta" / "time"));
+  CHECK(!exists(directory / "meta" / "type"));
   MESSAGE("respawning indexer from file system");
   i = self->spawn(system::event_indexer, directory, conn_log_type);
   // Same as above: submit the query and verify the result.
@@ -85,6 +86,23 @@ TEST(indexer) {
     },
     error_handler()
   );
+  // Type predicates are answered without a type index.
+  pred = to<predicate>("&type == \"bro::conn\"");
+  REQUIRE(pred);
+  self->request(i, infinite, *pred).receive(
+    [&](const bitmap& bm) {
+      CHECK_EQUAL(rank(bm), bro_conn_log.size());
+    },
+    error_handler()
+  );
+  pred = to<predicate>("&type != \"bro::conn\"");
+  REQUIRE(pred);
+  self->request(i, infinite, *pred).receive(
+    [&](const bitmap& bm) {
+      CHECK_EQUAL(rank(bm), 0u);
+    },
+    error_handler()
+  );
 }
 
 FIXTURE_SCOPE_END()
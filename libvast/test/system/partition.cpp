@@ -63,7 +63,7 @@ struct partition_fixture : fixtures::actor_system_and_events {
     REQUIRE(exists(directory));
     REQUIRE(exists(directory / "547119946" / "data" / "id" / "orig_h"));
     REQUIRE(exists(directory / "547119946" / "meta" / "time"));
-    REQUIRE(exists(directory / "547119946" / "meta" / "type"));
+    REQUIRE(!exists(directory / "547119946" / "meta" / "type"));
     MESSAGE("respawning partition and sending query again");
     partition = self->spawn(system::partition, directory);
     self->request(partition, infinite, *expr).receive(
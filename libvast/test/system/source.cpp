@@ -37,11 +37,44 @@ TEST(Bro source) {
   self->receive([&](const std::vector<event>& events) {
     CHECK_EQUAL(events.size(), 8462u);
     CHECK_EQUAL(events[0].type().name(), "bro::conn");
+    return ok_atom::value;
   });
-  // A source terminates normally after having consumed the entire input.
+  // A source terminates normally after having consumed the entire input and
+  // after its sink has acknowledged all batches.
   self->receive([&](const caf::down_msg& msg) {
     CHECK(msg.reason == caf::exit_reason::normal);
   });
 }
 
+TEST(source flow control) {
+  using state_type = source_state<format::bro::reader>;
+  auto stream = detail::make_input_stream(bro::conn);
+  REQUIRE(stream);
+  format::bro::reader reader{std::move(*stream)};
+  auto src = self->spawn(source<format::bro::reader>, std::move(reader));
+  self->send(src, batch_atom::value, uint64_t{100});
+  self->send(src, sink_atom::value, self);
+  self->send(src, run_atom::value);
+  MESSAGE("holding back acknowledgements until the source runs out of credit");
+  std::vector<caf::response_promise> pending;
+  auto hold = [&](const std::vector<event>& events) {
+    CHECK_EQUAL(events.size(), 100u);
+    pending.push_back(self->make_response_promise());
+  };
+  for (size_t i = 0; i < state_type::max_credit; ++i)
+    self->receive(hold);
+  auto idle = false;
+  self->receive(
+    hold,
+    caf::after(std::chrono::milliseconds(100)) >> [&] { idle = true; }
+  );
+  CHECK(idle);
+  REQUIRE_EQUAL(pending.size(), state_type::max_credit);
+  MESSAGE("acknowledging a batch lets the source ship exactly one more");
+  pending.front().deliver(ok_atom::value);
+  self->receive(hold);
+  REQUIRE_EQUAL(pending.size(), state_type::max_credit + 1);
+  self->send_exit(src, caf::exit_reason::user_shutdown);
+}
+
 FIXTURE_SCOPE_END()
@@ -83,6 +83,13 @@ TEST(parseable) {
   CHECK(t.hours() == hours{23});
   CHECK(t.minutes() == minutes{55});
   CHECK(t.seconds() == seconds{4});
+  MESSAGE("YYYY-MM-DD+HH:MM:SS.ssssss");
+  CHECK(parsers::timestamp("2012-08-12+23:55:04.001234", ts));
+  sd = floor<days>(ts);
+  t = make_time(ts - sd);
+  CHECK(sd == 2012_y/8/12);
+  CHECK(t.seconds() == seconds{4});
+  CHECK(t.subseconds() == microseconds{1234});
   MESSAGE("YYYY-MM-DD+HH:MM");
   CHECK(parsers::timestamp("2012-08-12+23:55", ts));
   sd = floor<days>(ts);
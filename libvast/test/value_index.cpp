@@ -403,6 +403,84 @@ TEST(container) {
   CHECK_EQUAL(to_string(*idx2.lookup(ni, "bar")), "10110001");
 }
 
+TEST(enumeration) {
+  auto e = enumeration_type{{"foo", "bar", "baz"}};
+  enumeration_index idx{e};
+  auto make = [](enumeration x) {
+    data result;
+    expose(result) = x;
+    return result;
+  };
+  MESSAGE("push_back");
+  REQUIRE(idx.push_back(make(0)));
+  REQUIRE(idx.push_back(make(2)));
+  REQUIRE(idx.push_back(make(1)));
+  REQUIRE(idx.push_back(make(0)));
+  REQUIRE(idx.push_back(nil));
+  REQUIRE(idx.push_back(make(2)));
+  CHECK(!idx.push_back(make(3))); // out of range
+  MESSAGE("lookup");
+  CHECK_EQUAL(to_string(*idx.lookup(equal, make(0))), "100100");
+  CHECK_EQUAL(to_string(*idx.lookup(equal, make(2))), "010001");
+  CHECK_EQUAL(to_string(*idx.lookup(not_equal, make(2))), "101100");
+  CHECK_EQUAL(to_string(*idx.lookup(equal, "bar")), "001000");
+  CHECK_EQUAL(to_string(*idx.lookup(equal, "qux")), "000000");
+  CHECK_EQUAL(to_string(*idx.lookup(in, vector{"foo", "baz"})), "110101");
+  CHECK(!idx.lookup(less, make(1)));
+  MESSAGE("serialization");
+  std::vector<char> buf;
+  save(buf, idx);
+  enumeration_index idx2;
+  load(buf, idx2);
+  CHECK_EQUAL(to_string(*idx2.lookup(equal, "baz")), "010001");
+}
+
+TEST(map) {
+  map_index idx{string_type{}, count_type{}};
+  MESSAGE("push_back");
+  REQUIRE(idx.push_back(map{{"foo", 1u}, {"bar", 2u}}));
+  REQUIRE(idx.push_back(map{{"bar", 1u}}));
+  REQUIRE(idx.push_back(map{}));
+  REQUIRE(idx.push_back(map{{"qux", 3u}, {"foo", 2u}, {"baz", 1u}}));
+  REQUIRE(idx.push_back(map{{"bar", 2u}}, 6));
+  MESSAGE("key lookup");
+  CHECK_EQUAL(to_string(*idx.lookup(ni, "foo")), "1001000");
+  CHECK_EQUAL(to_string(*idx.lookup(ni, "bar")), "1100001");
+  CHECK_EQUAL(to_string(*idx.lookup(not_ni, "bar")), "0011000");
+  CHECK_EQUAL(to_string(*idx.lookup(ni, "corge")), "0000000");
+  MESSAGE("entry lookup");
+  CHECK_EQUAL(to_string(*idx.lookup(ni, map{{"bar", 2u}})), "1000001");
+  CHECK_EQUAL(to_string(*idx.lookup(ni, map{{"foo", 2u}})), "0001000");
+  CHECK_EQUAL(to_string(*idx.lookup(ni, map{{"foo", 1u}, {"bar", 2u}})),
+              "1000000");
+  CHECK(!idx.lookup(equal, "foo"));
+  MESSAGE("serialization");
+  std::vector<char> buf;
+  save(buf, idx);
+  map_index idx2;
+  load(buf, idx2);
+  CHECK_EQUAL(to_string(*idx2.lookup(ni, "bar")), "1100001");
+  CHECK_EQUAL(to_string(*idx2.lookup(ni, map{{"bar", 2u}})), "1000001");
+}
+
+TEST(container - rejected elements) {
+  // Elements that do not fit the element type become nil while the remaining
+  // elements still belong to their container.
+  MESSAGE("sequence");
+  sequence_index seq{count_type{}};
+  REQUIRE(seq.push_back(vector{count{1}, "foo", count{2}}));
+  REQUIRE(seq.push_back(vector{count{2}}));
+  CHECK_EQUAL(to_string(*seq.lookup(ni, count{1})), "10");
+  CHECK_EQUAL(to_string(*seq.lookup(ni, count{2})), "11");
+  MESSAGE("map");
+  map_index idx{string_type{}, count_type{}};
+  REQUIRE(idx.push_back(map{{"foo", "x"}, {"bar", 1u}}));
+  REQUIRE(idx.push_back(map{{"bar", 2u}}));
+  CHECK_EQUAL(to_string(*idx.lookup(ni, "foo")), "10");
+  CHECK_EQUAL(to_string(*idx.lookup(ni, map{{"bar", 1u}})), "10");
+  CHECK_EQUAL(to_string(*idx.lookup(ni, map{{"bar", 2u}})), "01");
+}
+
 TEST(polymorphic) {
   type t = set_type{integer_type{}}.attributes({{"max_size", "2"}});
   auto idx = value_index::make(t);
@@ -430,6 +508,19 @@ TEST(polymorphic) {
   REQUIRE(idx);
   MESSAGE("nil");
   REQUIRE(idx->push_back(nil));
+  MESSAGE("enumeration and map");
+  t = enumeration_type{{"foo", "bar"}};
+  idx = value_index::make(t);
+  REQUIRE(idx);
+  t = map_type{string_type{}, address_type{}};
+  idx = value_index::make(t);
+  REQUIRE(idx);
+  REQUIRE(idx->push_back(map{{"foo", *to<address>("10.0.0.1")}}));
+  buf.clear();
+  save(buf, detail::value_index_inspect_helper{t, idx});
+  load(buf, helper);
+  REQUIRE(idx2);
+  CHECK_EQUAL(to_string(*idx2->lookup(ni, "foo")), "1");
 }
 
 // Attention
@@ -439,6 +530,48 @@ TEST(polymorphic) {
 // comes from consistency. For x != 42 it may seem natural to include nil
 // values because they are not 42, but for <, <=, >=, > it becomes less clear:
 // should nil be less or great than any other value in the domain?
+TEST(batch append) {
+  // Compares batch appending against appending one value at a time, with nil
+  // values and gaps between IDs.
+  auto check = [](const type& t, const std::vector<data>& xs,
+                  const std::vector<data>& ys) {
+    auto idx1 = value_index::make(t);
+    auto idx2 = value_index::make(t);
+    REQUIRE(idx1);
+    REQUIRE(idx2);
+    for (auto i = 0u; i < xs.size(); ++i)
+      REQUIRE(idx1->push_back(xs[i], i + 10));
+    REQUIRE(idx1->push_back(xs[0], xs.size() + 20));
+    REQUIRE(idx2->append(xs, 10));
+    CHECK_EQUAL(idx2->offset(), xs.size() + 10);
+    REQUIRE(idx2->append({&xs[0], 1}, xs.size() + 20));
+    MESSAGE("rejects IDs before the end");
+    CHECK(!idx2->append(xs, 5));
+    auto ops = {equal, not_equal};
+    for (auto op : ops)
+      for (auto& y : ys) {
+        auto bm1 = idx1->lookup(op, y);
+        auto bm2 = idx2->lookup(op, y);
+        REQUIRE(bm1);
+        REQUIRE(bm2);
+        CHECK_EQUAL(to_string(*bm1), to_string(*bm2));
+      }
+  };
+  std::vector<data> xs;
+  for (auto i = 0; i < 100; ++i)
+    if (i % 7 == 3)
+      xs.emplace_back(nil);
+    else
+      xs.emplace_back(integer{i % 13 - 6});
+  MESSAGE("arithmetic index");
+  check(integer_type{}, xs, {integer{-6}, integer{0}, integer{1}, nil});
+  for (auto& x : xs)
+    if (auto i = get_if<integer>(x))
+      x = std::to_string(*i);
+  MESSAGE("default implementation");
+  check(string_type{}, xs, {"-6", "0", "1", nil});
+}
+
 TEST(polymorphic none values) {
   auto idx = value_index::make(string_type{});
   REQUIRE(idx->push_back(nil));
@@ -471,3 +604,373 @@ TEST(polymorphic none values) {
   REQUIRE(bm);
   CHECK_EQUAL(to_string(*bm), "00000001100000001110000");
 }
+
+TEST(offset) {
+  // An index whose first ID lies far beyond 0 only stores its local range,
+  // but lookups still yield results in the global ID space.
+  arithmetic_index<integer> idx{base::uniform(10, 20)};
+  REQUIRE(idx.push_back(42, 1000));
+  REQUIRE(idx.push_back(nil, 1001));
+  REQUIRE(idx.push_back(43, 1003));
+  auto xs = std::vector<data>{integer{42}, integer{44}};
+  REQUIRE(idx.append(xs, 1004));
+  CHECK_EQUAL(idx.offset(), 1006u);
+  CHECK(!idx.push_back(42, 999));
+  auto ids_of = [](std::initializer_list<id_range> xs) {
+    auto result = make_ids(xs);
+    result.append_bits(false, 1006 - result.size());
+    return to_string(result);
+  };
+  auto lookup = [&](relational_operator op, const data& x) {
+    auto result = idx.lookup(op, x);
+    REQUIRE(result);
+    CHECK_EQUAL(result->size(), 1006u);
+    return to_string(*result);
+  };
+  CHECK_EQUAL(lookup(equal, 42), ids_of({1000, 1004}));
+  CHECK_EQUAL(lookup(not_equal, 42), ids_of({1003, 1005}));
+  CHECK_EQUAL(lookup(greater, 42), ids_of({1003, 1005}));
+  CHECK_EQUAL(lookup(equal, nil), ids_of({1001}));
+  CHECK_EQUAL(lookup(in, vector{42, 44}), ids_of({1000, {1004, 1006}}));
+  CHECK_EQUAL(lookup(not_in, vector{42, 44}), ids_of({1003}));
+  MESSAGE("serialization");
+  std::vector<char> buf;
+  save(buf, idx);
+  arithmetic_index<integer> idx2{base::uniform(10, 20)};
+  load(buf, idx2);
+  CHECK_EQUAL(idx2.offset(), 1006u);
+  auto result = idx2.lookup(equal, 42);
+  REQUIRE(result);
+  CHECK_EQUAL(to_string(*result), ids_of({1000, 1004}));
+}
+
+TEST(statistics) {
+  std::unique_ptr<value_index> idx;
+  auto estimate = [&](relational_operator op, const data& x) {
+    auto result = idx->estimate(op, x);
+    REQUIRE(result);
+    return *result;
+  };
+  MESSAGE("arithmetic index");
+  idx = value_index::make(count_type{});
+  REQUIRE(idx);
+  for (auto i = 0u; i < 1000; ++i)
+    REQUIRE(idx->push_back(count{i % 100}));
+  REQUIRE(idx->push_back(nil));
+  CHECK(idx->distinct() >= 95 && idx->distinct() <= 105);
+  CHECK_EQUAL(estimate(equal, nil), 1u);
+  CHECK_EQUAL(estimate(not_equal, nil), 1000u);
+  auto x = estimate(equal, count{42});
+  CHECK(x >= 5 && x <= 50);
+  x = estimate(less, count{50});
+  CHECK(x >= 400 && x <= 600);
+  x = estimate(in, vector{count{1}, count{2}});
+  CHECK(x > 0 && x <= 100);
+  CHECK(!idx->estimate(match, count{42}));
+  CHECK(!idx->estimate(equal, "foo"));
+  MESSAGE("string index");
+  auto t = type{string_type{}};
+  idx = value_index::make(t);
+  REQUIRE(idx);
+  for (auto i = 0u; i < 1000; ++i)
+    REQUIRE(idx->push_back(i % 2 == 0 ? "foo"s : std::to_string(i)));
+  CHECK_EQUAL(estimate(equal, "foo"), 500u);
+  CHECK_EQUAL(estimate(not_equal, "foo"), 500u);
+  CHECK(estimate(equal, "41") <= 5);
+  MESSAGE("summary");
+  auto stats = idx->statistics();
+  auto xs = get_if<map>(stats);
+  REQUIRE(xs);
+  CHECK_EQUAL((*xs)["values"], data{count{1000}});
+  CHECK_EQUAL((*xs)["nils"], data{count{0}});
+  auto top = get_if<map>((*xs)["top"]);
+  REQUIRE(top);
+  CHECK_EQUAL(top->begin()->first, data{"foo"});
+  MESSAGE("serialization");
+  std::vector<char> buf;
+  save(buf, detail::value_index_inspect_helper{t, idx});
+  std::unique_ptr<value_index> idx2;
+  detail::value_index_inspect_helper helper{t, idx2};
+  load(buf, helper);
+  REQUIRE(idx2);
+  CHECK_EQUAL(idx2->statistics(), idx->statistics());
+  idx = std::move(idx2);
+  CHECK_EQUAL(estimate(equal, "foo"), 500u);
+}
+
+TEST(merge) {
+  // Merging must yield the same lookup results as appending all values to a
+  // single index.
+  using query = std::pair<relational_operator, data>;
+  auto check = [](const type& t, const std::vector<data>& xs,
+                  const std::vector<data>& ys, std::vector<query> queries) {
+    auto whole = value_index::make(t);
+    auto first = value_index::make(t);
+    auto second = value_index::make(t);
+    REQUIRE(whole && first && second);
+    for (auto i = 0u; i < xs.size(); ++i) {
+      REQUIRE(whole->push_back(xs[i], i));
+      REQUIRE(first->push_back(xs[i], i));
+    }
+    // Leave a gap between both indexes.
+    for (auto i = 0u; i < ys.size(); ++i) {
+      REQUIRE(whole->push_back(ys[i], 100 + i));
+      REQUIRE(second->push_back(ys[i], 100 + i));
+    }
+    REQUIRE(first->merge(*second));
+    CHECK_EQUAL(first->offset(), whole->offset());
+    CHECK_EQUAL(first->statistics(), whole->statistics());
+    queries.emplace_back(equal, nil);
+    for (auto& [op, x] : queries) {
+      auto expected = whole->lookup(op, x);
+      auto actual = first->lookup(op, x);
+      REQUIRE(expected && actual);
+      CHECK_EQUAL(to_string(*actual), to_string(*expected));
+    }
+  };
+  MESSAGE("arithmetic index");
+  check(integer_type{},
+        {integer{1}, integer{42}, nil, integer{7}, nil},
+        {integer{42}, nil, integer{-3}},
+        {{equal, integer{42}}, {less, integer{10}}, {not_equal, integer{7}},
+         {in, vector{integer{1}, integer{-3}}}});
+  check(boolean_type{}, {true, false, nil}, {nil, true},
+        {{equal, true}, {not_equal, true}});
+  MESSAGE("string index");
+  check(string_type{}, {"foo"s, "bar"s, nil}, {"foobar"s, ""s, "foo"s},
+        {{equal, "foo"s}, {not_equal, "bar"s}, {equal, ""s}, {ni, "oo"s}});
+  MESSAGE("address and subnet index");
+  auto a = *to<address>("10.0.0.1");
+  auto b = *to<address>("::1");
+  check(address_type{}, {a, nil, b}, {b, a},
+        {{equal, a}, {not_equal, b}, {in, *to<subnet>("10.0.0.0/8")}});
+  auto s = *to<subnet>("10.0.0.0/8");
+  auto u = *to<subnet>("192.168.0.0/24");
+  check(subnet_type{}, {s, u}, {nil, u, s},
+        {{equal, s}, {in, *to<subnet>("192.168.0.0/16")}, {ni, *to<subnet>("10.1.0.0/16")}});
+  MESSAGE("port and enumeration index");
+  check(port_type{}, {port{80, port::tcp}, port{53, port::udp}},
+        {port{80, port::tcp}},
+        {{equal, port{80, port::tcp}}, {less, port{60, port::unknown}}});
+  auto e = [](enumeration x) {
+    data result;
+    expose(result) = x;
+    return result;
+  };
+  check(enumeration_type{{"foo", "bar"}}, {e(0), nil}, {e(1), e(0)},
+        {{equal, e(0)}, {not_equal, "bar"}});
+  MESSAGE("container indexes");
+  check(vector_type{count_type{}}, {vector{count{1}, count{2}}, vector{}},
+        {vector{count{2}}, nil, vector{count{3}, count{1}}},
+        {{ni, count{1}}, {ni, count{2}}, {not_ni, count{3}}});
+  check(map_type{string_type{}, count_type{}}, {map{{"foo", count{1}}}},
+        {map{{"foo", count{2}}, {"bar", count{1}}}},
+        {{ni, "foo"s}, {ni, map{{"foo", count{2}}}}, {ni, "bar"s}});
+  MESSAGE("only nils");
+  check(integer_type{}, {integer{1}, nil}, {nil, nil},
+        {{equal, integer{1}}});
+  MESSAGE("invalid merges");
+  auto x = value_index::make(integer_type{});
+  auto y = value_index::make(count_type{});
+  REQUIRE(x && y);
+  REQUIRE(x->push_back(integer{1}, 10));
+  REQUIRE(y->push_back(count{1}, 20));
+  CHECK(!x->merge(*y));
+  auto z = value_index::make(integer_type{});
+  REQUIRE(z->push_back(integer{1}, 5));
+  CHECK(!x->merge(*z));
+  REQUIRE(x->merge(*z, 20));
+  auto expected = std::string(26, '0');
+  expected[10] = expected[25] = '1';
+  CHECK_EQUAL(to_string(*x->lookup(equal, integer{1})), expected);
+}
+
+TEST(merge - unaligned) {
+  // Adjacent ID ranges whose boundary is not a multiple of 64 overlap in the
+  // rounded base of the second index.
+  auto check = [](const type& t, auto make) {
+    auto whole = value_index::make(t);
+    auto first = value_index::make(t);
+    auto second = value_index::make(t);
+    REQUIRE(whole && first && second);
+    for (auto i = 0u; i < 200; ++i) {
+      auto x = make(i);
+      REQUIRE(whole->push_back(x, i));
+      REQUIRE((i < 100 ? first : second)->push_back(x, i));
+    }
+    REQUIRE(first->merge(*second));
+    CHECK_EQUAL(first->offset(), 200u);
+    for (auto i : {0u, 63u, 99u, 100u, 127u, 199u}) {
+      auto x = make(i);
+      auto expected = whole->lookup(equal, x);
+      auto actual = first->lookup(equal, x);
+      REQUIRE(expected && actual);
+      CHECK_EQUAL(to_string(*actual), to_string(*expected));
+    }
+    auto all = first->lookup(not_equal, nil);
+    REQUIRE(all);
+    CHECK_EQUAL(rank(*all), 200u);
+  };
+  check(count_type{}, [](auto i) -> data { return count{i % 7}; });
+  check(string_type{}, [](auto i) -> data { return std::to_string(i % 13); });
+  check(vector_type{count_type{}},
+        [](auto i) -> data { return vector{count{i}, count{i % 3}}; });
+  MESSAGE("overlapping entries remain invalid");
+  auto x = value_index::make(count_type{});
+  auto y = value_index::make(count_type{});
+  REQUIRE(x && y);
+  REQUIRE(x->push_back(count{1}, 100));
+  REQUIRE(y->push_back(count{1}, 99));
+  CHECK(!x->merge(*y));
+}
+
+TEST(merge - persisted) {
+  // Indexes that went through serialization must merge like fresh ones, even
+  // if they consist of nils only or end with nils.
+  using query = std::pair<relational_operator, data>;
+  auto roundtrip = [](const type& t, std::unique_ptr<value_index>& idx) {
+    std::vector<char> buf;
+    save(buf, detail::value_index_inspect_helper{t, idx});
+    std::unique_ptr<value_index> result;
+    detail::value_index_inspect_helper helper{t, result};
+    load(buf, helper);
+    return result;
+  };
+  auto check = [&](const type& t, const std::vector<data>& xs,
+                   const std::vector<data>& ys, const data& z,
+                   std::vector<query> queries) {
+    auto whole = value_index::make(t);
+    auto first = value_index::make(t);
+    auto second = value_index::make(t);
+    REQUIRE(whole && first && second);
+    for (auto i = 0u; i < xs.size(); ++i) {
+      REQUIRE(whole->push_back(xs[i], i));
+      REQUIRE(first->push_back(xs[i], i));
+    }
+    for (auto i = 0u; i < ys.size(); ++i) {
+      REQUIRE(whole->push_back(ys[i], 100 + i));
+      REQUIRE(second->push_back(ys[i], 100 + i));
+    }
+    first = roundtrip(t, first);
+    second = roundtrip(t, second);
+    REQUIRE(first && second);
+    REQUIRE(first->merge(*second));
+    // Appending after the merge relies on the trailing nils of *second*.
+    REQUIRE(whole->push_back(z, 200));
+    REQUIRE(first->push_back(z, 200));
+    CHECK_EQUAL(first->offset(), whole->offset());
+    queries.emplace_back(equal, nil);
+    queries.emplace_back(not_equal, nil);
+    for (auto& [op, x] : queries) {
+      auto expected = whole->lookup(op, x);
+      auto actual = first->lookup(op, x);
+      REQUIRE(expected && actual);
+      CHECK_EQUAL(to_string(*actual), to_string(*expected));
+    }
+  };
+  MESSAGE("all-nil container indexes");
+  check(vector_type{count_type{}}, {vector{count{1}}, nil}, {nil, nil},
+        vector{count{2}}, {{ni, count{1}}, {ni, count{2}}});
+  check(vector_type{count_type{}}, {nil}, {nil, vector{count{3}}, nil},
+        vector{count{3}}, {{ni, count{3}}});
+  check(map_type{string_type{}, count_type{}}, {map{{"foo", count{1}}}},
+        {nil}, map{{"bar", count{2}}},
+        {{ni, "foo"s}, {ni, "bar"s}, {ni, map{{"bar", count{2}}}}});
+  MESSAGE("all-nil scalar indexes");
+  check(string_type{}, {"foo"s, nil}, {nil, nil}, "bar"s,
+        {{equal, "foo"s}, {equal, "bar"s}});
+  auto a = *to<address>("10.0.0.1");
+  check(address_type{}, {a}, {nil}, a, {{equal, a}});
+  check(subnet_type{}, {*to<subnet>("10.0.0.0/8")}, {nil},
+        *to<subnet>("10.0.0.0/8"), {{equal, *to<subnet>("10.0.0.0/8")}});
+  check(port_type{}, {port{80, port::tcp}}, {nil}, port{53, port::udp},
+        {{equal, port{80, port::tcp}}, {equal, port{53, port::udp}}});
+  MESSAGE("trailing nils");
+  check(integer_type{}, {integer{1}}, {integer{2}, nil, nil}, integer{3},
+        {{equal, integer{2}}, {equal, integer{3}}});
+}
+
+TEST(time) {
+  // The time index must agree with the general purpose timestamp index,
+  // regardless of how much the timestamps deviate from their order.
+  type sorted = timestamp_type{}.attributes({{"sorted"}});
+  auto at = [](int64_t secs) -> data {
+    return timestamp{std::chrono::seconds(secs)};
+  };
+  auto check = [&](const std::vector<data>& xs) {
+    auto expected = value_index::make(timestamp_type{});
+    auto actual = value_index::make(sorted);
+    REQUIRE(expected && actual);
+    for (auto& x : xs) {
+      REQUIRE(expected->push_back(x));
+      REQUIRE(actual->push_back(x));
+    }
+    for (auto op : {less, less_equal, greater, greater_equal, equal,
+                    not_equal})
+      for (auto secs : {-1, 0, 3, 10, 42, 500, 10000}) {
+        auto x = expected->lookup(op, at(secs));
+        auto y = actual->lookup(op, at(secs));
+        REQUIRE(x && y);
+        CHECK_EQUAL(to_string(*y), to_string(*x));
+      }
+    auto x = expected->lookup(equal, nil);
+    auto y = actual->lookup(equal, nil);
+    REQUIRE(x && y);
+    CHECK_EQUAL(to_string(*y), to_string(*x));
+    return actual;
+  };
+  MESSAGE("sorted");
+  auto idx = value_index::make(sorted);
+  REQUIRE(idx);
+  CHECK(dynamic_cast<time_index*>(idx.get()) != nullptr);
+  std::vector<data> xs;
+  for (auto i = 0; i < 1000; ++i)
+    xs.push_back(at(i / 2));
+  check(xs);
+  MESSAGE("nearly sorted with nils");
+  xs[3] = at(42);
+  xs[100] = nil;
+  xs[101] = at(0);
+  xs[500] = at(3);
+  xs[501] = nil;
+  xs.push_back(at(10));
+  auto nearly = check(xs);
+  CHECK(!static_cast<time_index&>(*nearly).disordered());
+  MESSAGE("disordered");
+  std::vector<data> ys;
+  for (auto i = 0; i < 5000; ++i)
+    ys.push_back(at((i * 7919) % 5000));
+  auto disordered = check(ys);
+  CHECK(static_cast<time_index&>(*disordered).disordered());
+  MESSAGE("merge");
+  for (auto& zs : {xs, ys}) {
+    auto whole = value_index::make(sorted);
+    auto first = value_index::make(sorted);
+    auto second = value_index::make(sorted);
+    REQUIRE(whole && first && second);
+    for (auto i = 0u; i < zs.size(); ++i) {
+      REQUIRE(whole->push_back(zs[i], i));
+      REQUIRE((i < zs.size() / 2 ? first : second)->push_back(zs[i], i));
+    }
+    REQUIRE(first->merge(*second));
+    for (auto secs : {0, 3, 42, 500}) {
+      auto x = whole->lookup(greater_equal, at(secs));
+      auto y = first->lookup(greater_equal, at(secs));
+      REQUIRE(x && y);
+      CHECK_EQUAL(to_string(*y), to_string(*x));
+    }
+  }
+  MESSAGE("serialization");
+  std::vector<char> buf;
+  save(buf, detail::value_index_inspect_helper{sorted, nearly});
+  std::unique_ptr<value_index> idx2;
+  detail::value_index_inspect_helper helper{sorted, idx2};
+  load(buf, helper);
+  REQUIRE(idx2);
+  for (auto op : {less, equal, greater_equal}) {
+    auto x = nearly->lookup(op, at(42));
+    auto y = idx2->lookup(op, at(42));
+    REQUIRE(x && y);
+    CHECK_EQUAL(to_string(*y), to_string(*x));
+  }
+}
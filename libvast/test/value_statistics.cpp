@@ -0,0 +1,132 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <string>
+
+#include "vast/concept/hashable/uhash.hpp"
+#include "vast/concept/hashable/xxhash.hpp"
+#include "vast/load.hpp"
+#include "vast/save.hpp"
+#include "vast/value_statistics.hpp"
+
+#define SUITE value_statistics
+#include "test.hpp"
+
+using namespace vast;
+
+namespace {
+
+uint64_t digest(uint64_t x) {
+  return uhash<xxhash64>{}(x);
+}
+
+} // namespace <anonymous>
+
+TEST(hyperloglog) {
+  hyperloglog hll;
+  CHECK_EQUAL(hll.estimate(), 0.0);
+  for (auto i = 0u; i < 10; ++i)
+    hll.add(digest(i));
+  CHECK(hll.estimate() > 9.5 && hll.estimate() < 10.5);
+  MESSAGE("duplicates");
+  for (auto i = 0u; i < 10; ++i)
+    hll.add(digest(i));
+  CHECK(hll.estimate() > 9.5 && hll.estimate() < 10.5);
+  MESSAGE("large cardinalities");
+  for (auto i = 0u; i < 100000; ++i)
+    hll.add(digest(i));
+  CHECK(hll.estimate() > 90000 && hll.estimate() < 110000);
+  MESSAGE("merge");
+  hyperloglog other;
+  for (auto i = 100000u; i < 200000; ++i)
+    other.add(digest(i));
+  hll.merge(other);
+  CHECK(hll.estimate() > 180000 && hll.estimate() < 220000);
+  MESSAGE("serialization");
+  std::vector<char> buf;
+  save(buf, hll);
+  hyperloglog copy;
+  load(buf, copy);
+  CHECK_EQUAL(copy.estimate(), hll.estimate());
+}
+
+TEST(equi-depth histogram) {
+  equi_depth_histogram<int> hist;
+  CHECK(hist.boundaries(4).empty());
+  CHECK_EQUAL(hist.selectivity(less, 42), 0.0);
+  for (auto i = 0; i < 10000; ++i)
+    hist.add(i % 1000);
+  CHECK_EQUAL(hist.size(), 10000u);
+  auto xs = hist.boundaries(4);
+  REQUIRE_EQUAL(xs.size(), 5u);
+  CHECK(std::is_sorted(xs.begin(), xs.end()));
+  CHECK(xs[2] > 400 && xs[2] < 600);
+  CHECK(hist.selectivity(less, 500) > 0.4);
+  CHECK(hist.selectivity(less, 500) < 0.6);
+  CHECK_EQUAL(hist.selectivity(less, 0), 0.0);
+  CHECK_EQUAL(hist.selectivity(less_equal, 1000), 1.0);
+  CHECK_EQUAL(hist.selectivity(greater, 1000), 0.0);
+  CHECK_EQUAL(hist.selectivity(equal, 5000), 0.0);
+  CHECK_EQUAL(hist.selectivity(not_equal, 5000), 1.0);
+  CHECK(hist.selectivity(match, 42) < 0);
+  MESSAGE("serialization");
+  std::vector<char> buf;
+  save(buf, hist);
+  equi_depth_histogram<int> copy;
+  load(buf, copy);
+  CHECK_EQUAL(copy.boundaries(4), xs);
+  MESSAGE("merge");
+  equi_depth_histogram<int> other;
+  for (auto i = 0; i < 10000; ++i)
+    other.add(1000 + i % 1000);
+  hist.merge(other);
+  CHECK_EQUAL(hist.size(), 20000u);
+  CHECK_EQUAL(hist.selectivity(less, 1000), 0.5);
+  CHECK_EQUAL(hist.boundaries(4).size(), 5u);
+}
+
+TEST(top-k) {
+  top_k<std::string> top;
+  for (auto i = 0; i < 1000; ++i) {
+    top.add(std::string{i % 3 == 0 ? "foo" : "bar"});
+    top.add(std::to_string(i));
+  }
+  auto xs = top.entries();
+  REQUIRE_EQUAL(xs.size(), top_k<std::string>::capacity);
+  CHECK_EQUAL(xs[0].value, "bar");
+  CHECK_EQUAL(xs[0].frequency, 666u);
+  CHECK_EQUAL(xs[1].value, "foo");
+  CHECK_EQUAL(xs[1].frequency, 334u);
+  CHECK_EQUAL(xs[1].error, 0u);
+  auto e = top.find(std::string{"foo"});
+  REQUIRE(e);
+  CHECK_EQUAL(e->frequency, 334u);
+  CHECK(top.find(std::string{"42"}) == nullptr);
+  MESSAGE("serialization");
+  std::vector<char> buf;
+  save(buf, top);
+  top_k<std::string> copy;
+  load(buf, copy);
+  REQUIRE(copy.find(std::string{"foo"}));
+  CHECK_EQUAL(copy.find(std::string{"foo"})->frequency, 334u);
+  MESSAGE("merge");
+  top_k<std::string> other;
+  for (auto i = 0; i < 500; ++i)
+    other.add(std::string{"foo"});
+  top.merge(other);
+  xs = top.entries();
+  CHECK_EQUAL(xs.size(), top_k<std::string>::capacity);
+  CHECK_EQUAL(xs[0].value, "foo");
+  CHECK_EQUAL(xs[0].frequency, 834u);
+}
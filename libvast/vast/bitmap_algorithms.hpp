@@ -15,8 +15,11 @@
 
 #include <algorithm>
 #include <iterator>
+#include <limits>
 #include <queue>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "vast/aliases.hpp"
 #include "vast/bits.hpp"
@@ -28,9 +31,46 @@
 namespace vast {
 
 class bitmap;
+class ewah_bitmap;
 
 namespace detail {
 
+/// Computes the conjunction of multiple EWAH bitmaps in a single pass.
+ewah_bitmap ewah_nary_and(const std::vector<const ewah_bitmap*>& xs);
+
+/// Computes the disjunction of multiple EWAH bitmaps in a single pass.
+ewah_bitmap ewah_nary_or(const std::vector<const ewah_bitmap*>& xs);
+
+/// Computes `x & ~y & z` over EWAH bitmaps in a single pass.
+ewah_bitmap ewah_and_not_and(const ewah_bitmap& x, const ewah_bitmap& y,
+                             const ewah_bitmap& z);
+
+/// @returns A pointer to the EWAH bitmap inside *bm* or `nullptr` if *bm*
+///          holds a different bitmap type.
+const ewah_bitmap* ewah_cast(const bitmap& bm);
+
+inline const ewah_bitmap* ewah_cast(const ewah_bitmap& bm) {
+  return &bm;
+}
+
+/// Collects pointers to EWAH bitmaps from a range of bitmaps.
+/// @returns `true` iff all bitmaps in *[begin, end)* are EWAH bitmaps.
+template <class Iterator>
+bool collect_ewah(Iterator begin, Iterator end,
+                  std::vector<const ewah_bitmap*>& xs) {
+  for (; begin != end; ++begin)
+    if (auto x = ewah_cast(*begin))
+      xs.push_back(x);
+    else
+      return false;
+  return true;
+}
+
+/// Checks whether a type may hold an EWAH bitmap.
+template <class T>
+constexpr bool is_ewah_compatible_v = std::is_same_v<T, ewah_bitmap>
+                                      || std::is_same_v<T, bitmap>;
+
 template <class T, class U>
 struct eval_result_type {
   using type = std::conditional_t<std::is_same_v<T, U>, T, bitmap>;
@@ -231,12 +271,27 @@ auto binary_nor(const LHS& lhs, const RHS& rhs) {
 
 template <class Iterator>
 auto nary_and(Iterator begin, Iterator end) {
+  using bitmap_type = std::decay_t<decltype(*begin)>;
+  if constexpr (std::is_same_v<bitmap_type, ewah_bitmap>
+                || std::is_same_v<bitmap_type, bitmap>) {
+    // EWAH bitmaps support a single pass over all inputs.
+    std::vector<const ewah_bitmap*> xs;
+    if (detail::collect_ewah(begin, end, xs))
+      return bitmap_type{detail::ewah_nary_and(xs)};
+  }
   auto op = [](auto x, auto y) { return x & y; };
   return nary_eval(begin, end, op);
 }
 
 template <class Iterator>
 auto nary_or(Iterator begin, Iterator end) {
+  using bitmap_type = std::decay_t<decltype(*begin)>;
+  if constexpr (std::is_same_v<bitmap_type, ewah_bitmap>
+                || std::is_same_v<bitmap_type, bitmap>) {
+    std::vector<const ewah_bitmap*> xs;
+    if (detail::collect_ewah(begin, end, xs))
+      return bitmap_type{detail::ewah_nary_or(xs)};
+  }
   auto op = [](auto x, auto y) { return x | y; };
   return nary_eval(begin, end, op);
 }
@@ -247,6 +302,176 @@ auto nary_xor(Iterator begin, Iterator end) {
   return nary_eval(begin, end, op);
 }
 
+/// Walks over the bit sequences of a bitmap such that multiple cursors can
+/// advance in lockstep, even when their sequences have different lengths.
+/// Past the end of the bitmap, the cursor yields an infinite fill of a padding
+/// bit.
+template <class Bitmap>
+class bit_cursor {
+public:
+  using word_type = typename Bitmap::word_type;
+  using block_type = typename word_type::value_type;
+  using size_type = typename Bitmap::size_type;
+
+  /// Constructs a cursor from a bitmap.
+  /// @param bm The bitmap to walk over.
+  /// @param pad The value of the bits after the end of *bm*.
+  explicit bit_cursor(const Bitmap& bm, bool pad = false)
+    : range_{bit_range(bm)},
+      pad_{pad ? word_type::all : word_type::none} {
+    load();
+  }
+
+  /// @returns `true` iff the cursor points to a homogeneous sequence of bits
+  ///          longer than a single block.
+  bool fill() const {
+    return fill_;
+  }
+
+  /// @returns The current block, with the next bit at the LSB.
+  block_type block() const {
+    return block_;
+  }
+
+  /// @returns The number of remaining bits in the current sequence.
+  size_type length() const {
+    return length_;
+  }
+
+  /// Consumes bits of the current sequence.
+  /// @param n The number of bits to consume.
+  /// @pre `n <= length()`
+  void advance(size_type n) {
+    VAST_ASSERT(n <= length_);
+    length_ -= n;
+    if (length_ == 0) {
+      range_.next();
+      load();
+    } else if (!fill_) {
+      block_ >>= n;
+    }
+  }
+
+private:
+  void load() {
+    // Some ranges end with an empty sequence, which we skip.
+    while (!range_.done() && range_.get().size() == 0)
+      range_.next();
+    if (range_.done()) {
+      fill_ = true;
+      block_ = pad_;
+      length_ = std::numeric_limits<size_type>::max();
+    } else {
+      auto& bits = range_.get();
+      fill_ = bits.size() > word_type::width;
+      block_ = bits.data();
+      length_ = bits.size();
+    }
+  }
+
+  decltype(bit_range(std::declval<const Bitmap&>())) range_;
+  block_type pad_;
+  block_type block_;
+  size_type length_;
+  bool fill_;
+};
+
+namespace detail {
+
+// Evaluates a bitwise operation one run of words at a time, which requires
+// cursors that expose runs of clean and dirty words.
+template <class Bitmap, class Operation, class... Cursors>
+Bitmap fused_eval_runs(typename Bitmap::size_type n, Operation op,
+                       Cursors&... xs) {
+  using word_type = typename Bitmap::word_type;
+  using block_type = typename Bitmap::block_type;
+  using size_type = typename Bitmap::size_type;
+  Bitmap result;
+  if (n == 0)
+    return result;
+  std::vector<block_type> buffer;
+  // We process all but the last word in runs, as the last word may be
+  // partial.
+  auto words = (n - 1) / word_type::width;
+  while (words > 0) {
+    auto k = std::min({words, xs.words()...});
+    if ((xs.clean() && ...)) {
+      auto block = op(xs.block()...);
+      VAST_ASSERT(word_type::all_or_none(block));
+      result.append_bits(block != word_type::none, k * word_type::width);
+    } else {
+      buffer.resize(k);
+      for (size_type i = 0; i < k; ++i)
+        buffer[i] = op(xs.word(i)...);
+      result.append_blocks(buffer.data(), buffer.data() + k);
+    }
+    (xs.skip(k), ...);
+    words -= k;
+  }
+  result.append_block(op(xs.block()...), n - result.size());
+  return result;
+}
+
+} // namespace detail
+
+/// Applies a bitwise operation to multiple bitmaps in a single pass, without
+/// creating intermediate results.
+/// @tparam Bitmap The type of the result.
+/// @param n The size of the result.
+/// @param op The bitwise operation as block-wise lambda taking one block per
+///           cursor, e.g., for `x & ~y`:
+///
+///     [](auto x, auto y) { return x & ~y; }
+///
+/// @param xs The cursors over the input bitmaps.
+/// @returns The result of *op* over the first *n* bits of *xs*.
+template <class Bitmap, class Operation, class... Cursors>
+Bitmap fused_eval(typename Bitmap::size_type n, Operation op, Cursors... xs) {
+  using word_type = typename Bitmap::word_type;
+  static_assert(sizeof...(Cursors) > 0, "need at least one input");
+  if constexpr (std::is_same_v<Bitmap, ewah_bitmap>
+                && (std::is_same_v<Cursors, bit_cursor<Bitmap>> && ...))
+    return detail::fused_eval_runs<Bitmap>(n, op, xs...);
+  Bitmap result;
+  while (n > 0) {
+    auto block = op(xs.block()...);
+    auto k = std::min({n, xs.length()...});
+    if ((xs.fill() && ...)) {
+      VAST_ASSERT(word_type::all_or_none(block));
+      result.append_bits(block != word_type::none, k);
+    } else {
+      // At least one literal bounds the step to a single block.
+      result.append_block(block, k);
+    }
+    (xs.advance(k), ...);
+    n -= k;
+  }
+  return result;
+}
+
+/// Computes `x & ~y & z` in a single pass. This is the typical operation to
+/// restrict a query result to valid rows, e.g., by removing NULL values and
+/// applying a mask.
+/// @param x The bitmap to restrict.
+/// @param y The bitmap with the bits to remove from *x*.
+/// @param z The mask.
+/// @returns A bitmap of size `max(x.size(), z.size())`.
+template <class X, class Y, class Z>
+X and_not_and(const X& x, const Y& y, const Z& z) {
+  if constexpr (detail::is_ewah_compatible_v<X>
+                && detail::is_ewah_compatible_v<Y>
+                && detail::is_ewah_compatible_v<Z>) {
+    auto ex = detail::ewah_cast(x);
+    auto ey = detail::ewah_cast(y);
+    auto ez = detail::ewah_cast(z);
+    if (ex && ey && ez)
+      return X{detail::ewah_and_not_and(*ex, *ey, *ez)};
+  }
+  auto op = [](auto a, auto b, auto c) { return a & ~b & c; };
+  return fused_eval<X>(std::max(x.size(), z.size()), op, bit_cursor<X>{x},
+                       bit_cursor<Y>{y}, bit_cursor<Z>{z});
+}
+
 /// Computes the *rank* of a Bitmap, i.e., the number of occurrences of a bit
 /// value in *B[0,i]*.
 /// @tparam Bit The bit value to count.
@@ -295,7 +520,7 @@ select(const Bitmap& bm, typename Bitmap::size_type i) {
   if (i == Bitmap::word_type::npos) {
     auto last = Bitmap::word_type::npos;
     for (auto b : bit_range(bm)) {
-      auto l = find_last(b);
+      auto l = find_last<Bit>(b);
       if (l != Bitmap::word_type::npos)
         last = n + l;
       n += b.size();
@@ -488,5 +713,28 @@ auto all(const Bitmap& bm) {
   return !any<!Bit>(bm);
 }
 
+/// Removes a prefix of a bitmap.
+/// @param bm The bitmap to remove the prefix from.
+/// @param n The number of bits to remove.
+/// @returns A copy of *bm* without its first *n* bits, which is empty if *n*
+///          exceeds the size of *bm*.
+template <class Bitmap>
+Bitmap drop(const Bitmap& bm, typename Bitmap::size_type n) {
+  using word_type = typename Bitmap::word_type;
+  Bitmap result;
+  for (auto b : bit_range(bm)) {
+    if (n >= b.size()) {
+      n -= b.size();
+      continue;
+    }
+    if (b.size() > word_type::width)
+      result.append_bits(b.data(), b.size() - n);
+    else
+      result.append_block(b.data() >> n, b.size() - n);
+    n = 0;
+  }
+  return result;
+}
+
 } // namespace vast
 
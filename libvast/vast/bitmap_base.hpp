@@ -176,31 +176,41 @@ public:
   //
   // Derived types should provide an optimized version where possible.
 
-  Derived& operator&=(Derived const rhs) {
+  Derived& operator&=(const Derived& rhs) {
     derived() = derived() & rhs;
     return derived();
   }
 
-  Derived& operator|=(Derived const rhs) {
+  Derived& operator|=(const Derived& rhs) {
     derived() = derived() | rhs;
     return derived();
   }
 
-  Derived& operator^=(Derived const rhs) {
+  Derived& operator^=(const Derived& rhs) {
     derived() = derived() ^ rhs;
     return derived();
   }
 
-  Derived& operator-=(Derived const rhs) {
+  Derived& operator-=(const Derived& rhs) {
     derived() = derived() - rhs;
     return derived();
   }
 
-  Derived& operator/=(Derived const rhs) {
+  Derived& operator/=(const Derived& rhs) {
     derived() = derived() / rhs;
     return derived();
   }
 
+  /// Computes `*this & ~y & z` in a single pass, without intermediate
+  /// results.
+  /// @param y The bitmap with the bits to remove.
+  /// @param z The mask to apply.
+  template <class Y, class Z>
+  Derived& and_not_and(const Y& y, const Z& z) {
+    derived() = vast::and_not_and(derived(), y, z);
+    return derived();
+  }
+
 private:
   Derived& derived() {
     return *static_cast<Derived*>(this);
@@ -0,0 +1,107 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "vast/bitmap.hpp"
+#include "vast/ewah_bitmap.hpp"
+
+namespace vast {
+
+/// Evaluates a Boolean combination of bitmaps in a single pass. Users first
+/// build a DAG of conjunctions, disjunctions, and negations over leaf bitmaps
+/// and then evaluate it block by block, producing a single output bitmap
+/// without materializing intermediate results per operator.
+///
+/// The value of a node beyond its size is 0, where the size of a leaf is the
+/// size of its bitmap, the size of a negation is the size of its operand, and
+/// the size of a conjunction or disjunction is the maximum size of its
+/// operands. This mirrors the semantics of the corresponding bitwise
+/// operations on bitmaps of different lengths.
+class bitmap_evaluator {
+public:
+  using size_type = ewah_bitmap::size_type;
+  using block_type = ewah_bitmap::block_type;
+  using word_type = ewah_bitmap::word_type;
+
+  /// Identifies a node in the DAG.
+  using node_id = uint32_t;
+
+  /// The maximum number of words to evaluate at once.
+  static constexpr size_type chunk_words = 1024;
+
+  /// Adds a leaf to the DAG. Adding the same bitmap multiple times yields the
+  /// same node.
+  /// @param bm The bitmap, which must outlive the evaluator.
+  /// @returns The ID of the leaf.
+  node_id add_leaf(const ewah_bitmap& bm);
+
+  /// Adds a leaf to the DAG. The evaluator copies *bm* into an EWAH bitmap if
+  /// it holds a different bitmap type.
+  /// @param bm The bitmap, which must outlive the evaluator.
+  /// @returns The ID of the leaf.
+  node_id add_leaf(const bitmap& bm);
+
+  /// Adds the negation of a node.
+  /// @param x The node to negate.
+  /// @returns The ID of the negation.
+  node_id add_negation(node_id x);
+
+  /// Adds the conjunction of multiple nodes.
+  /// @param xs The operands of the conjunction.
+  /// @returns The ID of the conjunction.
+  /// @pre `!xs.empty()`
+  node_id add_conjunction(std::vector<node_id> xs);
+
+  /// Adds the disjunction of multiple nodes.
+  /// @param xs The operands of the disjunction.
+  /// @returns The ID of the disjunction.
+  /// @pre `!xs.empty()`
+  node_id add_disjunction(std::vector<node_id> xs);
+
+  /// @returns The size of the bitmap that node *x* evaluates to.
+  size_type size(node_id x) const;
+
+  /// Evaluates the DAG rooted at a given node.
+  /// @param root The node to evaluate.
+  /// @returns The bitmap of *root*.
+  ewah_bitmap evaluate(node_id root) const;
+
+private:
+  enum class kind : uint8_t {
+    leaf,
+    negation,
+    conjunction,
+    disjunction
+  };
+
+  struct node {
+    kind type;
+    size_type size;
+    std::vector<node_id> operands;
+    const ewah_bitmap* leaf;
+  };
+
+  node_id add(node x);
+
+  std::vector<node> nodes_;
+  std::unordered_map<const ewah_bitmap*, node_id> leaves_;
+  std::deque<ewah_bitmap> copies_;
+};
+
+} // namespace vast
@@ -13,12 +13,16 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <type_traits>
+#include <vector>
 
 #include "vast/base.hpp"
 #include "vast/binner.hpp"
 #include "vast/coder.hpp"
 #include "vast/detail/order.hpp"
+#include "vast/detail/span.hpp"
 
 namespace vast {
 
@@ -72,12 +76,73 @@ public:
     coder_.encode(transform(binner_type::bin(x)), n, skip);
   }
 
+  /// Appends a sequence of values to the bitmap index. This is equivalent to
+  /// calling ::push_back for each value, but lets the coder append entire
+  /// bitmap blocks at once.
+  /// @param xs The values to append.
+  /// @param skip The number of entries to skip before appending *xs*.
+  /// @param threads The number of threads that multi-level coders may use to
+  ///                encode disjoint chunks of *xs* concurrently.
+  /// @post Skipped entries show up as 0s during decoding.
+  void append(detail::span<const value_type> xs, size_type skip = 0,
+              size_t threads = 1) {
+    using coder_value_type = typename coder_type::value_type;
+    if constexpr (is_multi_level_coder<coder_type>{}) {
+      if (threads > 1) {
+        std::vector<coder_value_type> ys(xs.size());
+        std::transform(xs.begin(), xs.end(), ys.begin(),
+                       [](value_type x) -> coder_value_type {
+                         return transform(binner_type::bin(x));
+                       });
+        coder_.encode(ys, skip, threads);
+        return;
+      }
+    }
+    std::array<coder_value_type, 1024> buffer;
+    while (!xs.empty()) {
+      auto n = std::min(xs.size(), static_cast<std::ptrdiff_t>(buffer.size()));
+      auto chunk = xs.first(n);
+      std::transform(chunk.begin(), chunk.end(), buffer.begin(),
+                     [](value_type x) -> coder_value_type {
+                       return transform(binner_type::bin(x));
+                     });
+      coder_.encode({buffer.data(), chunk.size()}, skip);
+      skip = 0;
+      xs = xs.subspan(chunk.size());
+    }
+  }
+
   /// Appends the contents of another bitmap index to this one.
   /// @param other The other bitmap index.
-  void append(const bitmap_index& other) {
+  /// @param skip The number of entries to skip before appending *other*.
+  /// @post Skipped entries show up as 0s during decoding.
+  void append(const bitmap_index& other, size_type skip = 0) {
+    if (skip > 0)
+      coder_.encode(typename coder_type::value_type{}, 0, skip);
     coder_.append(other.coder_);
   }
 
+  /// Appends the contents of another bitmap index such that its first entry
+  /// becomes entry *pos* of this one.
+  /// @param other The other bitmap index.
+  /// @param pos The position of the first entry of *other*.
+  /// @pre The entries of *other* that overlap with this index hold no values.
+  void append_at(const bitmap_index& other, size_type pos) {
+    if (pos >= size()) {
+      append(other, pos - size());
+      return;
+    }
+    auto tail = other;
+    tail.drop(size() - pos);
+    append(tail);
+  }
+
+  /// Removes entries from the front of the bitmap index.
+  /// @param n The number of entries to remove.
+  void drop(size_type n) {
+    coder_.drop(n);
+  }
+
   /// Retrieves a bitmap of a given value with respect to a given operator.
   /// @param op The relational operator to use for looking up *x*.
   /// @param x The value to find the bitmap for.
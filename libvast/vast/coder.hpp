@@ -16,6 +16,7 @@
 #include <algorithm>
 #include <array>
 #include <limits>
+#include <thread>
 #include <vector>
 #include <type_traits>
 
@@ -23,9 +24,11 @@
 #include <caf/meta/save_callback.hpp>
 
 #include "vast/base.hpp"
+#include "vast/bitmap_algorithms.hpp"
 #include "vast/operator.hpp"
 #include "vast/detail/assert.hpp"
 #include "vast/detail/operators.hpp"
+#include "vast/detail/span.hpp"
 
 namespace vast {
 
@@ -49,6 +52,14 @@ struct coder {
   /// @post Skipped entries show up as 0s during decoding.
   void encode(value_type x, size_type n = 1, size_type skip = 0);
 
+  /// Encodes a sequence of values. Coders process the values in chunks of
+  /// one bitmap block and append entire blocks instead of individual bits.
+  /// @param xs The values to encode.
+  /// @param skip The number of entries to skip before encoding *xs*.
+  /// @pre `Bitmap::max_size - size() >= xs.size() + skip`
+  /// @post Skipped entries show up as 0s during decoding.
+  void encode(detail::span<const value_type> xs, size_type skip = 0);
+
   /// Decodes a value under a relational operator.
   /// @param x The value to decode.
   /// @param op The relation operator under which to decode *x*.
@@ -61,6 +72,10 @@ struct coder {
   /// @pre `size() + other.size() < Bitmap::max_size`
   void append(const coder& other);
 
+  /// Removes entries from the front.
+  /// @param n The number of entries to remove.
+  void drop(size_type n);
+
   /// Retrieves the number entries in the coder, i.e., the number of rows.
   /// @returns The size of the coder measured in number of entries.
   size_type size() const;
@@ -82,6 +97,23 @@ public:
     bitmap_.append_bits(x, n + skip);
   }
 
+  void encode(detail::span<const value_type> xs, size_type skip = 0) {
+    using block_type = typename Bitmap::block_type;
+    using word_type = typename Bitmap::word_type;
+    auto size = static_cast<size_type>(xs.size());
+    VAST_ASSERT(Bitmap::max_size - this->size() >= size + skip);
+    if (size == 0)
+      return;
+    bitmap_.append_bits(xs[0], skip);
+    for (size_type i = 0; i < size; i += word_type::width) {
+      auto n = std::min<size_type>(size - i, word_type::width);
+      block_type block = 0;
+      for (size_type j = 0; j < n; ++j)
+        block |= block_type{xs[i + j]} << j;
+      bitmap_.append_block(block, n);
+    }
+  }
+
   Bitmap decode(relational_operator op, value_type x) const {
     VAST_ASSERT(op == equal || op == not_equal);
     auto result = bitmap_;
@@ -95,6 +127,10 @@ public:
     bitmap_.append(other.bitmap_);
   }
 
+  void drop(size_type n) {
+    bitmap_ = vast::drop(bitmap_, n);
+  }
+
   size_type size() const {
     return bitmap_.size();
   }
@@ -133,6 +169,13 @@ public:
     append(other, false);
   }
 
+  void drop(size_type n) {
+    // Bitmaps shorter than the coder obtain their missing bits on append.
+    for (auto& bm : bitmaps_)
+      bm = vast::drop(bm, n);
+    size_ -= std::min(n, size_);
+  }
+
   auto size() const {
     return size_;
   }
@@ -181,6 +224,36 @@ public:
     this->size_ += skip + n;
   }
 
+  void encode(detail::span<const value_type> xs, size_type skip = 0) {
+    using block_type = typename Bitmap::block_type;
+    using word_type = typename Bitmap::word_type;
+    auto size = static_cast<size_type>(xs.size());
+    VAST_ASSERT(Bitmap::max_size - this->size_ >= size + skip);
+    this->size_ += skip;
+    // One block per value, with bit j set if row j of the chunk has the value.
+    std::vector<block_type> blocks(this->bitmaps_.size());
+    for (size_type i = 0; i < size; i += word_type::width) {
+      auto n = std::min<size_type>(size - i, word_type::width);
+      for (size_type j = 0; j < n; ++j) {
+        VAST_ASSERT(xs[i + j] < this->bitmaps_.size());
+        blocks[xs[i + j]] |= block_type{1} << j;
+      }
+      // Only bitmaps with a 1 in this chunk change. We append their block up
+      // to the last 1 so that the result equals bitwise encoding.
+      for (size_type j = 0; j < n; ++j) {
+        auto& block = blocks[xs[i + j]];
+        if (block == 0)
+          continue;
+        auto& bm = this->bitmaps_[xs[i + j]];
+        bm.append_bits(false, this->size_ - bm.size());
+        bm.append_block(block, word_type::width
+                                 - word_type::count_leading_zeros(block));
+        block = 0;
+      }
+      this->size_ += n;
+    }
+  }
+
   Bitmap decode(relational_operator op, value_type x) const {
     VAST_ASSERT(op == less || op == less_equal || op == equal || op == not_equal
                 || op == greater_equal || op == greater);
@@ -242,22 +315,52 @@ public:
     VAST_ASSERT(x < this->bitmaps_.size() + 1);
     // Lazy append: we only add 0s until we hit index i of value x. The
     // remaining bitmaps are always 1, by definition of the range coding
-    // property i >= x for all i in [0,N).
-    // TODO: This requires adapating RangeEval-Opt to perform "lazy extension"
-    // on complement, which is why it is still commented.
-    // for (auto i = 0u; i < x; ++i) {
-    //  auto& bm = this->bitmaps_[i];
-    //  bm.append_bits(true, this->size_ + skip - bm.size());
-    //  bm.append_bits(false, n);
-    // }
-    for (auto i = 0u; i < this->bitmaps_.size(); ++i) {
+    // property i >= x for all i in [0,N). Hence we do not touch them at all
+    // and let decoding treat the missing tail of a bitmap as 1s.
+    for (auto i = 0u; i < x; ++i) {
       auto& bm = this->bitmaps_[i];
       bm.append_bits(true, this->size_ + skip - bm.size());
-      bm.append_bits(i >= x, n);
+      bm.append_bits(false, n);
     }
     this->size_ += n + skip;
   }
 
+  void encode(detail::span<const value_type> xs, size_type skip = 0) {
+    using block_type = typename Bitmap::block_type;
+    using word_type = typename Bitmap::word_type;
+    auto size = static_cast<size_type>(xs.size());
+    VAST_ASSERT(Bitmap::max_size - this->size_ >= size + skip);
+    this->size_ += skip;
+    // One block per value, with bit j set if row j of the chunk has the value.
+    std::vector<block_type> blocks(this->bitmaps_.size());
+    for (size_type i = 0; i < size; i += word_type::width) {
+      auto n = std::min<size_type>(size - i, word_type::width);
+      value_type max = 0;
+      for (size_type j = 0; j < n; ++j) {
+        auto x = xs[i + j];
+        VAST_ASSERT(x < this->bitmaps_.size() + 1);
+        if (x < this->bitmaps_.size())
+          blocks[x] |= block_type{1} << j;
+        max = std::max(max, x);
+      }
+      // As with lazy bitwise encoding, only the bitmaps i < max change. Row j
+      // of bitmap i is 1 iff x_j <= i, i.e., the prefix union of the blocks.
+      block_type ones = 0;
+      for (value_type k = 0; k < max; ++k) {
+        ones |= blocks[k];
+        blocks[k] = 0;
+        auto zeros = ~ones & word_type::lsb_fill(n);
+        auto& bm = this->bitmaps_[k];
+        bm.append_bits(true, this->size_ - bm.size());
+        bm.append_block(ones, word_type::width
+                                - word_type::count_leading_zeros(zeros));
+      }
+      if (max < this->bitmaps_.size())
+        blocks[max] = 0;
+      this->size_ += n;
+    }
+  }
+
   Bitmap decode(relational_operator op, value_type x) const {
     VAST_ASSERT(op == less || op == less_equal || op == equal || op == not_equal
                 || op == greater_equal || op == greater);
@@ -265,43 +368,63 @@ public:
     switch (op) {
       default:
         return {this->size_, false};
-      case less: {
-        auto result = this->bitmaps_[x > 0 ? x - 1 : 0];
-        result.append_bits(true, this->size_ - result.size());
-        return result;
-      }
-      case less_equal: {
-        auto result = this->bitmaps_[x];
-        result.append_bits(true, this->size_ - result.size());
-        return result;
-      }
+      case less:
+        return bitmap_at(x > 0 ? x - 1 : 0);
+      case less_equal:
+        return bitmap_at(x);
       case equal:
       case not_equal: {
-        auto result = this->bitmaps_[x];
-        if (x > 0) {
-          auto prev = ~this->bitmaps_[x - 1];
-          VAST_ASSERT(prev.size() >= result.size());
-          result.append_bits(true, prev.size() - result.size());
-          result &= prev;
+        if (x == 0) {
+          auto result = bitmap_at(0);
+          if (op == not_equal)
+            result.flip();
+          return result;
         }
-        result.append_bits(false, this->size_ - result.size());
+        // Computing B[x] & ~B[x-1] in a single pass avoids materializing
+        // both operands and the complement as temporaries.
+        auto f = [](auto hi, auto lo) { return hi & ~lo; };
+        auto result = fused_eval<Bitmap>(this->size_, f, cursor_at(x),
+                                         cursor_at(x - 1));
         if (op == not_equal)
           result.flip();
         return result;
       }
       case greater: {
-        auto result = ~this->bitmaps_[x];
-        result.append_bits(false, this->size_ - result.size());
+        auto result = bitmap_at(x);
+        result.flip();
         return result;
       }
       case greater_equal: {
-        auto result = ~this->bitmaps_[x > 0 ? x - 1 : 0];
-        result.append_bits(false, this->size_ - result.size());
+        auto result = bitmap_at(x > 0 ? x - 1 : 0);
+        result.flip();
         return result;
       }
     }
   }
 
+  /// Retrieves the *i*-th bitmap, extended to the size of the coder. Since
+  /// ::encode extends bitmaps lazily, the missing tail consists of 1s.
+  /// @param i The index of the bitmap.
+  /// @returns The *i*-th bitmap or all 1s if *i* exceeds the number of bitmaps.
+  Bitmap bitmap_at(size_t i) const {
+    if (i >= this->bitmaps_.size())
+      return {this->size_, true};
+    auto result = this->bitmaps_[i];
+    result.append_bits(true, this->size_ - result.size());
+    return result;
+  }
+
+  /// Creates a cursor over the *i*-th bitmap that yields the lazily omitted
+  /// tail of 1s without materializing it.
+  /// @param i The index of the bitmap.
+  /// @returns A cursor over the *i*-th bitmap or over all 1s if *i* exceeds
+  ///          the number of bitmaps.
+  bit_cursor<Bitmap> cursor_at(size_t i) const {
+    static const Bitmap empty;
+    return bit_cursor<Bitmap>{i < this->bitmaps_.size() ? this->bitmaps_[i]
+                                                        : empty, true};
+  }
+
   void append(const range_coder& other) {
     vector_coder<Bitmap>::append(other, true);
   }
@@ -327,6 +450,27 @@ public:
     this->size_ += n + skip;
   }
 
+  void encode(detail::span<const value_type> xs, size_type skip = 0) {
+    using block_type = typename Bitmap::block_type;
+    using word_type = typename Bitmap::word_type;
+    auto size = static_cast<size_type>(xs.size());
+    VAST_ASSERT(Bitmap::max_size - this->size_ >= size + skip);
+    if (size == 0)
+      return;
+    for (auto& bm : this->bitmaps_)
+      bm.append_bits(false, this->size_ + skip - bm.size());
+    for (size_type i = 0; i < size; i += word_type::width) {
+      auto n = std::min<size_type>(size - i, word_type::width);
+      for (auto k = 0u; k < this->bitmaps_.size(); ++k) {
+        block_type block = 0;
+        for (size_type j = 0; j < n; ++j)
+          block |= block_type{((xs[i + j] >> k) & 1) == 0} << j;
+        this->bitmaps_[k].append_block(block, n);
+      }
+    }
+    this->size_ += size + skip;
+  }
+
   // RangeEval-Opt for the special case with uniform base 2.
   Bitmap decode(relational_operator op, value_type x) const {
     switch (op) {
@@ -435,16 +579,75 @@ public:
       coders_[i].encode(xs_[i], n, skip);
   }
 
+  void encode(detail::span<const value_type> xs, size_type skip = 0) {
+    if (xs.empty())
+      return;
+    if (xs_.empty())
+      init();
+    // Decompose one component at a time: the quotients carry the remaining
+    // higher-order components over to the next coder.
+    std::vector<value_type> quotients(xs.begin(), xs.end());
+    std::vector<value_type> components(quotients.size());
+    for (auto i = 0u; i < base_.size(); ++i) {
+      for (auto j = 0u; j < quotients.size(); ++j) {
+        components[j] = quotients[j] % base_[i];
+        quotients[j] /= base_[i];
+      }
+      coders_[i].encode(components, skip);
+    }
+  }
+
+  /// Encodes a sequence of values like the single-threaded version, but
+  /// splits it into contiguous chunks that separate threads encode into coders
+  /// of their own. Appending the chunks in order yields the same bitmaps.
+  /// @param xs The values to encode.
+  /// @param skip The number of entries to skip before encoding *xs*.
+  /// @param threads The number of threads to use, including the caller.
+  void encode(detail::span<const value_type> xs, size_type skip,
+              size_t threads) {
+    using word_type = typename bitmap_type::word_type;
+    auto size = static_cast<size_t>(xs.size());
+    auto chunk = size / std::max(threads, size_t{1});
+    chunk -= chunk % word_type::width; // Whole blocks only.
+    if (threads <= 1 || chunk == 0) {
+      encode(xs, skip);
+      return;
+    }
+    std::vector<multi_level_coder> chunks(threads - 1,
+                                          multi_level_coder{base_});
+    std::vector<std::thread> workers;
+    workers.reserve(chunks.size());
+    for (auto i = 0u; i < chunks.size(); ++i) {
+      auto first = (i + 1) * chunk;
+      auto n = i + 1 == chunks.size() ? size - first : chunk;
+      workers.emplace_back([&, i, first, n] {
+        chunks[i].encode(xs.subspan(first, n));
+      });
+    }
+    encode(xs.first(chunk), skip);
+    for (auto& worker : workers)
+      worker.join();
+    for (auto& x : chunks)
+      append(x);
+  }
+
   auto decode(relational_operator op, value_type x) const {
     return coders_.empty() ? bitmap_type{} : decode(coders_, op, x);
   }
 
   void append(const multi_level_coder& other) {
+    if (xs_.empty())
+      init();
     VAST_ASSERT(coders_.size() == other.coders_.size());
     for (auto i = 0u; i < coders_.size(); ++i)
       coders_[i].append(other.coders_[i]);
   }
 
+  void drop(size_type n) {
+    for (auto& x : coders_)
+      x.drop(n);
+  }
+
   size_type size() const {
     return coders_.empty() ? 0 : coders_[0].size();
   }
@@ -514,7 +717,7 @@ private:
     }
     base_.decompose(x, xs_);
     bitmap_type result{size(), true};
-    auto bitmaps = [&](auto i) -> auto& { return coders[i].storage(); };
+    auto bitmap = [&](auto i, auto j) { return coders[i].bitmap_at(j); };
     switch (op) {
       default:
         return bitmap_type{size(), false};
@@ -523,23 +726,23 @@ private:
       case greater:
       case greater_equal: {
         if (xs_[0] < base_[0] - 1) // && bitmap != all_ones
-          result = bitmaps(0)[xs_[0]];
+          result = bitmap(0, xs_[0]);
         for (auto i = 1u; i < base_.size(); ++i) {
           if (xs_[i] != base_[i] - 1) // && bitmap != all_ones
-            result &= bitmaps(i)[xs_[i]];
+            result &= bitmap(i, xs_[i]);
           if (xs_[i] != 0) // && bitmap != all_ones
-            result |= bitmaps(i)[xs_[i] - 1];
+            result |= bitmap(i, xs_[i] - 1);
         }
       } break;
       case equal:
       case not_equal: {
         for (auto i = 0u; i < base_.size(); ++i) {
           if (xs_[i] == 0) // && bitmap != all_ones
-            result &= bitmaps(i)[0];
+            result &= bitmap(i, 0);
           else if (xs_[i] == base_[i] - 1)
-            result &= ~bitmaps(i)[base_[i] - 2];
+            result &= ~bitmap(i, base_[i] - 2);
           else
-            result &= bitmaps(i)[xs_[i]] ^ bitmaps(i)[xs_[i] - 1];
+            result &= bitmap(i, xs_[i]) ^ bitmap(i, xs_[i] - 1);
         }
       } break;
     }
@@ -16,6 +16,7 @@
 #include <chrono>
 #include <ctime>
 #include <cstring>
+#include <iterator>
 
 #include <date/date.h>
 
@@ -128,10 +129,34 @@ struct ymdhms_parser : vast::parser<ymdhms_parser> {
         >> ~('-' >> day >> ~('+' >> hour >> ~(':' >> min >> ~(':' >> sec))));
   }
 
+  // Parses the fractional seconds that the timestamp printer appends to a
+  // complete timestamp. All components have a fixed width, so a complete
+  // timestamp has the length of YYYY-MM-DD+HH:MM:SS.
+  template <class Iterator>
+  static timespan parse_fraction(const Iterator& begin, Iterator& f,
+                                 const Iterator& l) {
+    if (std::distance(begin, f) != 19 || f == l || *f != '.'
+        || std::next(f) == l || *std::next(f) < '0' || *std::next(f) > '9')
+      return timespan{0};
+    ++f;
+    auto ns = timespan::rep{0};
+    auto digits = 0;
+    for (; f != l && *f >= '0' && *f <= '9'; ++f, ++digits)
+      if (digits < 9)
+        ns = ns * 10 + (*f - '0');
+    for (; digits < 9; ++digits)
+      ns *= 10;
+    return timespan{ns};
+  }
+
   template <class Iterator>
   bool parse(Iterator& f, const Iterator& l, unused_type) const {
     static auto p = make();
-    return p(f, l, unused);
+    auto begin = f;
+    if (!p(f, l, unused))
+      return false;
+    parse_fraction(begin, f, l);
+    return true;
   }
 
   template <class Iterator>
@@ -149,10 +174,12 @@ struct ymdhms_parser : vast::parser<ymdhms_parser> {
     auto hms = std::tie(hrs, ms);
     auto dhms = std::tie(dys, hms);
     static auto p = make();
+    auto begin = f;
     if (!p(f, l, yrs, mons, dhms))
       return false;
     sys_days ymd = year{yrs} / mons / dys;
-    auto delta = hours{hrs} + minutes{mins} + seconds{secs};
+    auto delta = hours{hrs} + minutes{mins} + seconds{secs}
+                 + parse_fraction(begin, f, l);
     tp = timestamp{ymd} + delta;
     return true;
   }
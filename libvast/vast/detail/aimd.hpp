@@ -0,0 +1,109 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "vast/time.hpp"
+
+#include "vast/detail/assert.hpp"
+
+namespace vast::detail {
+
+/// An additive-increase/multiplicative-decrease (AIMD) controller. It grows a
+/// value linearly while observed latencies stay within a target, and shrinks
+/// it geometrically as soon as a latency exceeds the target.
+///
+/// Since several measurements may be in flight when the controller backs off,
+/// each decrease starts a new *epoch*. Observations from earlier epochs can no
+/// longer decrease the value, which limits the back-off to one step per round
+/// trip.
+class aimd {
+public:
+  /// Constructs an AIMD controller.
+  /// @param initial The initial value.
+  /// @param min The smallest value.
+  /// @param max The largest value.
+  /// @param target The latency to stay within.
+  /// @param increase The amount to add for each latency within *target*.
+  /// @param decrease The factor to multiply with when exceeding *target*.
+  /// @pre `0 < min && min <= initial && initial <= max`
+  /// @pre `0 < decrease && decrease < 1`
+  aimd(uint64_t initial, uint64_t min, uint64_t max, timespan target,
+       uint64_t increase, double decrease = 0.5)
+    : value_{initial},
+      min_{min},
+      max_{max},
+      target_{target},
+      increase_{increase},
+      decrease_{decrease} {
+    VAST_ASSERT(0 < min_ && min_ <= value_ && value_ <= max_);
+    VAST_ASSERT(0 < decrease_ && decrease_ < 1);
+  }
+
+  /// Adjusts the value according to an observed latency.
+  /// @param latency The observed latency.
+  /// @param epoch The epoch at the time the measurement started.
+  /// @returns `true` iff the value changed.
+  bool observe(timespan latency, uint64_t epoch) {
+    auto old = value_;
+    if (latency <= target_) {
+      value_ = std::min(max_, value_ + increase_);
+    } else if (epoch == epoch_) {
+      auto x = static_cast<uint64_t>(value_ * decrease_);
+      value_ = std::max(min_, x);
+      ++epoch_;
+    }
+    return value_ != old;
+  }
+
+  /// @returns The current value.
+  uint64_t value() const {
+    return value_;
+  }
+
+  /// Sets the current value.
+  /// @param x The new value, which gets clamped to the valid range.
+  void value(uint64_t x) {
+    value_ = std::clamp(x, min_, max_);
+  }
+
+  /// @returns The current epoch.
+  uint64_t epoch() const {
+    return epoch_;
+  }
+
+  /// @returns The target latency.
+  timespan target() const {
+    return target_;
+  }
+
+  /// Sets the target latency.
+  /// @param x The new target latency.
+  void target(timespan x) {
+    target_ = x;
+  }
+
+private:
+  uint64_t value_;
+  uint64_t min_;
+  uint64_t max_;
+  timespan target_;
+  uint64_t increase_;
+  double decrease_;
+  uint64_t epoch_ = 0;
+};
+
+} // namespace vast::detail
@@ -13,34 +13,52 @@
 
 #pragma once
 
-#include <cstdint>
+#include <cstddef>
 #include <istream>
-#include <string>
+#include <string_view>
+#include <vector>
 
 #include "vast/detail/range.hpp"
 
 namespace vast::detail {
 
-// A range of non-empty lines, extracted via `std::getline`.
+/// A range of non-empty lines. Instead of copying each line into a string, the
+/// range reads large blocks from the stream buffer of the input and yields
+/// views into them.
 class line_range : range_facade<line_range> {
 public:
-  line_range(std::istream& input);
+  /// The initial size of the block buffer, which doubles for longer lines.
+  static constexpr size_t default_block_size = 1 << 20;
 
-  const std::string& get() const;
+  /// Constructs a line range from an input stream.
+  /// @param input The stream to read from.
+  /// @param block_size The number of bytes to read at most at once.
+  explicit line_range(std::istream& input,
+                      size_t block_size = default_block_size);
+
+  /// @returns The current line, which remains valid until the next call to
+  ///          ::next.
+  std::string_view get() const;
 
   void next();
 
   bool done() const;
 
-  std::string& line();
-
   size_t line_number() const;
 
 private:
+  /// Moves the incomplete line at the end of the block to the front and reads
+  /// more data after it.
+  /// @returns `false` iff the input is exhausted.
+  bool fill();
+
   std::istream& input_;
-  std::string line_;
+  std::vector<char> buffer_;
+  size_t pos_ = 0; // beginning of the unconsumed data
+  size_t end_ = 0; // end of the data in the buffer
+  bool eof_ = false;
+  std::string_view line_;
   size_t line_number_ = 0;
 };
 
 } // namespace vast::detail
-
@@ -0,0 +1,45 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vast::detail {
+
+/// The instruction set extensions for the bitwise block kernels.
+enum class simd_level { none, sse2, avx2 };
+
+/// Retrieves the instruction set extension used by the block kernels. The
+/// choice happens once at runtime based on the capabilities of the CPU.
+simd_level active_simd_level();
+
+/// Computes `out[i] = x[i] & y[i]` for all *i* in *[0, n)*.
+/// @pre *out* is either equal to *x* or does not overlap with *x* and *y*.
+void block_and(const uint64_t* x, const uint64_t* y, uint64_t* out, size_t n);
+
+/// Computes `out[i] = x[i] | y[i]` for all *i* in *[0, n)*.
+/// @pre *out* is either equal to *x* or does not overlap with *x* and *y*.
+void block_or(const uint64_t* x, const uint64_t* y, uint64_t* out, size_t n);
+
+/// Computes `out[i] = x[i] ^ y[i]` for all *i* in *[0, n)*.
+/// @pre *out* is either equal to *x* or does not overlap with *x* and *y*.
+void block_xor(const uint64_t* x, const uint64_t* y, uint64_t* out, size_t n);
+
+/// Computes `out[i] = x[i] & ~y[i]` for all *i* in *[0, n)*.
+/// @pre *out* is either equal to *x* or does not overlap with *x* and *y*.
+void block_and_not(const uint64_t* x, const uint64_t* y, uint64_t* out,
+                   size_t n);
+
+} // namespace vast::detail
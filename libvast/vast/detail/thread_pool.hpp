@@ -0,0 +1,76 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace vast::detail {
+
+/// A fixed set of threads that execute jobs in the order of submission. The
+/// threads live as long as the pool, so that submitting a job costs a queue
+/// operation rather than the creation of a thread.
+class thread_pool {
+public:
+  /// Spawns the threads of the pool.
+  /// @param threads The number of threads.
+  explicit thread_pool(size_t threads);
+
+  /// Waits for all submitted jobs to complete and joins the threads.
+  ~thread_pool();
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  /// Schedules a job for execution on one of the threads.
+  /// @param f The function object to execute.
+  /// @returns A future for the result of *f*.
+  template <class F>
+  auto submit(F f) {
+    using result_type = std::invoke_result_t<F>;
+    // A std::function requires a copyable target, but a packaged task is
+    // move-only.
+    auto task = std::make_shared<std::packaged_task<result_type()>>(
+      std::move(f));
+    auto result = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      jobs_.emplace_back([task] { (*task)(); });
+    }
+    cond_.notify_one();
+    return result;
+  }
+
+  /// @returns The number of threads in the pool.
+  size_t size() const;
+
+private:
+  void run();
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::function<void()>> jobs_;
+  bool done_ = false;
+  std::vector<std::thread> threads_;
+};
+
+} // namespace vast::detail
@@ -112,6 +112,11 @@ public:
 
   void append_block(block_type bits, size_type n = word_type::width);
 
+  /// Appends a sequence of full blocks.
+  /// @param first A pointer to the first block.
+  /// @param last A pointer one past the last block.
+  void append_blocks(const block_type* first, const block_type* last);
+
   void flip();
 
   // -- concepts -------------------------------------------------------------
@@ -138,6 +143,107 @@ private:
   size_type num_bits_ = 0;
 };
 
+// -- bitwise operations -------------------------------------------------------
+//
+// These overloads take precedence over the generic algorithms from
+// bitmap_algorithms.hpp. Instead of iterating over bit sequences, they walk
+// both bitmaps in runs of clean and dirty words and hand runs of dirty words
+// to the SIMD block kernels.
+
+/// @relates ewah_bitmap
+ewah_bitmap binary_and(const ewah_bitmap& lhs, const ewah_bitmap& rhs);
+
+/// @relates ewah_bitmap
+ewah_bitmap binary_or(const ewah_bitmap& lhs, const ewah_bitmap& rhs);
+
+/// @relates ewah_bitmap
+ewah_bitmap binary_xor(const ewah_bitmap& lhs, const ewah_bitmap& rhs);
+
+/// @relates ewah_bitmap
+ewah_bitmap binary_nand(const ewah_bitmap& lhs, const ewah_bitmap& rhs);
+
+/// Walks over an EWAH bitmap in runs of full words, each of which is either
+/// clean or dirty. The last block counts as a dirty word whose unused bits
+/// hold the padding bit. Beyond the end of the bitmap, the cursor yields an
+/// infinite clean run of padding bits. In addition to the generic cursor
+/// interface, this specialization exposes the runs of words such that
+/// algorithms can process many words at once.
+template <>
+class bit_cursor<ewah_bitmap> {
+public:
+  using word_type = ewah_bitmap::word_type;
+  using block_type = ewah_bitmap::block_type;
+  using size_type = ewah_bitmap::size_type;
+
+  explicit bit_cursor(const ewah_bitmap& bm, bool pad = false);
+
+  // -- generic interface -----------------------------------------------------
+
+  bool fill() const {
+    return clean();
+  }
+
+  block_type block() const {
+    return clean() ? fill_ : *dirty() >> offset_;
+  }
+
+  size_type length() const {
+    auto n = words();
+    if (n > std::numeric_limits<size_type>::max() / word_type::width)
+      return std::numeric_limits<size_type>::max();
+    return (clean() ? n : 1) * word_type::width - offset_;
+  }
+
+  void advance(size_type n) {
+    offset_ += n;
+    auto k = offset_ / word_type::width;
+    offset_ %= word_type::width;
+    if (k > 0)
+      skip(k);
+  }
+
+  // -- run interface ---------------------------------------------------------
+
+  /// @returns `true` iff the current run consists of clean words.
+  bool clean() const {
+    return clean_ > 0;
+  }
+
+  /// @returns The number of remaining words in the current run.
+  size_type words() const {
+    return clean() ? clean_ : dirty_;
+  }
+
+  /// @returns A pointer to the current dirty word.
+  /// @pre `!clean()`
+  const block_type* dirty() const {
+    return next_ + 1 < blocks_->size() ? blocks_->data() + next_ : &last_;
+  }
+
+  /// @returns The *i*-th word of the current run.
+  /// @pre `i < words()`
+  block_type word(size_type i) const {
+    return clean() ? fill_ : dirty()[i];
+  }
+
+  /// Advances the cursor by full words.
+  /// @param n The number of words to skip.
+  /// @pre The cursor is at a word boundary.
+  void skip(size_type n);
+
+private:
+  void load();
+
+  const ewah_bitmap::block_vector* blocks_;
+  size_type next_ = 0;
+  size_type clean_ = 0;
+  size_type dirty_ = 0;
+  size_type offset_ = 0;
+  block_type fill_ = word_type::none;
+  block_type pad_;
+  block_type last_;
+};
+
 class ewah_bitmap_range
   : public bit_range_base<ewah_bitmap_range, ewah_bitmap::block_type> {
 public:
@@ -21,6 +21,7 @@
 
 #include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "vast/expected.hpp"
@@ -323,6 +324,15 @@ expected<void> mkdir(const path& p);
 // @returns The contents of the file *p*.
 expected<std::string> load_contents(const path& p);
 
+/// Atomically replaces the contents of a file and flushes them to stable
+/// storage. The function writes to a temporary file, synchronizes it, and
+/// then renames it to *p*, so that *p* always holds either the old or the new
+/// contents.
+/// @param p The path of the file to write.
+/// @param contents The new contents of *p*.
+/// @returns An error if writing, synchronizing, or renaming failed.
+expected<void> write_contents(const path& p, std::string_view contents);
+
 } // namespace vast
 
 namespace std {
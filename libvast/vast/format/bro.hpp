@@ -14,8 +14,13 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -25,16 +30,15 @@
 #include "vast/concept/parseable/vast/address.hpp"
 #include "vast/concept/parseable/vast/subnet.hpp"
 #include "vast/data.hpp"
+#include "vast/event.hpp"
 #include "vast/expected.hpp"
 #include "vast/filesystem.hpp"
 #include "vast/schema.hpp"
 
 #include "vast/detail/line_range.hpp"
+#include "vast/detail/thread_pool.hpp"
 
 namespace vast {
-
-class event;
-
 namespace format {
 namespace bro {
 
@@ -145,6 +149,10 @@ struct bro_parser_factory {
     return parsers::u64 ->* [](count x) { return x; };
   }
 
+  result_type operator()(const real_type&) const {
+    return parsers::real ->* [](real x) { return x; };
+  }
+
   result_type operator()(const timestamp_type&) const {
     return parsers::real ->* [](real x) {
       auto i = std::chrono::duration_cast<timespan>(double_seconds(x));
@@ -222,6 +230,46 @@ bool bro_basic_parse(const type& t, Iterator& f, const Iterator& l,
   return visit(bro_parser<Iterator, Attribute>{f, l, attr}, t);
 }
 
+/// Parses a single Bro log field. The most common field types have
+/// hand-written decoders that avoid type erasure and temporary strings. Other
+/// types, and inputs these decoders do not accept in full, go through the
+/// combinator parser from ::make_bro_parser.
+class field_parser {
+public:
+  using iterator_type = std::string_view::const_iterator;
+
+  field_parser() = default;
+
+  /// Constructs a field parser.
+  /// @param t The type of the field.
+  /// @param set_separator The separator of container elements.
+  field_parser(const type& t, const std::string& set_separator);
+
+  /// Parses a field.
+  /// @param f The beginning of the field.
+  /// @param l The end of the field.
+  /// @param x The parsed value.
+  /// @returns `true` on success.
+  bool operator()(iterator_type& f, const iterator_type& l, data& x) const;
+
+private:
+  enum class kind : uint8_t {
+    other,
+    boolean,
+    integer,
+    count,
+    real,
+    timestamp,
+    timespan,
+    string,
+    address,
+    port
+  };
+
+  kind kind_ = kind::other;
+  rule<iterator_type, data> fallback_;
+};
+
 /// A Bro reader.
 class reader {
 public:
@@ -229,7 +277,13 @@ public:
 
   /// Constructs a Bro reader.
   /// @param input The stream of logs to read.
-  explicit reader(std::unique_ptr<std::istream> input);
+  /// @param parse_threads The number of threads that parse log lines. With
+  ///                      more than one, the reader splits the input into
+  ///                      chunks of lines that a pool of threads parses
+  ///                      concurrently, while the reader splits off the next
+  ///                      chunk.
+  explicit reader(std::unique_ptr<std::istream> input,
+                  size_t parse_threads = 1);
 
   expected<event> read();
 
@@ -242,8 +296,36 @@ public:
 private:
   using iterator_type = std::string_view::const_iterator;
 
+  /// The number of lines that a single thread parses at once.
+  static constexpr size_t lines_per_thread = 4096;
+
   expected<void> parse_header();
 
+  /// Parses a data line according to the current header.
+  expected<event> parse_line(std::string_view line, size_t line_number) const;
+
+  /// The data lines of a chunk, copied out of the line range.
+  struct chunk {
+    std::string buffer;
+    std::vector<size_t> offsets{0};
+    std::vector<size_t> line_numbers;
+  };
+
+  /// The parse jobs of a chunk, one per contiguous range of lines.
+  using pending_chunk = std::vector<std::future<std::vector<expected<event>>>>;
+
+  /// Returns the next event of the current chunk, parsing the next chunk if
+  /// necessary.
+  expected<event> read_parallel();
+
+  /// Makes the results of the oldest chunk in flight the current chunk, and
+  /// keeps the thread pool busy with the subsequent chunk.
+  expected<void> parse_chunk();
+
+  /// Reads the next chunk of data lines up to the end of the current log and
+  /// submits it to the thread pool.
+  expected<void> dispatch_chunk();
+
   std::unique_ptr<std::istream> input_;
   std::unique_ptr<detail::line_range> lines_;
   std::string separator_ = " ";
@@ -254,7 +336,15 @@ private:
   vast::schema schema_;
   type type_;
   record_type record_;
-  std::vector<rule<iterator_type, data>> parsers_;
+  std::vector<field_parser> parsers_;
+  size_t parse_threads_ = 1;
+  bool restart_ = false;
+  std::vector<expected<event>> chunk_;
+  size_t chunk_pos_ = 0;
+  std::deque<pending_chunk> pending_;
+  // The parse jobs refer to the members above, so the pool must finish them
+  // before those go away. Hence it comes last.
+  std::unique_ptr<detail::thread_pool> pool_;
 };
 
 /// A Bro writer.
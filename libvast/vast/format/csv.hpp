@@ -13,12 +13,33 @@
 
 #pragma once
 
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include "vast/config.hpp"
 
+#include "vast/concept/parseable/core.hpp"
+#include "vast/concept/parseable/numeric.hpp"
+#include "vast/concept/parseable/string/any.hpp"
+#include "vast/concept/parseable/vast/address.hpp"
+#include "vast/concept/parseable/vast/port.hpp"
+#include "vast/concept/parseable/vast/subnet.hpp"
+#include "vast/concept/parseable/vast/time.hpp"
 #include "vast/concept/printable/core.hpp"
 #include "vast/concept/printable/numeric.hpp"
 #include "vast/concept/printable/string.hpp"
 #include "vast/concept/printable/vast/data.hpp"
+#include "vast/data.hpp"
+#include "vast/event.hpp"
+#include "vast/expected.hpp"
+#include "vast/pattern.hpp"
+#include "vast/schema.hpp"
+#include "vast/type.hpp"
+
+#include "vast/detail/line_range.hpp"
 #include "vast/detail/string.hpp"
 
 #include "vast/format/writer.hpp"
@@ -150,5 +171,155 @@ public:
   }
 };
 
+/// Constructs a polymorphic parser for the unquoted text of a CSV field.
+template <class Iterator, class Attribute>
+struct csv_parser_factory {
+  using result_type = rule<Iterator, Attribute>;
+
+  csv_parser_factory(const std::string& set_separator)
+    : set_separator_{set_separator} {
+  }
+
+  template <class T>
+  result_type operator()(const T&) const {
+    return {};
+  }
+
+  result_type operator()(const boolean_type&) const {
+    return parsers::boolean | parsers::tf;
+  }
+
+  result_type operator()(const integer_type&) const {
+    return parsers::i64 ->* [](integer x) { return x; };
+  }
+
+  result_type operator()(const count_type&) const {
+    return parsers::u64 ->* [](count x) { return x; };
+  }
+
+  result_type operator()(const real_type&) const {
+    return parsers::real_opt_dot ->* [](real x) { return x; };
+  }
+
+  result_type operator()(const timestamp_type&) const {
+    return parsers::timestamp | parsers::epoch;
+  }
+
+  result_type operator()(const timespan_type&) const {
+    return parsers::timespan ->* [](timespan x) { return x; };
+  }
+
+  result_type operator()(const string_type&) const {
+    if (set_separator_.empty())
+      return +parsers::any ->* [](std::string x) { return x; };
+    else
+      return +(parsers::any - set_separator_)
+        ->* [](std::string x) { return x; };
+  }
+
+  result_type operator()(const pattern_type&) const {
+    if (set_separator_.empty())
+      return +parsers::any ->* [](std::string x) { return pattern{x}; };
+    else
+      return +(parsers::any - set_separator_)
+        ->* [](std::string x) { return pattern{x}; };
+  }
+
+  result_type operator()(const address_type&) const {
+    return parsers::addr ->* [](address x) { return x; };
+  }
+
+  result_type operator()(const subnet_type&) const {
+    return parsers::net ->* [](subnet x) { return x; };
+  }
+
+  result_type operator()(const port_type&) const {
+    return parsers::port ->* [](port x) { return x; }
+      | parsers::u16 ->* [](uint16_t x) { return port{x, port::unknown}; };
+  }
+
+  result_type operator()(const set_type& t) const {
+    auto set_insert = [](std::vector<Attribute> v) {
+      set s;
+      for (auto& x : v)
+        s.insert(std::move(x));
+      return s;
+    };
+    return (visit(*this, t.value_type) % set_separator_) ->* set_insert;
+  }
+
+  result_type operator()(const vector_type& t) const {
+    return (visit(*this, t.value_type) % set_separator_)
+      ->* [](std::vector<Attribute> x) { return vector(std::move(x)); };
+  }
+
+  const std::string& set_separator_;
+};
+
+/// Constructs a parser for the fields of a CSV column.
+/// @param t The type of the column.
+template <class Iterator, class Attribute = data>
+rule<Iterator, Attribute> make_csv_parser(const type& t) {
+  static const auto sep = std::string{value_printer::set_separator};
+  static const auto none = std::string{};
+  auto& set_separator = is_container(t) ? sep : none;
+  return visit(csv_parser_factory<Iterator, Attribute>{set_separator}, t);
+}
+
+/// A CSV reader. The first line of the input is a header that names the
+/// columns. The reader maps the columns onto the flattened fields of the
+/// schema record type that has all column names with the fewest fields. It
+/// also understands the output of ::writer, whose leading `type`, `id` and
+/// `timestamp` columns carry event meta data and which repeats the header
+/// whenever the event type changes.
+class reader {
+public:
+  reader() = default;
+
+  /// Constructs a CSV reader.
+  /// @param input The stream of CSV lines to read.
+  /// @param block_size The initial size of the line buffer.
+  explicit reader(std::unique_ptr<std::istream> input,
+                  size_t block_size = detail::line_range::default_block_size);
+
+  expected<event> read();
+
+  expected<void> schema(const vast::schema& sch);
+
+  expected<vast::schema> schema() const;
+
+  const char* name() const;
+
+private:
+  using iterator_type = std::string_view::const_iterator;
+
+  /// A field of a line after removing the quotes.
+  struct field {
+    std::string_view text;
+    bool quoted;
+  };
+
+  /// Splits a line into fields. Fields without quotes, and quoted fields
+  /// without escaped quotes, point into the line; the others point into
+  /// *unescaped_*.
+  bool split(std::string_view line);
+
+  expected<void> parse_header(std::string_view line);
+
+  static constexpr size_t meta_column = -1;
+
+  std::unique_ptr<std::istream> input_;
+  std::unique_ptr<detail::line_range> lines_;
+  vast::schema schema_;
+  type type_;
+  record_type flat_;
+  std::vector<size_t> columns_;
+  std::vector<rule<iterator_type, data>> parsers_;
+  int timestamp_column_ = -1;
+  bool has_meta_columns_ = false;
+  std::vector<field> fields_;
+  std::string unescaped_;
+};
+
 } // namespace vast::format::csv
 
@@ -13,9 +13,23 @@
 
 #pragma once
 
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "vast/event.hpp"
+#include "vast/expected.hpp"
 #include "vast/json.hpp"
+#include "vast/schema.hpp"
+#include "vast/type.hpp"
 #include "vast/concept/printable/vast/json.hpp"
 
+#include "vast/detail/line_range.hpp"
+
 #include "vast/format/writer.hpp"
 
 namespace vast::format::json {
@@ -39,6 +53,72 @@ public:
   }
 };
 
+/// A JSON value that the reader has located in a line but not yet
+/// interpreted. Nested objects never appear as tokens, because the reader
+/// flattens them into dotted keys.
+struct token {
+  enum kind_type : uint8_t { null, boolean, number, string, array };
+
+  kind_type kind = null;
+
+  /// Whether a string contains escape sequences.
+  bool escaped = false;
+
+  /// The text of the value, excluding the quotes of a string.
+  std::string_view text;
+};
+
+/// A reader for newline-delimited JSON (NDJSON), i.e., one JSON object per
+/// line. The reader maps each object onto a record type of the schema whose
+/// flattened fields cover all keys of the object. If no such type exists, it
+/// infers a record type from the values. Both happen once per distinct
+/// sequence of keys; the reader caches the result for subsequent objects.
+class reader {
+public:
+  reader() = default;
+
+  /// Constructs a JSON reader.
+  /// @param input The stream of JSON objects to read.
+  /// @param block_size The initial size of the line buffer.
+  explicit reader(std::unique_ptr<std::istream> input,
+                  size_t block_size = detail::line_range::default_block_size);
+
+  expected<event> read();
+
+  expected<void> schema(const vast::schema& sch);
+
+  expected<vast::schema> schema() const;
+
+  const char* name() const;
+
+private:
+  /// The mapping of a sequence of keys onto a record type.
+  struct layout {
+    /// The type of the events.
+    type event_type;
+
+    /// The flattened fields of *event_type*.
+    record_type flat;
+
+    /// The index into the flattened fields for each key.
+    std::vector<size_t> fields;
+
+    /// The index of the flattened field holding the event timestamp.
+    int timestamp_field = -1;
+  };
+
+  /// Creates the layout of the keys of the current line.
+  layout make_layout() const;
+
+  std::unique_ptr<std::istream> input_;
+  std::unique_ptr<detail::line_range> lines_;
+  vast::schema schema_;
+  std::unordered_map<std::string, layout> layouts_;
+  std::string keys_;
+  std::string prefix_;
+  std::vector<token> values_;
+};
+
 } // namespace vast::format::json
 
 
@@ -0,0 +1,187 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "vast/bitmap_algorithms.hpp"
+#include "vast/bits.hpp"
+
+#include "vast/detail/assert.hpp"
+
+namespace vast {
+
+/// A sampling directory that accelerates *rank* and *select* on an immutable
+/// bitmap. Every *k* bit sequences of the bitmap, the directory records the
+/// position and the cumulative population count, together with a copy of the
+/// bit range at that point. A query performs a binary search over the samples
+/// and then resumes the scan at the closest sample, which bounds the work to
+/// O(log n + k) instead of O(n). The directory also caches the total
+/// population count and the positions of the last 0-bit and 1-bit.
+/// @warning The directory refers to the bitmap and becomes invalid once the
+///          bitmap changes or goes out of scope.
+/// @relates rank select
+template <class Bitmap>
+class rank_select_directory {
+public:
+  using bitmap_type = Bitmap;
+  using size_type = typename Bitmap::size_type;
+  using word_type = typename Bitmap::word_type;
+  using range_type = decltype(bit_range(std::declval<const Bitmap&>()));
+
+  /// The default number of bit sequences between two samples.
+  static constexpr size_t default_sampling_rate = 64;
+
+  /// Constructs a directory in a single pass over a bitmap.
+  /// @param bm The bitmap to build a directory for.
+  /// @param k The number of bit sequences between two samples.
+  /// @pre `k > 0`
+  explicit rank_select_directory(const Bitmap& bm,
+                                 size_t k = default_sampling_rate)
+    : bitmap_{&bm} {
+    VAST_ASSERT(k > 0);
+    // Member functions hide the free algorithms on bit sequences, hence the
+    // qualified calls throughout.
+    auto rng = bit_range(bm);
+    for (auto i = size_t{0}; !rng.done(); rng.next(), ++i) {
+      if (i % k == 0)
+        samples_.push_back({size_, ones_, rng});
+      auto& b = rng.get();
+      auto count = vast::rank<1>(b);
+      if (count > 0)
+        last_[1] = size_ + find_last<1>(b);
+      if (count < b.size())
+        last_[0] = size_ + find_last<0>(b);
+      ones_ += count;
+      size_ += b.size();
+    }
+  }
+
+  /// @returns The bitmap of this directory.
+  const Bitmap& bitmap() const {
+    return *bitmap_;
+  }
+
+  /// @returns The number of bits in the bitmap.
+  size_type size() const {
+    return size_;
+  }
+
+  /// Computes the population count of the entire bitmap in constant time.
+  /// @tparam Bit The bit value to count.
+  template <bool Bit = true>
+  size_type rank() const {
+    return Bit ? ones_ : size_ - ones_;
+  }
+
+  /// Computes the number of occurrences of a bit value in *B[0,i]*.
+  /// @tparam Bit The bit value to count.
+  /// @param i The offset where to end counting.
+  /// @pre `i < size()`
+  template <bool Bit = true>
+  size_type rank(size_type i) const {
+    VAST_ASSERT(i < size_);
+    auto pred = [](size_type x, const sample& s) { return x < s.position; };
+    auto s = std::upper_bound(samples_.begin(), samples_.end(), i, pred);
+    VAST_ASSERT(s != samples_.begin());
+    --s;
+    auto rng = s->range;
+    auto n = s->position;
+    auto result = Bit ? s->ones : n - s->ones;
+    for (; !rng.done(); rng.next()) {
+      auto& b = rng.get();
+      if (i < n + b.size())
+        return result + vast::rank<Bit>(b, i - n);
+      result += vast::rank<Bit>(b);
+      n += b.size();
+    }
+    return result;
+  }
+
+  /// Computes the position of the *i*-th occurrence of a bit.
+  /// @tparam Bit the bit value to locate.
+  /// @param i The position of the *i*-th occurrence of *Bit*. If `i == -1`,
+  ///          then select the last occurrence of *Bit* in constant time.
+  /// @returns The position of the *i*-th occurrence of *Bit* or `npos` if
+  ///          no such position exists.
+  /// @pre `i > 0`
+  template <bool Bit = true>
+  size_type select(size_type i) const {
+    VAST_ASSERT(i > 0);
+    if (i == word_type::npos)
+      return last_[Bit];
+    if (i > rank<Bit>())
+      return word_type::npos;
+    auto count = [](const sample& s) {
+      return Bit ? s.ones : s.position - s.ones;
+    };
+    auto pred = [&](const sample& s) { return count(s) < i; };
+    auto s = std::partition_point(samples_.begin(), samples_.end(), pred);
+    VAST_ASSERT(s != samples_.begin());
+    --s;
+    auto rng = s->range;
+    auto n = s->position;
+    auto rnk = count(*s);
+    for (; !rng.done(); rng.next()) {
+      auto& b = rng.get();
+      auto k = vast::rank<Bit>(b);
+      if (rnk + k >= i)
+        return n + vast::select<Bit>(b, i - rnk);
+      rnk += k;
+      n += b.size();
+    }
+    return word_type::npos;
+  }
+
+private:
+  struct sample {
+    size_type position; // the position of the first bit in the range
+    size_type ones;     // the number of 1-bits before the range
+    range_type range;   // the bit range, positioned at the sample
+  };
+
+  const Bitmap* bitmap_;
+  std::vector<sample> samples_;
+  size_type size_ = 0;
+  size_type ones_ = 0;
+  size_type last_[2] = {word_type::npos, word_type::npos};
+};
+
+/// Computes the *rank* of a bitmap with the help of a directory.
+/// @relates rank_select_directory
+template <bool Bit = true, class Bitmap>
+auto rank(const rank_select_directory<Bitmap>& dir,
+          typename Bitmap::size_type i) {
+  return dir.template rank<Bit>(i);
+}
+
+/// Computes the *rank* of a bitmap with the help of a directory.
+/// @relates rank_select_directory
+template <bool Bit = true, class Bitmap>
+auto rank(const rank_select_directory<Bitmap>& dir) {
+  return dir.template rank<Bit>();
+}
+
+/// Computes the position of the *i*-th occurrence of a bit with the help of a
+/// directory.
+/// @relates rank_select_directory
+template <bool Bit = true, class Bitmap>
+auto select(const rank_select_directory<Bitmap>& dir,
+            typename Bitmap::size_type i) {
+  return dir.template select<Bit>(i);
+}
+
+} // namespace vast
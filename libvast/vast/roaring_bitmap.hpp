@@ -0,0 +1,193 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vast/bitmap_base.hpp"
+#include "vast/word.hpp"
+
+#include "vast/detail/operators.hpp"
+
+namespace vast {
+
+class roaring_bitmap_range;
+
+/// A bitmap after the *Roaring* scheme by Chambi et al. The bit sequence is
+/// partitioned into chunks of 2^16 bits, each of which has a *key* that
+/// corresponds to the upper bits of the position. For every chunk with at
+/// least one 1-bit, the bitmap stores a *container* in one of three
+/// representations:
+///
+///   1. An *array* of sorted 16-bit positions for sparse chunks.
+///   2. A *bitset* of 2^16 bits for dense chunks.
+///   3. A sequence of *runs* of 1s for clustered chunks.
+///
+/// Each container uses the representation that requires the least amount of
+/// space. Unlike the run-length encoded bitmaps, Roaring supports random
+/// access in constant time and keeps sparse but clustered bit sets small.
+class roaring_bitmap : public bitmap_base<roaring_bitmap>,
+                       detail::equality_comparable<roaring_bitmap> {
+  friend roaring_bitmap_range;
+
+  friend roaring_bitmap binary_and(const roaring_bitmap& lhs,
+                                   const roaring_bitmap& rhs);
+
+  friend roaring_bitmap binary_or(const roaring_bitmap& lhs,
+                                  const roaring_bitmap& rhs);
+
+  friend roaring_bitmap binary_xor(const roaring_bitmap& lhs,
+                                   const roaring_bitmap& rhs);
+
+  friend roaring_bitmap binary_nand(const roaring_bitmap& lhs,
+                                    const roaring_bitmap& rhs);
+
+public:
+  using word_type = word<block_type>;
+
+  /// The number of bits in a chunk.
+  static constexpr size_type chunk_size = size_type{1} << 16;
+
+  /// The number of blocks that a bitset container holds.
+  static constexpr size_t chunk_blocks = chunk_size / word_type::width;
+
+  /// The maximum cardinality of an array container.
+  static constexpr size_t max_array_size = 4096;
+
+  /// The bits of a single chunk.
+  struct container {
+    enum kind_type : uint8_t { array, bitset, run };
+
+    /// The upper bits of the positions in this container.
+    uint64_t key;
+
+    /// The container representation.
+    uint8_t kind;
+
+    /// The number of 1-bits in the container.
+    uint32_t cardinality;
+
+    /// The sorted positions for an array container and the pairs of start
+    /// and length minus 1 for a run container.
+    std::vector<uint16_t> values;
+
+    /// The blocks of a bitset container.
+    std::vector<block_type> blocks;
+
+    friend bool operator==(const container& x, const container& y);
+
+    template <class Inspector>
+    friend auto inspect(Inspector& f, container& x) {
+      return f(x.key, x.kind, x.cardinality, x.values, x.blocks);
+    }
+  };
+
+  using container_vector = std::vector<container>;
+
+  roaring_bitmap() = default;
+
+  roaring_bitmap(size_type n, bool bit = false);
+
+  // -- inspectors -----------------------------------------------------------
+
+  bool empty() const;
+
+  size_type size() const;
+
+  const container_vector& containers() const;
+
+  /// Accesses a single bit in constant time.
+  /// @param i The bit position.
+  /// @returns The value of the *i*-th bit.
+  /// @pre `i < size()`
+  bool operator[](size_type i) const;
+
+  /// @returns The number of bytes that the containers occupy.
+  size_t memusage() const;
+
+  // -- modifiers ------------------------------------------------------------
+
+  void append_bit(bool bit);
+
+  void append_bits(bool bit, size_type n);
+
+  void append_block(block_type bits, size_type n = word_type::width);
+
+  void flip();
+
+  // -- concepts -------------------------------------------------------------
+
+  friend bool operator==(const roaring_bitmap& x, const roaring_bitmap& y);
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, roaring_bitmap& bm) {
+    return f(bm.containers_, bm.num_bits_);
+  }
+
+private:
+  roaring_bitmap(container_vector xs, size_type n);
+
+  // Sets the bits in [first, last) to 1, where *first* must not precede the
+  // last 1-bit.
+  void append_ones(size_type first, size_type last);
+
+  container_vector containers_;
+  size_type num_bits_ = 0;
+};
+
+// -- bitwise operations -------------------------------------------------------
+//
+// These overloads take precedence over the generic algorithms from
+// bitmap_algorithms.hpp and combine the bitmaps container by container.
+
+/// @relates roaring_bitmap
+roaring_bitmap binary_and(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+/// @relates roaring_bitmap
+roaring_bitmap binary_or(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+/// @relates roaring_bitmap
+roaring_bitmap binary_xor(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+/// @relates roaring_bitmap
+roaring_bitmap binary_nand(const roaring_bitmap& lhs,
+                           const roaring_bitmap& rhs);
+
+class roaring_bitmap_range
+  : public bit_range_base<roaring_bitmap_range, roaring_bitmap::block_type> {
+public:
+  using word_type = roaring_bitmap::word_type;
+
+  roaring_bitmap_range() = default;
+
+  explicit roaring_bitmap_range(const roaring_bitmap& bm);
+
+  void next();
+  bool done() const;
+
+private:
+  void scan();
+
+  const roaring_bitmap* bm_ = nullptr;
+  size_t container_ = 0; // the next container to consider
+  roaring_bitmap::size_type block_ = 0; // the next block to emit
+  roaring_bitmap::size_type num_blocks_ = 0;
+  std::vector<roaring_bitmap::block_type> buffer_; // the current container
+  bool done_ = true;
+};
+
+roaring_bitmap_range bit_range(const roaring_bitmap& bm);
+
+} // namespace vast
@@ -34,6 +34,7 @@ using caf::subscribe_atom;
 using accept_atom = caf::atom_constant<caf::atom("accept")>;
 using announce_atom = caf::atom_constant<caf::atom("announce")>;
 using batch_atom = caf::atom_constant<caf::atom("batch")>;
+using compact_atom = caf::atom_constant<caf::atom("compact")>;
 using continuous_atom = caf::atom_constant<caf::atom("continuous")>;
 using cpu_atom = caf::atom_constant<caf::atom("cpu")>;
 using data_atom = caf::atom_constant<caf::atom("data")>;
@@ -0,0 +1,79 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <caf/actor.hpp>
+#include <caf/error.hpp>
+#include <caf/typed_response_promise.hpp>
+
+#include "vast/data.hpp"
+
+#include "vast/system/atoms.hpp"
+
+namespace vast::system {
+
+/// Requests the statistics of several actors and combines them into a map
+/// from names to the statistics of each actor. Actors that fail to respond do
+/// not appear in the result.
+/// @param self The requesting actor.
+/// @param xs Pairs of names and the corresponding actors.
+/// @param f The function to invoke with the combined statistics.
+template <class Actor, class F>
+void collect_statistics(Actor* self,
+                        std::vector<std::pair<std::string, caf::actor>> xs,
+                        F f) {
+  if (xs.empty()) {
+    data result = map{};
+    f(result);
+    return;
+  }
+  auto result = std::make_shared<map>();
+  auto remaining = std::make_shared<size_t>(xs.size());
+  auto finish = [=]() mutable {
+    if (--*remaining == 0) {
+      data x = std::move(*result);
+      f(x);
+    }
+  };
+  for (auto& [name, a] : xs)
+    self->request(a, caf::infinite, statistics_atom::value).then(
+      [=, name = name](data& x) mutable {
+        result->emplace(name, std::move(x));
+        finish();
+      },
+      [=](caf::error&) mutable {
+        finish();
+      }
+    );
+}
+
+/// Requests the statistics of several actors and responds to the current
+/// request of *self* with the combined statistics.
+/// @param self The actor that handles the current request.
+/// @param xs Pairs of names and the corresponding actors.
+template <class Actor>
+void collect_statistics(Actor* self,
+                        std::vector<std::pair<std::string, caf::actor>> xs) {
+  auto rp = self->template make_response_promise<data>();
+  collect_statistics(self, std::move(xs), [=](data& x) mutable {
+    rp.deliver(std::move(x));
+  });
+}
+
+} // namespace vast::system
@@ -21,6 +21,7 @@
 #include "vast/aliases.hpp"
 #include "vast/ids.hpp"
 #include "vast/expression.hpp"
+#include "vast/expression_visitors.hpp"
 #include "vast/query_options.hpp"
 #include "vast/uuid.hpp"
 
@@ -37,7 +38,7 @@ struct exporter_state {
   accountant_type accountant;
   ids hits;
   ids unprocessed;
-  std::unordered_map<type, expression> checkers;
+  std::unordered_map<type, event_predicate> checkers;
   std::deque<event> candidates;
   std::vector<event> results;
   std::chrono::steady_clock::time_point start;
@@ -14,8 +14,11 @@
 #pragma once
 
 #include <chrono>
+#include <deque>
+#include <utility>
 #include <vector>
 
+#include <caf/response_promise.hpp>
 #include <caf/stateful_actor.hpp>
 
 #include "vast/aliases.hpp"
@@ -23,31 +26,48 @@
 #include "vast/event.hpp"
 #include "vast/filesystem.hpp"
 
+#include "vast/system/accountant.hpp"
 #include "vast/system/archive.hpp"
 #include "vast/system/meta_store.hpp"
 
 namespace vast::system {
 
+/// A contiguous range of IDs that an IMPORTER reserved from the meta store.
+struct id_lease {
+  id next = 0;
+  id available = 0;
+};
+
 /// Receives chunks from SOURCEs, imbues them with an ID, and relays them to
 /// ARCHIVE and INDEX.
 struct importer_state {
   meta_store_type meta_store;
   caf::actor archive;
   caf::actor index;
-  id next = 0;
-  id available = 0;
+  /// The lease that the IMPORTER currently draws IDs from.
+  id_lease current;
+  /// The lease that the IMPORTER switches to once the current one runs out.
+  /// The IMPORTER requests it in the background as soon as it has switched,
+  /// so that ID allocation stays off the critical path.
+  id_lease reserved;
+  /// Whether a lease request to the meta store is in flight.
+  bool leasing = false;
   size_t batch_size;
-  std::chrono::steady_clock::time_point last_replenish;
-  std::vector<event> remainder;
+  size_t min_batch_size;
+  uint64_t acknowledged = 0;
+  std::chrono::steady_clock::time_point last_lease;
+  /// Batches waiting for IDs, along with the promises to acknowledge them.
+  std::deque<std::pair<std::vector<event>, caf::response_promise>> remainder;
   std::vector<caf::actor> continuous_queries;
   path dir;
+  accountant_type accountant;
   static inline const char* name = "importer";
 };
 
 /// Spawns an IMPORTER.
 /// @param self The actor handle.
 /// @param dir The directory for persistent state.
-/// @param batch_size The initial number of IDs to request when replenishing.
+/// @param batch_size The initial and minimum number of IDs per lease.
 caf::behavior importer(caf::stateful_actor<importer_state>* self,
                        path dir, size_t batch_size);
 
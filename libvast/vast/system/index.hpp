@@ -14,10 +14,14 @@
 #pragma once
 
 #include <unordered_map>
+#include <vector>
 
 #include <caf/actor.hpp>
+#include <caf/actor_addr.hpp>
+#include <caf/response_promise.hpp>
 #include <caf/stateful_actor.hpp>
 
+#include "vast/aliases.hpp"
 #include "vast/expression.hpp"
 #include "vast/filesystem.hpp"
 #include "vast/uuid.hpp"
@@ -40,9 +44,17 @@ public:
     timestamp to = timestamp::min();
   };
 
+  /// A closed interval of event IDs.
+  struct id_interval {
+    id from = invalid_id;
+    id to = 0;
+  };
+
   /// Per-partition summary statistics.
   struct partition_synopsis {
     interval range;
+    id_interval ids;
+    uint64_t events = 0;
   };
 
   /// Adds a set of events to the index for a given partition.
@@ -51,14 +63,37 @@ public:
   /// Retrieves the list of partition IDs for a given expression.
   std::vector<uuid> lookup(const expression& expr) const;
 
+  /// Selects a run of partitions that are adjacent in time and fit together
+  /// into a single partition. Since value indexes can only grow at the end,
+  /// the ID ranges of the selected partitions must not overlap, which is not
+  /// the case for partitions that several importers filled concurrently.
+  /// @param max_events The maximum number of events of the merged partition.
+  /// @param excluded The partitions that must not take part in a merge.
+  /// @returns At least two partitions in chronological order, or an empty
+  ///          vector if no such run exists.
+  std::vector<uuid>
+  compaction_candidates(size_t max_events,
+                        const detail::flat_set<uuid>& excluded) const;
+
+  /// Replaces several partitions with a single one that holds all their
+  /// events.
+  /// @param xs The partitions to replace.
+  /// @param partition The partition that replaces *xs*.
+  void replace(const std::vector<uuid>& xs, const uuid& partition);
+
   template <class Inspector>
   friend auto inspect(Inspector& f, interval& i) {
     return f(i.from, i.to);
   }
 
+  template <class Inspector>
+  friend auto inspect(Inspector& f, id_interval& i) {
+    return f(i.from, i.to);
+  }
+
   template <class Inspector>
   friend auto inspect(Inspector& f, partition_synopsis& ps) {
-    return f(ps.range);
+    return f(ps.range, ps.ids, ps.events);
   }
 
   template <class Inspector>
@@ -87,19 +122,36 @@ struct lookup_state {
   std::vector<uuid> partitions;
 };
 
+struct compaction_state {
+  uuid id;
+  std::vector<uuid> partitions;
+  std::vector<caf::response_promise> requests;
+};
+
 struct index_state {
   partition_index part_index;
-  active_partition_state active;
+  /// The active partition of each importer. Every importer writes into its
+  /// own partition, because value indexes require increasing IDs and the ID
+  /// leases of several importers interleave. The index monitors importers
+  /// and retires their partition when they terminate.
+  std::unordered_map<caf::actor_addr, active_partition_state> active;
   std::unordered_map<uuid, caf::actor> loaded;
   std::unordered_map<caf::actor, uuid> evicted;
   std::deque<scheduled_partition_state> scheduled;
   std::unordered_map<uuid, lookup_state> lookups;
+  compaction_state compaction;
+  /// Whether the partition index changed since the index last persisted it.
+  bool dirty = false;
   size_t capacity;
   path dir;
   static inline const char* name = "index";
 };
 
-/// Indexes events in horizontal partitions.
+/// Indexes events in horizontal partitions, with one active partition per
+/// importer. In the background, the index merges runs of small partitions
+/// that are neither in memory nor scheduled into a single partition. Sending
+/// `compact_atom` triggers a compaction explicitly and yields the number of
+/// merged partitions once it completes.
 /// @param dir The directory of the index.
 /// @param max_events The maximum number of events per partition.
 /// @param max_parts The maximum number of partitions to hold in memory.
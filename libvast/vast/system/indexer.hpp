@@ -14,10 +14,12 @@
 #pragma once
 
 #include <unordered_map>
+#include <vector>
 
 #include <caf/actor.hpp>
 #include <caf/stateful_actor.hpp>
 
+#include "vast/expected.hpp"
 #include "vast/filesystem.hpp"
 #include "vast/type.hpp"
 
@@ -37,5 +39,15 @@ struct event_indexer_state {
 caf::behavior event_indexer(caf::stateful_actor<event_indexer_state>* self,
                             path dir, type event_type);
 
+/// Merges the persistent state of several event indexers for the same event
+/// type into a new one. The indexers must cover disjoint ranges of IDs.
+/// @param dir The directory of the new event indexer.
+/// @param dirs The directories of the event indexers to merge.
+/// @param event_type The type of the indexed events.
+/// @returns An error if loading, merging, or saving an index failed.
+expected<void> merge_event_indexers(const path& dir,
+                                    const std::vector<path>& dirs,
+                                    const type& event_type);
+
 } // namespace vast::system
 
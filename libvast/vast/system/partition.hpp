@@ -14,11 +14,13 @@
 #pragma once
 
 #include <unordered_map>
+#include <vector>
 
 #include <caf/actor.hpp>
 #include <caf/stateful_actor.hpp>
 
 #include "vast/aliases.hpp"
+#include "vast/expected.hpp"
 #include "vast/filesystem.hpp"
 #include "vast/type.hpp"
 
@@ -50,5 +52,12 @@ struct partition_state {
 /// @param dir The directory where to store this partition on the file system.
 caf::behavior partition(caf::stateful_actor<partition_state>* self, path dir);
 
+/// Merges the persistent state of several partitions into a new partition.
+/// The partitions must cover disjoint ranges of IDs.
+/// @param dir The directory of the new partition.
+/// @param parts The directories of the partitions to merge.
+/// @returns An error if reading or writing the persistent state failed.
+expected<void> merge_partitions(const path& dir, const std::vector<path>& parts);
+
 } // namespace vast::system
 
@@ -16,6 +16,7 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <type_traits>
 
 #include <caf/scoped_actor.hpp>
 #include <caf/typed_actor.hpp>
@@ -50,9 +51,16 @@ public:
     add_opt("read,r", "path to input where to read events from", "-");
     add_opt("schema,s", "path to alternate schema", "");
     add_opt("uds,d", "treat -r as listening UNIX domain socket", false);
+    if constexpr (parallel)
+      add_opt("parse-threads", "number of threads parsing the input",
+              size_t{1});
   }
 
 protected:
+  /// Whether the reader can parse its input on multiple threads.
+  static constexpr bool parallel =
+    std::is_constructible_v<Reader, std::unique_ptr<std::istream>, size_t>;
+
   expected<caf::actor> make_source(caf::scoped_actor& self,
                                    const option_map& options,
                                    argument_iterator begin,
@@ -65,8 +73,16 @@ protected:
     auto in = detail::make_input_stream(*input, *uds);
     if (!in)
       return in.error();
-    Reader reader{std::move(*in)};
-    auto src = self->spawn(source<Reader>, std::move(reader));
+    auto make_reader = [&] {
+      if constexpr (parallel) {
+        auto threads = get<size_t>(options, "parse-threads");
+        VAST_ASSERT(threads);
+        return Reader{std::move(*in), *threads};
+      } else {
+        return Reader{std::move(*in)};
+      }
+    };
+    auto src = self->spawn(source<Reader>, make_reader());
     // Supply an alternate schema, if requested.
     auto schema_file = get<std::string>(options, "schema");
     VAST_ASSERT(schema_file);
@@ -0,0 +1,72 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <caf/actor.hpp>
+#include <caf/error.hpp>
+#include <caf/message.hpp>
+#include <caf/response_promise.hpp>
+
+#include "vast/system/atoms.hpp"
+
+namespace vast::system {
+
+/// Sends a message to several actors and invokes a function after all of them
+/// have acknowledged it with `ok_atom`. Actors that fail to respond count as
+/// having acknowledged the message, so that a single failure cannot stall the
+/// sender forever.
+/// @param self The sending actor.
+/// @param xs The receivers of *msg*.
+/// @param msg The message to relay.
+/// @param f The function to invoke after the last acknowledgement.
+template <class Actor, class F>
+void relay(Actor* self, std::vector<caf::actor> xs, const caf::message& msg,
+           F f) {
+  if (xs.empty()) {
+    f();
+    return;
+  }
+  auto remaining = std::make_shared<size_t>(xs.size());
+  auto finish = [=]() mutable {
+    if (--*remaining == 0)
+      f();
+  };
+  for (auto& x : xs)
+    self->request(x, caf::infinite, msg).then(
+      [=](ok_atom) mutable {
+        finish();
+      },
+      [=](caf::error&) mutable {
+        finish();
+      }
+    );
+}
+
+/// Sends a message to several actors and acknowledges the current request of
+/// *self* after all of them have acknowledged the message.
+/// @param self The actor that handles the current request.
+/// @param xs The receivers of *msg*.
+/// @param msg The message to relay.
+template <class Actor>
+void relay(Actor* self, std::vector<caf::actor> xs, const caf::message& msg) {
+  auto rp = self->make_response_promise();
+  relay(self, std::move(xs), msg, [=]() mutable {
+    rp.deliver(ok_atom::value);
+  });
+}
+
+} // namespace vast::system
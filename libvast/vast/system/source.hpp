@@ -24,6 +24,7 @@
 #include "vast/concept/printable/std/chrono.hpp"
 #include "vast/concept/printable/vast/error.hpp"
 #include "vast/concept/printable/vast/expression.hpp"
+#include "vast/detail/aimd.hpp"
 #include "vast/detail/assert.hpp"
 #include "vast/error.hpp"
 #include "vast/event.hpp"
@@ -31,6 +32,7 @@
 #include "vast/expression.hpp"
 #include "vast/expression_visitors.hpp"
 #include "vast/schema.hpp"
+#include "vast/time.hpp"
 
 #include "vast/system/accountant.hpp"
 #include "vast/system/atoms.hpp"
@@ -56,11 +58,22 @@ struct Reader {
 /// @tparam Reader The reader type, which must model the *Reader* concept.
 template <class Reader>
 struct source_state {
+  static constexpr size_t min_batch_size = 1 << 10;
   static constexpr size_t max_batch_size = 1 << 20;
+  /// The number of batches that may be in flight without acknowledgement.
+  static constexpr size_t max_credit = 4;
   uint64_t batch_size = 65536;
+  /// Adapts the batch size to the time the sink takes to acknowledge a batch,
+  /// unless the batch size has been set explicitly.
+  detail::aimd batch_controller{batch_size, min_batch_size, max_batch_size,
+                                std::chrono::seconds{1}, 4096};
+  bool adaptive = true;
+  size_t credit = max_credit;
+  bool waiting = false;
+  bool done = false;
   std::vector<event> events;
   expression filter;
-  std::unordered_map<type, expression> checkers;
+  std::unordered_map<type, event_predicate> checkers;
   std::chrono::steady_clock::time_point start;
   accountant_type accountant;
   caf::actor sink;
@@ -68,6 +81,26 @@ struct source_state {
   const char* name = "source";
 };
 
+/// Feeds the time it took the sink to acknowledge a batch into the batch size
+/// controller.
+/// @param self The source actor.
+/// @param latency The time between shipping a batch and its acknowledgement.
+/// @param epoch The controller epoch at the time of shipping the batch.
+template <class Reader>
+void adapt(caf::stateful_actor<source_state<Reader>>* self, timespan latency,
+           uint64_t epoch) {
+  auto& st = self->state;
+  if (st.accountant)
+    self->send(st.accountant, "source.batch.latency", latency);
+  if (!st.adaptive || !st.batch_controller.observe(latency, epoch))
+    return;
+  VAST_DEBUG(self, "adjusts batch size after", latency << ':',
+             st.batch_size, "->", st.batch_controller.value());
+  st.batch_size = st.batch_controller.value();
+  if (st.accountant)
+    self->send(st.accountant, "source.batch.size", st.batch_size);
+}
+
 /// An event producer.
 /// @tparam Reader The concrete source implementation.
 /// @param self The actor handle.
@@ -100,6 +133,12 @@ source(caf::stateful_actor<source_state<Reader>>* self, Reader&& reader) {
         timestamp now = system_clock::now();
         self->send(self->state.accountant, "source.start", now);
       }
+      // Do not produce more events than the sink has granted credit for.
+      if (self->state.credit == 0) {
+        VAST_DEBUG(self, "waits for sink to acknowledge a batch");
+        self->state.waiting = true;
+        return;
+      }
       // Extract events until the source has exhausted its input or until we
       // have completed a batch.
       auto start = steady_clock::now();
@@ -109,12 +148,12 @@ source(caf::stateful_actor<source_state<Reader>>* self, Reader&& reader) {
         if (e) {
           if (!caf::holds_alternative<none>(self->state.filter)) {
             auto& checker = self->state.checkers[e->type()];
-            if (caf::holds_alternative<none>(checker)) {
+            if (!checker) {
               auto x = tailor(self->state.filter, e->type());
               VAST_ASSERT(x);
-              checker = std::move(*x);
+              checker = caf::visit(expression_compiler{e->type()}, *x);
             }
-            if (!caf::visit(event_evaluator{*e}, checker))
+            if (!checker(*e))
               continue;
           }
           self->state.events.push_back(std::move(*e));
@@ -148,33 +187,64 @@ source(caf::stateful_actor<source_state<Reader>>* self, Reader&& reader) {
           self->send(self->state.accountant, "source.batch.events", events);
           self->send(self->state.accountant, "source.batch.rate", rate);
         }
-        self->send(self->state.sink, std::move(self->state.events));
+        // Each batch in flight consumes one credit, which the sink returns
+        // by acknowledging the batch. This bounds the number of events
+        // between source and sink, no matter how fast the reader is.
+        --self->state.credit;
+        auto sent = steady_clock::now();
+        auto epoch = self->state.batch_controller.epoch();
+        auto replenish = [=] {
+          ++self->state.credit;
+          if (self->state.done) {
+            if (self->state.credit == source_state<Reader>::max_credit)
+              self->send_exit(self, exit_reason::normal);
+          } else if (self->state.waiting) {
+            self->state.waiting = false;
+            self->send(self, run_atom::value);
+          }
+        };
+        self->request(self->state.sink, infinite,
+                      std::move(self->state.events)).then(
+          [=](ok_atom) {
+            auto latency = duration_cast<timespan>(steady_clock::now() - sent);
+            adapt(self, latency, epoch);
+            replenish();
+          },
+          [=](const error& e) {
+            VAST_ERROR(self, "failed to ship batch:",
+                       self->system().render(e));
+            replenish();
+          }
+        );
         self->state.events = {};
         self->state.events.reserve(self->state.batch_size);
-        // FIXME: if we do not give the stdlib implementation a hint to yield
-        // here, this actor can monopolize all available resources. In
-        // particular, we encountered a scenario where it prevented the BASP
-        // broker from a getting a chance to operate, thereby queuing up
-        // all event batches locally and running out of memory, as opposed to
-        // sending them out as soon as possible. This yield fix temporarily
-        // works around a deeper issue in CAF, which needs to be addressed in
-        // the future.
-        std::this_thread::yield();
       }
-      if (done)
-        self->send_exit(self, exit_reason::normal);
-      else
+      if (!done) {
         self->send(self, run_atom::value);
+        return;
+      }
+      // Terminate once the sink has acknowledged all batches.
+      self->state.done = true;
+      if (self->state.credit == source_state<Reader>::max_credit)
+        self->send_exit(self, exit_reason::normal);
     },
     [=](batch_atom, uint64_t batch_size) {
       if (batch_size > source_state<Reader>::max_batch_size) {
         VAST_WARNING(self, "ignores too large batch size:", batch_size);
         return;
       }
-      VAST_DEBUG(self, "sets batch size to", batch_size);
+      VAST_DEBUG(self, "sets fixed batch size to", batch_size);
       self->state.batch_size = batch_size;
+      self->state.adaptive = false;
       self->state.events.reserve(batch_size);
     },
+    [=](batch_atom, timespan target) {
+      VAST_DEBUG(self, "adapts batch size to target latency", target);
+      self->state.batch_controller.target(target);
+      self->state.batch_controller.value(self->state.batch_size);
+      self->state.batch_size = self->state.batch_controller.value();
+      self->state.adaptive = true;
+    },
     [=](get_atom, schema_atom) -> result<schema> {
       auto sch = self->state.reader.schema();
       if (sch)
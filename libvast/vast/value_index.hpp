@@ -15,7 +15,9 @@
 
 #include <algorithm>
 #include <memory>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 #include "vast/ewah_bitmap.hpp"
 #include "vast/ids.hpp"
@@ -27,13 +29,18 @@
 #include "vast/error.hpp"
 #include "vast/expected.hpp"
 #include "vast/type.hpp"
+#include "vast/value_statistics.hpp"
 
 #include "vast/detail/assert.hpp"
 #include "vast/detail/overload.hpp"
+#include "vast/detail/span.hpp"
 
 namespace vast {
 
 /// An index for a ::value that supports appending and looking up values.
+/// The index only represents the range of IDs from its first value onwards:
+/// internally, all bitmaps begin at a base ID, and lookups translate their
+/// results back into the global ID space.
 /// @warning A lookup result does *not include* `nil` values, regardless of the
 /// relational operator. Include them requires performing an OR of the result
 /// and an explit query for nil, e.g., `x != 42 || x == nil`.
@@ -43,6 +50,10 @@ public:
 
   using size_type = typename ids::size_type;
 
+  /// The number of elements per container that container indexes consider
+  /// unless the type carries a `max_size` attribute.
+  static constexpr size_t default_max_size = 1024;
+
   /// Constructs a value index from a given type.
   /// @param t The type to construct a value index for.
   static std::unique_ptr<value_index> make(const type& t);
@@ -58,6 +69,14 @@ public:
   /// @returns `true` if appending succeeded.
   expected<void> push_back(const data& x, id pos);
 
+  /// Appends a sequence of data values with consecutive IDs. This has the
+  /// same effect as calling ::push_back for each value, but concrete indexes
+  /// can encode the entire sequence at once.
+  /// @param xs The data to append to the index.
+  /// @param first The positional identifier of the first value in *xs*.
+  /// @returns `true` if appending succeeded.
+  expected<void> append(detail::span<const data> xs, id first);
+
   /// Looks up data under a relational operator. If the value to look up is
   /// `nil`, only `==` and `!=` are valid operations. The concrete index
   /// type determines validity of other values.
@@ -66,10 +85,30 @@ public:
   /// @returns The result of the lookup or an error upon failure.
   expected<ids> lookup(relational_operator op, const data& x) const;
 
-  /// Merges another value index with this one.
-  /// @param other The value index to merge.
+  /// Estimates the result size of a lookup without performing it. The
+  /// estimate relies on statistics that the index maintains while appending
+  /// values, such as the number of distinct values.
+  /// @param op The relation operator.
+  /// @param x The value to lookup.
+  /// @returns The estimated number of IDs in the result of `lookup(op, x)` or
+  ///          an error if the index cannot estimate the lookup.
+  expected<size_type> estimate(relational_operator op, const data& x) const;
+
+  /// @returns The approximate number of distinct non-nil values.
+  size_type distinct() const;
+
+  /// Summarizes the statistics of the index for display.
+  /// @returns A map from statistic names to their values.
+  data statistics() const;
+
+  /// Merges another value index of the same type into this one, as if all
+  /// values of *other* had been appended to this index.
+  /// @param other The value index to merge, whose first ID must not precede
+  ///              the end of this index after shifting it. Only its rounded
+  ///              base may overlap with this index.
+  /// @param shift The number of IDs to shift the IDs of *other* by.
   /// @returns `true` on success.
-  //bool merge(const value_index& other);
+  expected<void> merge(const value_index& other, id shift = 0);
 
   /// Retrieves the ID of the last ::push_back operation.
   /// @returns The largest ID in the index.
@@ -77,66 +116,72 @@ public:
 
   template <class Inspector>
   friend auto inspect(Inspector& f, value_index& vi) {
-    return f(vi.mask_, vi.none_);
+    return f(vi.base_, vi.mask_, vi.none_, vi.nils_, vi.distinct_);
   }
 
 protected:
   value_index() = default;
 
+  /// @returns The number of non-nil values in the index.
+  size_type values() const;
+
+  /// Looks up the elements of a container with `in` or `not_in`, i.e.,
+  /// performs a disjunction of equality lookups.
+  /// @param op The relation operator.
+  /// @param x The container to lookup.
+  /// @returns The result of the lookup relative to the base ID.
+  expected<ids> container_lookup(relational_operator op, const data& x) const;
+
+  /// Estimates the fraction of non-nil values that satisfy a lookup. The
+  /// default implementation assumes uniformly distributed values.
+  /// @param op The relation operator.
+  /// @param x The value to lookup, which is not `nil`.
+  /// @returns The estimated selectivity in *[0, 1]*.
+  virtual expected<double>
+  estimate_impl(relational_operator op, const data& x) const;
+
+  /// Adds index-specific statistics to a summary.
+  /// @param xs The summary of ::statistics.
+  virtual void statistics_impl(map& xs) const;
+
+  /// Appends a sequence of data values. The default implementation invokes
+  /// ::push_back_impl for each non-nil value.
+  /// @param xs The data to append, which may include `nil` values.
+  /// @param skip The number of entries to skip before the first value.
+  /// @returns `true` if appending succeeded.
+  virtual bool append_impl(detail::span<const data> xs, size_type skip);
+
 private:
+  /// Sets the base ID of an empty index to the word boundary at or before the
+  /// first ID, so that translating results only prepends whole words.
+  void init_base(id first);
+
+  /// Looks up data like ::lookup, but relative to the base ID.
+  expected<ids> lookup_local(relational_operator op, const data& x) const;
+
+  /// Translates a bitmap from local positions into global IDs.
+  ids translate(ids local) const;
+
   virtual bool push_back_impl(const data& x, size_type skip) = 0;
 
   virtual expected<ids>
   lookup_impl(relational_operator op, const data& x) const = 0;
 
+  /// Merges the type-specific state of another index that holds at least one
+  /// non-nil value. Implementations must nonetheless cope with an *other*
+  /// whose concrete structures were never initialized.
+  /// @param other The index to merge, which has the same dynamic type.
+  /// @param pos The position relative to the base ID where *other* begins.
+  /// @returns `true` if merging succeeded.
+  virtual bool merge_impl(const value_index& other, size_type pos) = 0;
+
   size_type nils_ = 0;
+  id base_ = 0;
   ewah_bitmap mask_;
   ewah_bitmap none_;
+  hyperloglog distinct_;
 };
 
-namespace detail {
-
-template <class Index>
-expected<ids> container_lookup(const Index& idx, relational_operator op,
-                               const data& d) {
-  auto lookup = [&](auto& xs) -> expected<ids> {
-    ids result;
-    if (op == in) {
-      result = bitmap{idx.offset(), false};
-      for (auto& x : xs) {
-        auto r = idx.lookup(equal, x);
-        if (r)
-          result |= *r;
-        else
-          return r;
-        if (all<1>(result)) // short-circuit
-          return result;
-      }
-    } else if (op == not_in) {
-      result = bitmap{idx.offset(), true};
-      for (auto& x : xs) {
-        auto r = idx.lookup(equal, x);
-        if (r)
-          result -= *r;
-        else
-          return r;
-        if (all<0>(result)) // short-circuit
-          return result;
-      }
-    } else {
-      return make_error(ec::unsupported_operator, op);
-    }
-    return result;
-  };
-  return visit(overload(
-    [&](const auto& x) -> expected<ids> { return make_error(ec::type_clash, x); },
-    [&](const vector& xs) { return lookup(xs); },
-    [&](const set& xs) { return lookup(xs); }
-  ), d);
-}
-
-} // namespace detail
-
 /// An index for arithmetic values.
 template <class T, class Binner = void>
 class arithmetic_index : public value_index {
@@ -192,13 +237,34 @@ public:
 
   template <class Inspector>
   friend auto inspect(Inspector& f, arithmetic_index& idx) {
-    return f(static_cast<value_index&>(idx), idx.bmi_);
+    return f(static_cast<value_index&>(idx), idx.bmi_, idx.histogram_);
   }
 
 private:
+  using histogram_type =
+    equi_depth_histogram<
+      std::conditional_t<std::is_same<T, boolean>{}, uint8_t, value_type>
+    >;
+
+  /// The number of histogram buckets in the statistics summary.
+  static constexpr size_t histogram_buckets = 8;
+
+  /// The number of values per thread from which on appending a run of values
+  /// encodes chunks of it concurrently. Smaller runs do not amortize the cost
+  /// of spawning threads, and value indexers already run in parallel.
+  static constexpr size_t values_per_thread = 1 << 16;
+
+  /// Appends a run of non-nil values to the bitmap index.
+  void append_run(const std::vector<value_type>& run, size_type skip) {
+    auto threads = std::min<size_t>(run.size() / values_per_thread,
+                                    std::thread::hardware_concurrency());
+    bmi_.append(run, skip, std::max(threads, size_t{1}));
+  }
+
   bool push_back_impl(const data& d, size_type skip) override {
     auto append = [&](auto x) {
       bmi_.push_back(x, skip);
+      histogram_.add(x);
       return true;
     };
     return visit(detail::overload(
@@ -212,6 +278,47 @@ private:
     ), d);
   }
 
+  bool append_impl(detail::span<const data> xs, size_type skip) override {
+    if constexpr (std::is_same<T, boolean>{}) {
+      // Boolean values have no contiguous representation.
+      return value_index::append_impl(xs, skip);
+    } else {
+      // Collect runs of non-nil values and hand them to the bitmap index.
+      std::vector<value_type> run;
+      run.reserve(xs.size());
+      auto append = [&](auto x) {
+        run.push_back(x);
+        histogram_.add(x);
+        return true;
+      };
+      for (auto& x : xs) {
+        if (is<none>(x)) {
+          if (!run.empty()) {
+            append_run(run, skip);
+            run.clear();
+            skip = 0;
+          }
+          ++skip;
+          continue;
+        }
+        auto ok = visit(detail::overload(
+          [&](auto&&) { return false; },
+          [&](boolean x) { return append(x); },
+          [&](integer x) { return append(x); },
+          [&](count x) { return append(x); },
+          [&](real x) { return append(x); },
+          [&](timespan x) { return append(x.count()); },
+          [&](timestamp x) { return append(x.time_since_epoch().count()); }
+        ), x);
+        if (!ok)
+          return false;
+      }
+      if (!run.empty())
+        append_run(run, skip);
+      return true;
+    }
+  }
+
   expected<ids>
   lookup_impl(relational_operator op, const data& d) const override {
     return visit(detail::overload(
@@ -226,12 +333,153 @@ private:
       [&](timestamp x) -> expected<ids> {
         return bmi_.lookup(op, x.time_since_epoch().count());
       },
-      [&](const vector& xs) { return detail::container_lookup(*this, op, xs); },
-      [&](const set& xs) { return detail::container_lookup(*this, op, xs); }
+      [&](const vector& xs) { return container_lookup(op, xs); },
+      [&](const set& xs) { return container_lookup(op, xs); }
     ), d);
   };
 
+  bool merge_impl(const value_index& other, size_type pos) override {
+    auto& x = static_cast<const arithmetic_index&>(other);
+    bmi_.append_at(x.bmi_, pos);
+    histogram_.merge(x.histogram_);
+    return true;
+  }
+
+  expected<double>
+  estimate_impl(relational_operator op, const data& d) const override {
+    auto estimate = [&](auto x) -> expected<double> {
+      auto result = histogram_.selectivity(op, x);
+      if (result < 0)
+        return make_error(ec::unsupported_operator, op);
+      // The sample may miss infrequent values entirely, in which case we
+      // assume a uniform distribution for them.
+      auto uniform = 1.0 / std::max(size_type{1}, distinct());
+      if (op == equal)
+        return std::max(result, uniform);
+      if (op == not_equal)
+        return std::min(result, 1.0 - uniform);
+      return result;
+    };
+    return visit(detail::overload(
+      [&](const auto& x) -> expected<double> {
+        return make_error(ec::type_clash, value_type{}, x);
+      },
+      [&](boolean x) { return estimate(x); },
+      [&](integer x) { return estimate(x); },
+      [&](count x) { return estimate(x); },
+      [&](real x) { return estimate(x); },
+      [&](timespan x) { return estimate(x.count()); },
+      [&](timestamp x) { return estimate(x.time_since_epoch().count()); },
+      [&](const vector&) { return value_index::estimate_impl(op, d); },
+      [&](const set&) { return value_index::estimate_impl(op, d); }
+    ), d);
+  }
+
+  void statistics_impl(map& xs) const override {
+    vector bounds;
+    for (auto x : histogram_.boundaries(histogram_buckets)) {
+      if constexpr (std::is_same<T, timestamp>{})
+        bounds.emplace_back(timestamp{timespan{x}});
+      else if constexpr (std::is_same<T, timespan>{})
+        bounds.emplace_back(timespan{x});
+      else if constexpr (std::is_same<T, boolean>{})
+        bounds.emplace_back(x != 0);
+      else
+        bounds.emplace_back(x);
+    }
+    xs.emplace("histogram", std::move(bounds));
+  }
+
   bitmap_index_type bmi_;
+  histogram_type histogram_;
+};
+
+/// An index for timestamps that arrive in nearly ascending order, such as the
+/// timestamps of events. For the values in ascending order, a sparse table
+/// maps each distinct timestamp to the position of its first occurrence, and
+/// the few values that break the order go into a separate list. A range
+/// lookup then boils down to a binary search over the table. If too many
+/// values arrive out of order, the index falls back to range coding.
+class time_index : public value_index {
+public:
+  using value_type = timespan::rep;
+  using binner_type = decimal_binner<9>; // nanoseconds -> seconds
+
+  /// The minimum number of out-of-order values for falling back to range
+  /// coding.
+  static constexpr size_t min_outliers = 1024;
+
+  /// The fraction of out-of-order values beyond which the index falls back to
+  /// range coding.
+  static constexpr double max_disorder = 0.1;
+
+  time_index() = default;
+
+  /// @returns `true` if the index has fallen back to range coding.
+  bool disordered() const;
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, time_index& idx) {
+    return f(static_cast<value_index&>(idx), idx.size_, idx.values_,
+             idx.runs_, idx.sorted_, idx.outliers_, idx.disordered_,
+             idx.fallback_);
+  }
+
+private:
+  /// The positions of ascending values with the same (binned) timestamp,
+  /// beginning at a given position.
+  struct run {
+    value_type key;
+    size_type first;
+
+    template <class Inspector>
+    friend auto inspect(Inspector& f, run& x) {
+      return f(x.key, x.first);
+    }
+  };
+
+  /// A value that breaks the ascending order.
+  struct outlier {
+    size_type position;
+    value_type key;
+
+    template <class Inspector>
+    friend auto inspect(Inspector& f, outlier& x) {
+      return f(x.position, x.key);
+    }
+  };
+
+  using fallback_index =
+    bitmap_index<value_type, multi_level_coder<range_coder<ids>>>;
+
+  bool push_back_impl(const data& x, size_type skip) override;
+
+  expected<ids>
+  lookup_impl(relational_operator op, const data& x) const override;
+
+  bool merge_impl(const value_index& other, size_type pos) override;
+
+  /// Appends a binned timestamp.
+  void append_key(value_type key, size_type skip);
+
+  /// Looks up a binned timestamp.
+  ids lookup_key(relational_operator op, value_type key) const;
+
+  /// Moves all values into the range-coded index.
+  void fall_back();
+
+  /// Invokes a function with the position and binned timestamp of each value
+  /// in ascending order of positions.
+  template <class F>
+  void each(F f) const;
+
+  size_type size_ = 0;
+  size_type values_ = 0;
+  std::vector<run> runs_;
+  ewah_bitmap sorted_; // 1 iff a position holds a value of the table
+  std::vector<outlier> outliers_;
+  bool disordered_ = false;
+  fallback_index fallback_{base::uniform<64>(10)};
 };
 
 /// An index for strings.
@@ -244,7 +492,8 @@ public:
 
   template <class Inspector>
   friend auto inspect(Inspector& f, string_index& idx) {
-    return f(static_cast<value_index&>(idx), idx.length_, idx.chars_);
+    return f(static_cast<value_index&>(idx), idx.length_, idx.chars_,
+             idx.top_);
   }
 
 private:
@@ -262,9 +511,17 @@ private:
   expected<ids>
   lookup_impl(relational_operator op, const data& x) const override;
 
+  bool merge_impl(const value_index& other, size_type pos) override;
+
+  expected<double>
+  estimate_impl(relational_operator op, const data& x) const override;
+
+  void statistics_impl(map& xs) const override;
+
   size_t max_length_;
   length_bitmap_index length_;
   std::vector<char_bitmap_index> chars_;
+  top_k<std::string> top_;
 };
 
 /// An index for IP addresses.
@@ -288,6 +545,8 @@ private:
   expected<ids>
   lookup_impl(relational_operator op, const data& x) const override;
 
+  bool merge_impl(const value_index& other, size_type pos) override;
+
   std::array<byte_index, 16> bytes_;
   type_index v4_;
 };
@@ -312,6 +571,8 @@ private:
   expected<ids>
   lookup_impl(relational_operator op, const data& x) const override;
 
+  bool merge_impl(const value_index& other, size_type pos) override;
+
   address_index network_;
   prefix_index length_;
 };
@@ -346,22 +607,93 @@ private:
   expected<ids>
   lookup_impl(relational_operator op, const data& x) const override;
 
+  bool merge_impl(const value_index& other, size_type pos) override;
+
   number_index num_;
   protocol_index proto_;
 };
 
-/// An index for vectors and sets.
+/// An index for enumerations, equality-coded on the ordinal value.
+class enumeration_index : public value_index {
+public:
+  using index_type = bitmap_index<enumeration, equality_coder<ewah_bitmap>>;
+
+  /// Constructs an enumeration index.
+  /// @param t The enumeration type whose fields determine the domain.
+  explicit enumeration_index(enumeration_type t = {});
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, enumeration_index& idx) {
+    return f(static_cast<value_index&>(idx), idx.type_, idx.index_);
+  }
+
+private:
+  void init();
+
+  bool push_back_impl(const data& x, size_type skip) override;
+
+  expected<ids>
+  lookup_impl(relational_operator op, const data& x) const override;
+
+  bool merge_impl(const value_index& other, size_type pos) override;
+
+  enumeration_type type_;
+  index_type index_;
+};
+
+namespace detail {
+
+/// Maps the positions of a flattened stream of container elements back to
+/// the rows of the containers they originate from.
+class container_row_map {
+public:
+  using size_type = ids::size_type;
+
+  /// Registers a container.
+  /// @param n The number of elements in the container.
+  /// @param skip The number of rows to skip before the container.
+  void push_back(size_type n, size_type skip = 0);
+
+  /// Appends the containers of another row map such that its first row
+  /// becomes row *pos* of this one.
+  /// @param other The row map to append.
+  /// @param pos The position of the first row of *other*.
+  /// @pre The rows of *other* that overlap with this map hold no containers.
+  void append_at(const container_row_map& other, size_type pos);
+
+  /// Projects a set of element positions onto the rows of their containers.
+  /// @param hits The element positions to project.
+  /// @returns The IDs of all rows with at least one element in *hits*.
+  ids project(const ids& hits) const;
+
+  /// @returns The number of rows.
+  size_type size() const;
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, container_row_map& x) {
+    return f(x.size_, x.starts_, x.rows_);
+  }
+
+private:
+  size_type size_ = 0;
+  ewah_bitmap starts_; // 1 iff an element is the first of its container
+  ewah_bitmap rows_;   // 1 iff a row holds at least one element
+};
+
+} // namespace detail
+
+/// An index for vectors and sets. The index concatenates all container
+/// elements into a single stream, indexes this stream with one element
+/// index, and projects hits back onto the containers via a row map. A
+/// membership lookup therefore costs one element lookup plus one projection,
+/// independent of the container size.
 class sequence_index : public value_index {
 public:
   /// Constructs a sequence index of a given type.
   /// @param t The element type of the sequence.
   /// @param max_size The maximum number of elements permitted per sequence.
   ///                 Longer sequences will be trimmed at the end.
-  sequence_index(vast::type t = {}, size_t max_size = 128);
-
-  /// The bitmap index holding the sequence size.
-  using size_bitmap_index =
-    bitmap_index<uint32_t, multi_level_coder<range_coder<ids>>>;
+  sequence_index(vast::type t = {}, size_t max_size = default_max_size);
 
   friend void serialize(caf::serializer& sink, const sequence_index& idx);
   friend void serialize(caf::deserializer& source, sequence_index& idx);
@@ -372,22 +704,14 @@ private:
   template <class Container>
   bool push_back_ctnr(Container& c, size_type skip) {
     init();
-    auto seq_size = c.size();
-    if (seq_size > max_size_)
-      seq_size = max_size_;
-    if (seq_size > elements_.size()) {
-      auto old = elements_.size();
-      elements_.resize(seq_size);
-      for (auto i = old; i < elements_.size(); ++i) {
-        elements_[i] = value_index::make(value_type_);
-        VAST_ASSERT(elements_[i]);
-      }
-    }
-    auto id = size_.size() + skip;
+    auto seq_size = std::min(c.size(), max_size_);
     auto x = c.begin();
-    for (auto i = 0u; i < seq_size; ++i)
-      elements_[i]->push_back(*x++, id);
-    size_.push_back(seq_size, skip);
+    // An element that the element index rejects becomes nil, so that the
+    // row map stays in sync with the element stream.
+    for (auto i = 0u; i < seq_size; ++i, ++x)
+      if (!elements_->push_back(*x))
+        elements_->push_back(nil);
+    rows_.push_back(seq_size, skip);
     return true;
   }
 
@@ -396,14 +720,64 @@ private:
   expected<ids>
   lookup_impl(relational_operator op, const data& x) const override;
 
-  std::vector<std::unique_ptr<value_index>> elements_;
-  size_bitmap_index size_;
+  bool merge_impl(const value_index& other, size_type pos) override;
+
+  std::unique_ptr<value_index> elements_;
+  detail::container_row_map rows_;
+  size_t max_size_;
+  vast::type value_type_;
+};
+
+/// An index for associative arrays. Keys and values reside in two indexes
+/// over the flattened stream of map entries, such that the *i*-th key and the
+/// *i*-th value belong to the same entry and can be joined by position.
+class map_index : public value_index {
+public:
+  /// Constructs a map index of a given key and value type.
+  /// @param key_type The key type of the map.
+  /// @param value_type The value type of the map.
+  /// @param max_size The maximum number of entries permitted per map. Larger
+  ///                 maps will be trimmed at the end.
+  map_index(vast::type key_type = {}, vast::type value_type = {},
+            size_t max_size = default_max_size);
+
+  friend void serialize(caf::serializer& sink, const map_index& idx);
+  friend void serialize(caf::deserializer& source, map_index& idx);
+
+private:
+  void init();
+
+  bool push_back_impl(const data& x, size_type skip) override;
+
+  expected<ids>
+  lookup_impl(relational_operator op, const data& x) const override;
+
+  bool merge_impl(const value_index& other, size_type pos) override;
+
+  /// Computes the IDs of all maps that contain a given key.
+  expected<ids> lookup_key(const data& key) const;
+
+  /// Computes the IDs of all maps that contain a given key-value pair.
+  expected<ids> lookup_entry(const data& key, const data& value) const;
+
+  std::unique_ptr<value_index> keys_;
+  std::unique_ptr<value_index> values_;
+  detail::container_row_map rows_;
   size_t max_size_;
+  vast::type key_type_;
   vast::type value_type_;
 };
 
 namespace detail {
 
+/// Checks whether a timestamp type selects the ::time_index, which it does by
+/// means of the `sorted` attribute.
+inline bool has_sorted_attribute(const timestamp_type& t) {
+  auto& attrs = t.attributes();
+  auto pred = [](auto& x) { return x.key == "sorted"; };
+  return std::find_if(attrs.begin(), attrs.end(), pred) != attrs.end();
+}
+
 struct value_index_inspect_helper {
   const vast::type& type;
   std::unique_ptr<value_index>& idx;
@@ -441,7 +815,9 @@ struct value_index_inspect_helper {
       return f_(static_cast<arithmetic_index<timespan>&>(idx_));
     }
 
-    result_type operator()(const timestamp_type&) const {
+    result_type operator()(const timestamp_type& t) const {
+      if (has_sorted_attribute(t))
+        return f_(static_cast<time_index&>(idx_));
       return f_(static_cast<arithmetic_index<timestamp>&>(idx_));
     }
 
@@ -461,6 +837,10 @@ struct value_index_inspect_helper {
       return f_(static_cast<port_index&>(idx_));
     }
 
+    result_type operator()(const enumeration_type&) const {
+      return f_(static_cast<enumeration_index&>(idx_));
+    }
+
     result_type operator()(const vector_type&) const {
       return f_(static_cast<sequence_index&>(idx_));
     }
@@ -469,6 +849,10 @@ struct value_index_inspect_helper {
       return f_(static_cast<sequence_index&>(idx_));
     }
 
+    result_type operator()(const map_type&) const {
+      return f_(static_cast<map_index&>(idx_));
+    }
+
     result_type operator()(const alias_type& t) const {
       return visit(*this, t.value_type);
     }
@@ -505,7 +889,9 @@ struct value_index_inspect_helper {
       return std::make_unique<arithmetic_index<timespan>>();
     }
 
-    result_type operator()(const timestamp_type&) const {
+    result_type operator()(const timestamp_type& t) const {
+      if (has_sorted_attribute(t))
+        return std::make_unique<time_index>();
       return std::make_unique<arithmetic_index<timestamp>>();
     }
 
@@ -525,6 +911,10 @@ struct value_index_inspect_helper {
       return std::make_unique<port_index>();
     }
 
+    result_type operator()(const enumeration_type& t) const {
+      return std::make_unique<enumeration_index>(t);
+    }
+
     result_type operator()(const vector_type&) const {
       return std::make_unique<sequence_index>();
     }
@@ -533,6 +923,10 @@ struct value_index_inspect_helper {
       return std::make_unique<sequence_index>();
     }
 
+    result_type operator()(const map_type&) const {
+      return std::make_unique<map_index>();
+    }
+
     result_type operator()(const alias_type& t) const {
       return visit(*this, t.value_type);
     }
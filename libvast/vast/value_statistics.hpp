@@ -0,0 +1,280 @@
+/******************************************************************************
+ *                    _   _____   __________                                  *
+ *                   | | / / _ | / __/_  __/     Visibility                   *
+ *                   | |/ / __ |_\ \  / /          Across                     *
+ *                   |___/_/ |_/___/ /_/       Space and Time                 *
+ *                                                                            *
+ * This file is part of VAST. It is subject to the license terms in the       *
+ * LICENSE file found in the top-level directory of this distribution and at  *
+ * http://vast.io/license. No part of VAST, including this file, may be       *
+ * copied, modified, propagated, or distributed except according to the terms *
+ * contained in the LICENSE file.                                             *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "vast/operator.hpp"
+
+namespace vast {
+
+/// Estimates the number of distinct elements of a multiset with the
+/// HyperLogLog algorithm. Users add the 64-bit digests of the elements; the
+/// relative standard error of the estimate is about 1.04 / sqrt(2^precision).
+class hyperloglog {
+public:
+  /// The number of hash bits that select a register.
+  static constexpr size_t precision = 10;
+
+  /// The number of registers.
+  static constexpr size_t registers = size_t{1} << precision;
+
+  /// Adds an element.
+  /// @param digest The 64-bit hash value of the element.
+  void add(uint64_t digest);
+
+  /// Merges another estimator such that this one estimates the cardinality
+  /// of the union of both multisets.
+  /// @param other The estimator to merge.
+  void merge(const hyperloglog& other);
+
+  /// @returns The estimated number of distinct elements.
+  double estimate() const;
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, hyperloglog& x) {
+    return f(x.registers_);
+  }
+
+private:
+  // Allocated lazily on the first addition.
+  std::vector<uint8_t> registers_;
+};
+
+/// An equi-depth histogram over a stream of arithmetic values. It maintains a
+/// fixed-size uniform sample of all values seen so far. The sorted sample
+/// partitions the values into buckets that each contain approximately the
+/// same number of values.
+template <class T>
+class equi_depth_histogram {
+public:
+  /// The maximum number of sampled values.
+  static constexpr size_t sample_size = 256;
+
+  /// Adds a value.
+  /// @param x The value to add.
+  void add(T x) {
+    ++size_;
+    if (sample_.size() < sample_size) {
+      sample_.push_back(x);
+    } else {
+      // Reservoir sampling with a stateless, deterministic choice of the slot
+      // to replace, so that a reloaded histogram continues like the original.
+      auto i = mix(size_) % size_;
+      if (i < sample_size)
+        sample_[i] = x;
+    }
+  }
+
+  /// Merges another histogram such that this one summarizes the values of
+  /// both. The merged sample draws from each sample in proportion to the
+  /// number of values it represents.
+  /// @param other The histogram to merge.
+  void merge(const equi_depth_histogram& other) {
+    if (other.size_ == 0)
+      return;
+    auto total = size_ + other.size_;
+    if (sample_.size() + other.sample_.size() <= sample_size) {
+      sample_.insert(sample_.end(), other.sample_.begin(), other.sample_.end());
+    } else {
+      auto n = static_cast<size_t>(sample_size * size_ / total);
+      auto xs = thin(sample_, n);
+      auto ys = thin(other.sample_, sample_size - n);
+      xs.insert(xs.end(), ys.begin(), ys.end());
+      sample_ = std::move(xs);
+    }
+    size_ = total;
+  }
+
+  /// @returns The number of values added.
+  uint64_t size() const {
+    return size_;
+  }
+
+  /// Computes the bucket boundaries.
+  /// @param buckets The number of buckets.
+  /// @returns The `buckets + 1` boundaries where bucket *i* spans the values
+  ///          between boundary *i* and *i + 1*, or an empty vector if the
+  ///          histogram is empty.
+  /// @pre `buckets > 0`
+  std::vector<T> boundaries(size_t buckets) const {
+    std::vector<T> result;
+    if (sample_.empty())
+      return result;
+    auto xs = sorted();
+    result.reserve(buckets + 1);
+    for (size_t i = 0; i < buckets; ++i)
+      result.push_back(xs[i * xs.size() / buckets]);
+    result.push_back(xs.back());
+    return result;
+  }
+
+  /// Estimates the fraction of values that satisfy a relational operator.
+  /// @param op The relational operator.
+  /// @param x The value on the RHS of *op*.
+  /// @returns The estimated fraction in *[0, 1]*, or a negative value if *op*
+  ///          does not apply to arithmetic values.
+  double selectivity(relational_operator op, T x) const {
+    if (sample_.empty())
+      return 0.0;
+    auto xs = sorted();
+    auto n = static_cast<double>(xs.size());
+    // The number of sampled values below and up to x.
+    auto lo = std::lower_bound(xs.begin(), xs.end(), x) - xs.begin();
+    auto hi = std::upper_bound(xs.begin(), xs.end(), x) - xs.begin();
+    switch (op) {
+      default:
+        return -1.0;
+      case less:
+        return lo / n;
+      case less_equal:
+        return hi / n;
+      case greater:
+        return 1.0 - hi / n;
+      case greater_equal:
+        return 1.0 - lo / n;
+      case equal:
+        return (hi - lo) / n;
+      case not_equal:
+        return 1.0 - (hi - lo) / n;
+    }
+  }
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, equi_depth_histogram& x) {
+    return f(x.size_, x.sample_);
+  }
+
+private:
+  static uint64_t mix(uint64_t x) {
+    // The finalizer of SplitMix64.
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+  }
+
+  // Selects n evenly spaced values.
+  static std::vector<T> thin(const std::vector<T>& xs, size_t n) {
+    std::vector<T> result;
+    result.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+      result.push_back(xs[i * xs.size() / n]);
+    return result;
+  }
+
+  std::vector<T> sorted() const {
+    auto xs = sample_;
+    std::sort(xs.begin(), xs.end());
+    return xs;
+  }
+
+  uint64_t size_ = 0;
+  std::vector<T> sample_;
+};
+
+/// Tracks the most frequent values of a stream with the Space-Saving
+/// algorithm. The count of each tracked value overestimates its true
+/// frequency by at most the value's error.
+template <class T>
+class top_k {
+public:
+  /// The maximum number of tracked values.
+  static constexpr size_t capacity = 16;
+
+  /// A tracked value.
+  struct entry {
+    T value;
+    uint64_t frequency;
+    uint64_t error;
+
+    template <class Inspector>
+    friend auto inspect(Inspector& f, entry& x) {
+      return f(x.value, x.frequency, x.error);
+    }
+  };
+
+  /// Adds a value.
+  /// @param x The value to add, which must be comparable with and assignable
+  ///          to `T`.
+  template <class U>
+  void add(const U& x) {
+    auto pred = [&](auto& e) { return e.value == x; };
+    auto i = std::find_if(entries_.begin(), entries_.end(), pred);
+    if (i != entries_.end()) {
+      ++i->frequency;
+    } else if (entries_.size() < capacity) {
+      entries_.push_back({T(x), 1, 0});
+    } else {
+      // Replace the least frequent value, which inherits its count as error.
+      auto cmp = [](auto& a, auto& b) { return a.frequency < b.frequency; };
+      auto min = std::min_element(entries_.begin(), entries_.end(), cmp);
+      min->value = x;
+      min->error = min->frequency;
+      ++min->frequency;
+    }
+  }
+
+  /// Merges another summary such that this one tracks the most frequent
+  /// values of both streams. Counts and errors of values tracked in both
+  /// summaries add up; if more than ::capacity values remain, the least
+  /// frequent ones drop out.
+  /// @param other The summary to merge.
+  void merge(const top_k& other) {
+    for (auto& x : other.entries_) {
+      auto pred = [&](auto& e) { return e.value == x.value; };
+      auto i = std::find_if(entries_.begin(), entries_.end(), pred);
+      if (i != entries_.end()) {
+        i->frequency += x.frequency;
+        i->error += x.error;
+      } else {
+        entries_.push_back(x);
+      }
+    }
+    if (entries_.size() > capacity) {
+      entries_ = entries();
+      entries_.erase(entries_.begin() + capacity, entries_.end());
+    }
+  }
+
+  /// Looks up a tracked value.
+  /// @param x The value to look for, which must be comparable with `T`.
+  /// @returns A pointer to the entry of *x* or `nullptr` if *x* is not among
+  ///          the tracked values.
+  template <class U>
+  const entry* find(const U& x) const {
+    auto pred = [&](auto& e) { return e.value == x; };
+    auto i = std::find_if(entries_.begin(), entries_.end(), pred);
+    return i != entries_.end() ? &*i : nullptr;
+  }
+
+  /// @returns The tracked values in descending order of frequency.
+  std::vector<entry> entries() const {
+    auto result = entries_;
+    auto cmp = [](auto& a, auto& b) { return a.frequency > b.frequency; };
+    std::stable_sort(result.begin(), result.end(), cmp);
+    return result;
+  }
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, top_k& x) {
+    return f(x.entries_);
+  }
+
+private:
+  std::vector<entry> entries_;
+};
+
+} // namespace vast